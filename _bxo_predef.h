@@ -22,6 +22,16 @@
 
 #undef BXO_NB_PREDEFINED
 #define BXO_NB_PREDEFINED  8
+#undef BXO_PREDEF_HASH_BITS
+#define BXO_PREDEF_HASH_BITS  4
+#undef BXO_PREDEF_BUCKET_BITS
+#define BXO_PREDEF_BUCKET_BITS  1
+#undef BXO_PREDEF_ID_DISPL
+#define BXO_PREDEF_ID_DISPL \
+  2, 2,
+#undef BXO_PREDEF_NAME_DISPL
+#define BXO_PREDEF_NAME_DISPL \
+  0, 3,
 /// BXO_HAS_PREDEFINED(Nam,Idstr,Hid,Loid,Hash)
 
 
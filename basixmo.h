@@ -37,6 +37,10 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <random>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
 #include <typeinfo>
 
 // libbacktrace from GCC 6, i.e. libgcc-6-dev package
@@ -49,6 +53,7 @@
 #include <syslog.h>
 #include <stdlib.h>
 #include <dlfcn.h>
+#include <endian.h>
 
 #include <utf8.h>
 
@@ -74,8 +79,8 @@
 #define BXO_MODULEPREFIX "modu_"
 #define BXO_MODULESUFFIX ".so"
 
-class QSqlDatabase;
-class QSqlQuery;
+struct sqlite3;
+class BxoSqlStatement;
 
 // from generated _timestamp.c
 extern "C" const char basixmo_timestamp[];
@@ -161,6 +166,9 @@ extern "C" void bxo_backtracestr_at (const char*fil, int lin, const std::string&
   BXO_BACKTRACELOG_AT_BIS(__FILE__,__LINE__,Log)
 
 extern "C" void bxo_abort(void) __attribute__((noreturn));
+/// flush all output and terminate at once, without destroying the
+/// objects; called after the final dump
+extern "C" void bxo_fast_exit(int status) __attribute__((noreturn));
 #ifndef NDEBUG
 #define BXO_ASSERT_AT(Fil,Lin,Prop,Log) do {    \
  if (BXO_UNLIKELY(!(Prop))) {                   \
@@ -214,6 +222,16 @@ inline std::ostream& operator << (std::ostream& os, const BxoOut& bo)
   return os;
 };
 
+/// bulk UTF-8 validation, skipping ASCII runs 16 bytes at a time
+extern "C" bool bxo_utf8_valid(const char*s, size_t len);
+/// append to buf the escaped form of the valid UTF-8 s; with
+/// BXO_UTF8ESC_JSON the escapes are exactly those of jsoncpp's writers
+#define BXO_UTF8ESC_JSON 1
+void bxo_utf8_escape(std::string&buf, const char*s, size_t len, unsigned flags=0);
+/// base64 with padding, as in RFC 4648, e.g. for binary data inside JSON
+std::string bxo_base64_encode(const void*data, size_t len);
+bool bxo_base64_decode(const std::string&str, std::string&out);
+
 class BxoUtf8Out
 {
   std::string _str;
@@ -221,7 +239,7 @@ class BxoUtf8Out
 public:
   BxoUtf8Out(const std::string&str, unsigned flags=0) : _str(str), _flags(flags)
   {
-    if (!utf8::is_valid(str.begin(), str.end()))
+    if (!bxo_utf8_valid(str.data(), str.size()))
       {
         BXO_BACKTRACELOG("BxoUtf8Out invalid str=" << str);
         throw std::runtime_error("BxoUtf8Out invalid string");
@@ -275,6 +293,8 @@ typedef uint32_t BxoHash_t;
 
 typedef uint32_t Bxo_hid_t;
 typedef uint64_t Bxo_loid_t;
+/// the packed ordering key of an object, its big endian hid then loid
+#define BXO_OBJKEY_SIZE 12
 
 typedef __int128 Bxo_int128_t;
 typedef unsigned __int128 Bxo_uint128_t;
@@ -289,6 +309,10 @@ class BxoDumper;
 class BxoLoader;
 class BxoJsonProcessor;		// abstract "loader"-like
 class BxoJsonEmitter;		// abstract "dumper-like
+class BxoBinaryEncoder;
+class BxoBinaryDecoder;
+class BxoJsonWriter;
+class BxoJsonReader;
 
 #define BXO_DUMP_SCRIPT "basixmo-dump-state.sh"
 
@@ -379,13 +403,55 @@ enum class BxoVKind : std::uint8_t
   ObjectK,
   SetK,
   TupleK,
+  /* immutable packed arrays of int64_t, or of doubles which are never NaN */
+  IntVecK,
+  DoubleVecK,
+  /* immutable binary blobs, usually mapped lazily from a side file */
+  BlobK,
+  /* immutable ropes of UTF-8 text, for big strings edited in place */
+  RopeK,
+  /* immutable maps from objects to non-nil values, as hash array mapped tries */
+  MapK,
   /* we don't need mix (of scalar values, e.g. ints, doubles, strings, objects) at first */
   // MixK,
   /* links (à la symlinks) would be nice, e.g. some indirect reference to an attribute inside an object */
   // LinkK
 };
 
+/// why a non-throwing try_XXX access failed
+enum class BxoAccess : std::uint8_t
+{
+  Ok,
+  NullValue,                    // the value is nil
+  WrongKind,                    // the value is of another kind
+  NoPayload,                    // the object has no payload
+  WrongPayload,                 // the payload is of another kind
+};
+
+/// the result of a try_XXX access, never allocating nor throwing: the
+/// wanted data, or a default (zero or nullptr) with the reason of the
+/// miss
+template <typename T> struct BxoTry
+{
+  T val;
+  BxoAccess err;
+  explicit operator bool () const
+  {
+    return err == BxoAccess::Ok;
+  };
+  bool miss () const
+  {
+    return err != BxoAccess::Ok;
+  };
+};        // end BxoTry
+
 class BxoSequence;
+template <typename NumT> class BxoPackedArray;
+typedef BxoPackedArray<int64_t> BxoIntVec;
+typedef BxoPackedArray<double> BxoDoubleVec;
+class BxoBlob;
+class BxoRope;
+class BxoMap;
 class BxoVal
 {
   /// these classes are subclasses of BxoVal
@@ -395,6 +461,11 @@ class BxoVal
   friend class BxoVObj;
   friend class BxoVSet;
   friend class BxoVTuple;
+  friend class BxoVIntVec;
+  friend class BxoVDoubleVec;
+  friend class BxoVBlob;
+  friend class BxoVRope;
+  friend class BxoVMap;
   /// this is the shared object
   friend class BxoObject;
   /// the dumper
@@ -407,6 +478,11 @@ public:
   struct TagObject {};
   struct TagSet {};
   struct TagTuple {};
+  struct TagIntVec {};
+  struct TagDoubleVec {};
+  struct TagBlob {};
+  struct TagRope {};
+  struct TagMap {};
 protected:
   const BxoVKind _kind;
   union
@@ -417,6 +493,11 @@ protected:
     std::shared_ptr<const BxoString> _str;
     std::shared_ptr<const BxoSet> _set;
     std::shared_ptr<const BxoTuple> _tup;
+    std::shared_ptr<const BxoIntVec> _ivec;
+    std::shared_ptr<const BxoDoubleVec> _dvec;
+    std::shared_ptr<const BxoBlob> _blob;
+    std::shared_ptr<const BxoRope> _rope;
+    std::shared_ptr<const BxoMap> _omap;
   };
   BxoVal(TagNone, std::nullptr_t)
     : _kind(BxoVKind::NoneK), _ptr(nullptr) {};
@@ -430,6 +511,19 @@ protected:
   inline BxoVal(const std::shared_ptr<BxoObject> op, TagObject);
   inline BxoVal(TagSet, const BxoSet*pset);
   inline BxoVal(TagTuple, const BxoTuple*ptup);
+  inline BxoVal(TagIntVec, const BxoIntVec*pivec);
+  inline BxoVal(TagDoubleVec, const BxoDoubleVec*pdvec);
+  inline BxoVal(TagBlob, const BxoBlob*pblob);
+  inline BxoVal(TagRope, const BxoRope*prope);
+  inline BxoVal(TagMap, const BxoMap*pmap);
+  template <typename T> BxoTry<T> try_miss(void) const noexcept
+  {
+    return BxoTry<T> {T{}, (_kind==BxoVKind::NoneK)?BxoAccess::NullValue:BxoAccess::WrongKind};
+  };
+  template <typename T> static BxoTry<T> try_hit(T v) noexcept
+  {
+    return BxoTry<T> {v, BxoAccess::Ok};
+  };
 public:
   BxoVKind kind() const
   {
@@ -463,14 +557,37 @@ public:
     return less_equal(v);
   };
   inline BxoHash_t hash() const;
-  BxoJson to_json(BxoJsonEmitter&) const;
-  void scan_dump(BxoJsonEmitter&) const;
+  /// call f(tag,data) once, with the Tag struct of our kind and our
+  /// data: nullptr for none, the intptr_t, the object shared pointer,
+  /// or a const reference to the string, sequence, vector, blob, rope
+  /// or map. Each overload of f is compiled for its own kind, so the
+  /// only dispatch is the switch on _kind; every overload should give
+  /// the same result type as f(TagNone{},nullptr).
+  template <typename F> inline auto visit(F&&f) const
+  -> decltype(f(TagNone {}, nullptr));
+  /// fill key with a byte string ordered by memcmp like values by
+  /// less, for radix sorting values of any kind. A key longer than
+  /// maxlen is cut and then false is returned; when the common prefix
+  /// of two keys is equal and one is cut, only less can tell.
+#define BXO_SORTKEY_MAX 64
+  bool sort_key(std::string&key, size_t maxlen=BXO_SORTKEY_MAX) const;
+  BxoJson to_json(BxoDumper&) const;
+  /// stream the same JSON as to_json
+  void write_json(BxoJsonWriter&) const;
+  void scan_dump(BxoDumper&) const;
   static BxoVal from_json(BxoJsonProcessor&, const BxoJson&);
+  /// parse the same JSON as from_json, without building it
+  static BxoVal read_json(BxoJsonReader&);
+  void to_binary(BxoBinaryEncoder&) const;
+  static BxoVal from_binary(BxoBinaryDecoder&);
   void out(std::ostream&os) const;
   /// the is_XXX methods are testing the kind
   /// the as_XXX methods may throw an exception
   /// the get_XXX methods may throw an exception or gives a raw non-null ptr
   /// the to_XXX methods make return a default
+  /// the try_as_XXX methods never throw nor allocate, they give a
+  /// BxoTry with a raw pointer or the int, and why they missed; use
+  /// them when a kind mismatch is expected, e.g. when probing kinds
   bool is_null(void) const
   {
     return _kind == BxoVKind::NoneK;
@@ -490,6 +607,11 @@ public:
     return  _kind == BxoVKind::IntK;
   };
   inline intptr_t as_int (void) const;
+  BxoTry<intptr_t> try_as_int(void) const noexcept
+  {
+    if (_kind != BxoVKind::IntK) return try_miss<intptr_t>();
+    return try_hit(_int);
+  };
   inline intptr_t to_int (intptr_t def=0) const
   {
     if (_kind != BxoVKind::IntK) return def;
@@ -503,6 +625,11 @@ public:
   inline std::shared_ptr<const BxoString> as_bstring(void) const;
   inline std::shared_ptr<const BxoString> to_bstring(const std::shared_ptr<const BxoString>& def=nullptr) const;
   inline const BxoString*get_bstring(void) const;
+  BxoTry<const BxoString*> try_as_bstring(void) const noexcept
+  {
+    if (_kind != BxoVKind::StringK) return try_miss<const BxoString*>();
+    return try_hit<const BxoString*>(_str.get());
+  };
   inline std::string as_string(void) const;
   inline std::string to_string(const std::string& str="") const;
   //
@@ -513,6 +640,11 @@ public:
   inline std::shared_ptr<const BxoSet> as_set(void) const;
   inline std::shared_ptr<const BxoSet> to_set(const std::shared_ptr<const BxoSet> def=nullptr) const;
   inline const BxoSet*get_set(void) const;
+  BxoTry<const BxoSet*> try_as_set(void) const noexcept
+  {
+    if (_kind != BxoVKind::SetK) return try_miss<const BxoSet*>();
+    return try_hit<const BxoSet*>(_set.get());
+  };
   //
   bool is_tuple(void) const
   {
@@ -521,6 +653,11 @@ public:
   inline std::shared_ptr<const BxoTuple> as_tuple(void) const;
   inline std::shared_ptr<const BxoTuple> to_tuple(const std::shared_ptr<const BxoTuple> def=nullptr) const;
   inline const BxoTuple*get_tuple(void) const;
+  BxoTry<const BxoTuple*> try_as_tuple(void) const noexcept
+  {
+    if (_kind != BxoVKind::TupleK) return try_miss<const BxoTuple*>();
+    return try_hit<const BxoTuple*>(_tup.get());
+  };
   //
   bool is_sequence(void) const
   {
@@ -529,6 +666,72 @@ public:
   inline std::shared_ptr<const BxoSequence> as_sequence(void) const;
   inline std::shared_ptr<const BxoSequence> to_sequence(const std::shared_ptr<const BxoSequence> def=nullptr) const;
   inline const BxoSequence*get_sequence(void) const;
+  inline BxoTry<const BxoSequence*> try_as_sequence(void) const noexcept;
+  //
+  bool is_intvec(void) const
+  {
+    return _kind == BxoVKind::IntVecK;
+  };
+  inline std::shared_ptr<const BxoIntVec> as_intvec(void) const;
+  inline std::shared_ptr<const BxoIntVec> to_intvec(const std::shared_ptr<const BxoIntVec> def=nullptr) const;
+  inline const BxoIntVec*get_intvec(void) const;
+  BxoTry<const BxoIntVec*> try_as_intvec(void) const noexcept
+  {
+    if (_kind != BxoVKind::IntVecK) return try_miss<const BxoIntVec*>();
+    return try_hit<const BxoIntVec*>(_ivec.get());
+  };
+  //
+  bool is_doublevec(void) const
+  {
+    return _kind == BxoVKind::DoubleVecK;
+  };
+  inline std::shared_ptr<const BxoDoubleVec> as_doublevec(void) const;
+  inline std::shared_ptr<const BxoDoubleVec> to_doublevec(const std::shared_ptr<const BxoDoubleVec> def=nullptr) const;
+  inline const BxoDoubleVec*get_doublevec(void) const;
+  BxoTry<const BxoDoubleVec*> try_as_doublevec(void) const noexcept
+  {
+    if (_kind != BxoVKind::DoubleVecK) return try_miss<const BxoDoubleVec*>();
+    return try_hit<const BxoDoubleVec*>(_dvec.get());
+  };
+  //
+  bool is_blob(void) const
+  {
+    return _kind == BxoVKind::BlobK;
+  };
+  inline std::shared_ptr<const BxoBlob> as_blob(void) const;
+  inline std::shared_ptr<const BxoBlob> to_blob(const std::shared_ptr<const BxoBlob> def=nullptr) const;
+  inline const BxoBlob*get_blob(void) const;
+  BxoTry<const BxoBlob*> try_as_blob(void) const noexcept
+  {
+    if (_kind != BxoVKind::BlobK) return try_miss<const BxoBlob*>();
+    return try_hit<const BxoBlob*>(_blob.get());
+  };
+  //
+  bool is_rope(void) const
+  {
+    return _kind == BxoVKind::RopeK;
+  };
+  inline std::shared_ptr<const BxoRope> as_rope(void) const;
+  inline std::shared_ptr<const BxoRope> to_rope(const std::shared_ptr<const BxoRope> def=nullptr) const;
+  inline const BxoRope*get_rope(void) const;
+  BxoTry<const BxoRope*> try_as_rope(void) const noexcept
+  {
+    if (_kind != BxoVKind::RopeK) return try_miss<const BxoRope*>();
+    return try_hit<const BxoRope*>(_rope.get());
+  };
+  //
+  bool is_omap(void) const
+  {
+    return _kind == BxoVKind::MapK;
+  };
+  inline std::shared_ptr<const BxoMap> as_omap(void) const;
+  inline std::shared_ptr<const BxoMap> to_omap(const std::shared_ptr<const BxoMap> def=nullptr) const;
+  inline const BxoMap*get_omap(void) const;
+  BxoTry<const BxoMap*> try_as_omap(void) const noexcept
+  {
+    if (_kind != BxoVKind::MapK) return try_miss<const BxoMap*>();
+    return try_hit<const BxoMap*>(_omap.get());
+  };
   //
   bool is_object(void) const
   {
@@ -539,6 +742,15 @@ public:
   inline BxoObject* get_object(void) const;
   inline BxoObject* as_objptr(void) const;
   inline BxoObject* to_objptr(BxoObject*defobp=nullptr) const;
+  BxoTry<BxoObject*> try_as_objptr(void) const noexcept
+  {
+    if (_kind != BxoVKind::ObjectK) return try_miss<BxoObject*>();
+    return try_hit(_obj.get());
+  };
+  /// for a set or a tuple, its slice from index from to index to
+  /// (excluded), indexes being like for BxoSequence::at; the
+  /// components are shared, not copied. Otherwise nil.
+  inline BxoVal slice(int from, int to) const;
 };        // end class BxoVal
 
 
@@ -617,6 +829,54 @@ public:
   }) {};
 };        // end BxoVTuple
 
+class BxoVIntVec: public BxoVal
+{
+public:
+  ~BxoVIntVec() = default;
+  inline BxoVIntVec(const BxoIntVec&);
+  BxoVIntVec(const int64_t*arr, unsigned len);
+  BxoVIntVec(const std::vector<int64_t>&vec);
+  BxoVIntVec(std::initializer_list<int64_t> il)
+    : BxoVIntVec(std::vector<int64_t>(il)) {};
+};        // end BxoVIntVec
+
+class BxoVDoubleVec: public BxoVal
+{
+public:
+  ~BxoVDoubleVec() = default;
+  inline BxoVDoubleVec(const BxoDoubleVec&);
+  BxoVDoubleVec(const double*arr, unsigned len);
+  BxoVDoubleVec(const std::vector<double>&vec);
+  BxoVDoubleVec(std::initializer_list<double> il)
+    : BxoVDoubleVec(std::vector<double>(il)) {};
+};        // end BxoVDoubleVec
+
+class BxoVBlob: public BxoVal
+{
+public:
+  ~BxoVBlob() = default;
+  inline BxoVBlob(const BxoBlob&);
+  BxoVBlob(const void*data, size_t size);
+  BxoVBlob(const std::string&bytes)
+    : BxoVBlob(bytes.data(), bytes.size()) {};
+};        // end BxoVBlob
+
+class BxoVRope: public BxoVal
+{
+public:
+  ~BxoVRope() = default;
+  inline BxoVRope(const BxoRope&);
+  BxoVRope(const std::string&str);
+};        // end BxoVRope
+
+class BxoVMap: public BxoVal
+{
+public:
+  ~BxoVMap() = default;
+  inline BxoVMap(const BxoMap&);
+  BxoVMap(const std::vector<std::pair<std::shared_ptr<BxoObject>,BxoVal>>&pairs);
+};        // end BxoVMap
+
 
 
 
@@ -630,6 +890,95 @@ public:
 };        // end BxoVObj
 
 
+/// a streaming JSON writer into a reusable buffer, building no
+/// Json::Value. In canonical mode it writes exactly what
+/// Json::StyledWriter writes, in compact mode what Json::FastWriter
+/// writes; so object members should come in ascending key order, as
+/// a Json::Value sorts them.
+class BxoJsonWriter
+{
+public:
+  enum JwMode { JwCanonical, JwCompact };
+private:
+  struct JwFrame
+  {
+    bool jf_object;
+    bool jf_open;               // its "[" or "{" is written
+    bool jf_inline;             // a canonical array kept on one line
+    unsigned jf_count;          // its elements or members so far
+    size_t jf_start;            // where an inline array starts
+  };
+  const JwMode _jw_mode;
+  BxoDumper* _jw_dumper;	// for dumpability and blob side files, may be null
+  std::string _jw_buf;
+  std::vector<JwFrame> _jw_frames;
+  /// the start of each element of the inline array, at most one
+  std::vector<size_t> _jw_inlineoffs;
+  static constexpr unsigned _right_margin_ = 74;
+  static constexpr unsigned _indent_size_ = 3;
+  void put_indent(size_t level)
+  {
+    _jw_buf.push_back('\n');
+    _jw_buf.append(level*_indent_size_, ' ');
+  };
+  void open_frame(size_t frix, bool flat);
+  void before_value(size_t frix, bool flat);
+  void after_flat_value(void);
+  void break_inline(JwFrame&fr, size_t level);
+  void put_quoted(const char*s, size_t ln);
+public:
+  BxoJsonWriter(JwMode mode=JwCanonical, BxoDumper*du=nullptr)
+    : _jw_mode(mode), _jw_dumper(du), _jw_buf(), _jw_frames(), _jw_inlineoffs() {};
+  BxoJsonWriter(const BxoJsonWriter&) = delete;
+  BxoDumper* dumper() const
+  {
+    return _jw_dumper;
+  };
+  JwMode mode() const
+  {
+    return _jw_mode;
+  };
+  /// without dumper, every object is dumpable
+  bool is_dumpable(BxoObject*pob) const;
+  bool is_dumpable(const std::shared_ptr<BxoObject>&obp) const
+  {
+    return is_dumpable(obp.get());
+  };
+  void begin_array(void);
+  void end_array(void);
+  void begin_object(void);
+  void end_object(void);
+  /// the key of the next member of the current object
+  void key(const char*k, size_t ln);
+  void key(const char*k)
+  {
+    key(k, strlen(k));
+  };
+  void put_null(void);
+  void put_bool(bool b);
+  void put_int(int64_t i);
+  void put_uint(uint64_t u);
+  void put_double(double d);
+  void put_string(const char*s, size_t ln);
+  void put_string(const std::string&s)
+  {
+    put_string(s.data(), s.size());
+  };
+  void put_objid(const BxoObject*pob);
+  /// write a whole Json::Value, for emitters not streaming yet
+  void put_json(const BxoJson&js);
+  /// end the document with a newline like the Json writers, swap
+  /// it into dest, and get ready for the next one
+  void finish_into(std::string&dest);
+  void clear(void)
+  {
+    _jw_buf.clear();
+    _jw_frames.clear();
+    _jw_inlineoffs.clear();
+  };
+};        // end class BxoJsonWriter
+
+
 class BxoJsonEmitter {
 };				// end class BxoJsonEmitter
 
@@ -643,20 +992,75 @@ class BxoDumper : public BxoJsonEmitter
          InsobPaylkindIx, InsobPaylcontIx, InsobPaylmodIx,
          Insob_LastIx
        };
-  QSqlQuery* _du_queryinsobj;
-  QSqlDatabase* _du_sqldb;
+  BxoSqlStatement* _du_queryinsobj;
+  sqlite3* _du_sqldb;
   enum { DuStop, DuScan, DuEmit } _du_state;
   double _du_startelapsedtime;
   double _du_startprocesstime;
   std::string _du_dirname;
   std::string _du_tempsuffix;
-  std::unordered_set<BxoObject*,BxoHashObjPtr> _du_objset;
+  /// the stamp of the objects reached by this dump, unique among dumps
+  uint32_t _du_epoch;
+  /// every reached object, in scanning order
+  std::vector<BxoObject*> _du_objvec;
   std::set<std::string> _du_outfilset;
-  std::deque<std::shared_ptr<BxoObject>> _du_scanque;
+  std::map<std::string,std::shared_ptr<const BxoBlob>> _du_blobmap;
+  /// a scanning thread of scan_all; it pops the objects to scan
+  /// from the back of its deque, and when idle steals from the front
+  /// of the deques of other workers
+  struct ScanWorker
+  {
+    /// the rank in _du_scanworkers
+    unsigned sw_index;
+    std::mutex sw_mtx;
+    std::deque<BxoObject*> sw_deque;
+    /// the objects first marked by this worker
+    std::vector<BxoObject*> sw_marked;
+    unsigned long sw_nbscan;
+  };
+  std::vector<std::unique_ptr<ScanWorker>> _du_scanworkers;
+  /// the number of marked objects not yet scanned
+  std::atomic<long> _du_scanpending;
+  /// idle workers with nothing to steal wait on _du_scanidlecond until
+  /// _du_scanpushes changes or nothing is pending any more
+  std::mutex _du_scanidlemtx;
+  std::condition_variable _du_scanidlecond;
+  std::atomic<unsigned> _du_scanidle;
+  std::atomic<unsigned long> _du_scanpushes;
+  std::mutex _du_todomtx;
   std::deque<std::pair<std::function<void(BxoDumper&,BxoVal)>,BxoVal>> _du_todoafterscan;
+  static thread_local ScanWorker* _curscanworker_;
+  static std::atomic<uint32_t> _lastdumpepoch_;
   static std::string _defaultdumpdir_;
+  static bool _binarycontent_;
+  static unsigned _commitrows_;
+  static unsigned _dumpjobs_;
+  static bool _compactjson_;
+  BxoObject* steal_scan(ScanWorker*sw);
+  void scan_worker_loop(ScanWorker*sw);
+  void scan_wake_idle(void);
+  void scan_done_one(void);
+  /// the texts of a t_objects row, built by build_object_row maybe
+  /// in a worker thread, then inserted by insert_object_row
+  struct ObjectRow
+  {
+    BxoObject* or_obj;
+    int64_t or_mtime;
+    bool or_paylbinary;
+    std::string or_idstr, or_contstr, or_classidstr;
+    std::string or_paylkidstr, or_paylcontstr, or_paylmodstr;
+    std::shared_ptr<BxoObject> or_modob;
+  };
+  typedef std::vector<std::pair<Bxo_uint128_t,BxoObject*>> sorted_objects_t;
+  static constexpr unsigned _emit_chunk_rows_ = 1024;
+  std::mutex _du_blobmtx;
+  void build_object_row(BxoObject*pob, ObjectRow&row, BxoJsonWriter&jw);
+  void insert_object_row(const ObjectRow&row);
+  void emit_rows_parallel(const sorted_objects_t&sortedobvec,
+                          const std::function<void(const ObjectRow&)>&insertfun);
   static std::string generate_temporary_suffix(void);
   void rename_temporary(const std::string&filpath);
+  bool exec_sql(const char*sql);
 public:
   // given a relative filpath, register it and generate it pristine
   // variant with the temporary suffix
@@ -670,32 +1074,78 @@ public:
   {
     return _defaultdumpdir_;
   };
+  /// dump the object and payload contents in the binary encoding,
+  /// not as JSON text
+  static void set_binary_content(bool b)
+  {
+    _binarycontent_ = b;
+  };
+  static bool binary_content(void)
+  {
+    return _binarycontent_;
+  };
+  /// commit the emitted rows every that many objects, or only once
+  /// at the end if 0
+  static void set_commit_rows(unsigned n)
+  {
+    _commitrows_ = n;
+  };
+  static unsigned commit_rows(void)
+  {
+    return _commitrows_;
+  };
+  /// dump the JSON contents on a single line, like Json::FastWriter,
+  /// not indented like Json::StyledWriter
+  static void set_compact_json(bool b)
+  {
+    _compactjson_ = b;
+  };
+  static bool compact_json(void)
+  {
+    return _compactjson_;
+  };
+  static BxoJsonWriter::JwMode json_writer_mode(void)
+  {
+    return _compactjson_ ? BxoJsonWriter::JwCompact : BxoJsonWriter::JwCanonical;
+  };
+  /// scan the object graph in that many threads, the dumping one
+  /// included; and if more than one, serialize the object rows in
+  /// that many worker threads
+  static void set_dump_jobs(unsigned n)
+  {
+    _dumpjobs_ = (n>0)?n:1;
+  };
+  static unsigned dump_jobs(void)
+  {
+    return _dumpjobs_;
+  };
   BxoDumper(const std::string&dir = ".");
   ~BxoDumper();
   BxoDumper(const BxoDumper&) = delete;
   BxoDumper(BxoDumper&&) = delete;
   void scan_all(void);
+  void tune_database(void);
   void initialize_data_schema(void);
+  void finalize_data_schema(void);
   void emit_all(void);
   void full_dump(void);
   void do_after_scan(std::function<void(BxoDumper&,BxoVal)> f, BxoVal v)
   {
     BXO_ASSERT(_du_state == DuScan, "non-scan state for do_after_scan");
+    std::lock_guard<std::mutex> gu(_du_todomtx);
     _du_todoafterscan.push_back({f,v});
   }
-  // emit the object, and return its module if any
-  std::shared_ptr<BxoObject> emit_object_row_module(BxoObject*pob);
-  bool is_dumpable(BxoObject*pob)
-  {
-    return pob && _du_objset.find(pob) != _du_objset.end();
-  };
-  bool is_dumpable(std::shared_ptr<BxoObject> obp)
+  inline bool is_dumpable(BxoObject*pob) const;
+  bool is_dumpable(const std::shared_ptr<BxoObject>& obp) const
   {
-    return obp && is_dumpable(obp.get());
+    return is_dumpable(obp.get());
   }
   bool scan_dumpable(BxoObject*); // return true if the object is
-  // dumpable, and add it to the
-  // dumpobset
+  // dumpable, and mark it for scanning;
+  // may run in any scanning thread
+  // write the side file of a blob if needed, and return its file name;
+  // may run in any emitting thread
+  std::string emit_blob(const BxoBlob&blob);
 };        // end class BxoDumper
 
 
@@ -709,6 +1159,12 @@ protected:
   virtual ~BxoJsonProcessor() {};
 public:
   virtual  BxoObject* obj_from_idstr(const std::string&) =0;
+  virtual BxoObject* obj_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid);
+  // the path of a side file, e.g. of a blob, named in the JSON
+  virtual std::string side_file_path(const std::string&filnam)
+  {
+    return filnam;
+  };
   BxoVal val_from_json(const BxoJson&js)
   {
     return BxoVal::from_json(*this,js);
@@ -720,12 +1176,52 @@ class BxoLoader : public BxoJsonProcessor
 {
   friend class BxoObject;
   std::string _ld_dirname;
-  QSqlDatabase* _ld_sqldb;
+  sqlite3* _ld_sqldb;
   double _ld_startelapsedtime;
   double _ld_startprocesstime;
-  std::unordered_map<std::string,std::shared_ptr<BxoObject>> _ld_idtoobjmap;
+  /// the loaded objects are keyed by hid and loid, so ids parsed in
+  /// place are found without building their string
+  typedef std::pair<Bxo_hid_t,Bxo_loid_t> IdKey;
+  struct IdKeyHash
+  {
+    size_t operator() (const IdKey&k) const
+    {
+      return (size_t)(k.second ^ ((Bxo_loid_t)k.first << 29));
+    };
+  };
+  std::unordered_map<IdKey,std::shared_ptr<BxoObject>,IdKeyHash> _ld_idtoobjmap;
+  /// a row of t_objects, as staged by read_objects; its texts are
+  /// byte ranges inside the sb_bytes of its batch
+  struct StagedRow
+  {
+    BxoObject* sr_obj;
+    double sr_mtime;
+    size_t sr_jsoncont, sr_classid, sr_paylkid, sr_paylcont;
+    uint32_t sr_jsoncontlen, sr_classidlen, sr_paylkidlen, sr_paylcontlen;
+  };
+  /// consecutive staged rows; with several load jobs, the contents
+  /// of distinct batches are filled by distinct threads
+  struct StagedBatch
+  {
+    std::vector<StagedRow> sb_rows;
+    std::string sb_bytes;
+    const char* staged_ptr(size_t off) const
+    {
+      return sb_bytes.data()+off;
+    };
+    std::string staged_string(size_t off, uint32_t len) const
+    {
+      return std::string(sb_bytes.data()+off, len);
+    };
+  };
+  static constexpr unsigned _batch_rows_ = 2048;
+  static unsigned _loadjobs_;
+  std::vector<std::unique_ptr<StagedBatch>> _ld_batches;
+  static size_t stage_bytes(StagedBatch&sb, const char*ptr, size_t len, uint32_t&rlen);
+  void fill_batch_contents(StagedBatch&sb);
+  void load_params(void);
   void bind_predefined(void);
-  void create_objects(void);
+  void read_objects(void);
   void set_globals(void);
   void name_objects(void);
   void name_predefined(void);
@@ -734,28 +1230,294 @@ class BxoLoader : public BxoJsonProcessor
   void load_objects_class(void);
   void load_objects_create_payload(void);
   void load_objects_fill_payload(void);
-  std::shared_ptr<BxoObject> name_the_predefined(const std::string&nam, const std::string&idstr);
 protected:
-  void register_objref(const std::string&,std::shared_ptr<BxoObject> obp);
+  void register_objref(std::shared_ptr<BxoObject> obp);
 public:
   BxoLoader(const std::string dirname=".");
   ~BxoLoader();
+  /// fill the object contents in that many threads, once every
+  /// object is created; 1 fills them in the caller
+  static void set_load_jobs(unsigned n)
+  {
+    _loadjobs_ = (n>0)?n:1;
+  };
+  static unsigned load_jobs(void)
+  {
+    return _loadjobs_;
+  };
   void load(void);
-  std::shared_ptr<BxoObject> find_loadedobj(const std::string& str)
+  std::shared_ptr<BxoObject> find_loadedobj(Bxo_hid_t hid, Bxo_loid_t loid)
   {
-    auto it = _ld_idtoobjmap.find(str);
+    auto it = _ld_idtoobjmap.find(IdKey {hid,loid});
     if (it != _ld_idtoobjmap.end())
       return it->second;
     return nullptr;
   }
+  std::shared_ptr<BxoObject> find_loadedobj(const std::string& str);
+  /// like find_loadedobj, but tries first the predefined ids, for
+  /// references which are usually predefined, e.g. payload kinds
+  inline std::shared_ptr<BxoObject> find_loaded_predefobj(const std::string& str);
   BxoObject* obj_from_idstr(const std::string&);
   BxoObject* obj_from_idstr(const char*cs)
   {
     return obj_from_idstr(std::string(cs));
   };
+  BxoObject* obj_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid);
+  /// read an {"at":...,"va":...} entry of attrs in an object content,
+  /// or of the like in a payload; false if it is skipped, as an
+  /// attribute not loaded
+  bool read_attribute(BxoJsonReader&jr, std::shared_ptr<BxoObject>&pobat, BxoVal&val);
+  std::string side_file_path(const std::string&filnam)
+  {
+    return _ld_dirname + "/" + filnam;
+  };
 };        // end BxoLoader
 
 
+/// a compact self-describing binary encoding of values, of object
+/// contents and of JSON documents, an alternative to the JSON text
+/// in the dump. An encoding starts with the magic byte, the format
+/// version and the table of the referenced object ids (hid and loid,
+/// 12 bytes each), then values refer to their objects by rank in that
+/// table. Ints and lengths are LEB128 varints (zigzag for signed
+/// ones), strings are length-prefixed, sets and tuples are counted.
+#define BXO_BINARY_MAGIC 0xb7	/* can start neither JSON nor UTF-8 */
+#define BXO_BINARY_VERSION 1
+class BxoBinaryEncoder
+{
+  BxoDumper* _be_dumper;	// for dumpability and blob side files, may be null
+  std::string _be_body;
+  std::vector<BxoObject*> _be_idvec;
+  std::unordered_map<BxoObject*,unsigned,BxoHashObjPtr> _be_idmap;
+public:
+  /// one byte tags, for values then for JSON documents
+  enum BinTag : uint8_t
+  {
+    BinNone=0, BinInt, BinString, BinObject, BinSet, BinTuple,
+    BinIntVec, BinDoubleVec, BinBlob, BinBlobFile, BinRope, BinMap,
+    BinJsNull=0x20, BinJsFalse, BinJsTrue, BinJsInt, BinJsUInt, BinJsDouble,
+    BinJsString, BinJsArray, BinJsObject
+  };
+  BxoBinaryEncoder(BxoDumper*du=nullptr)
+    : _be_dumper(du), _be_body(), _be_idvec(), _be_idmap() {};
+  BxoBinaryEncoder(const BxoBinaryEncoder&) = delete;
+  BxoDumper* dumper() const
+  {
+    return _be_dumper;
+  };
+  /// without dumper, every object is dumpable
+  bool is_dumpable(BxoObject*pob) const;
+  bool is_dumpable(const std::shared_ptr<BxoObject>&obp) const
+  {
+    return is_dumpable(obp.get());
+  };
+  void put_byte(uint8_t b)
+  {
+    _be_body.push_back((char)b);
+  };
+  void put_varint(uint64_t u)
+  {
+    while (u >= 0x80)
+      {
+        _be_body.push_back((char)((u & 0x7f) | 0x80));
+        u >>= 7;
+      }
+    _be_body.push_back((char)u);
+  };
+  void put_zigzag(int64_t i)
+  {
+    put_varint(((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+  };
+  void put_raw(const void*ptr, size_t ln)
+  {
+    _be_body.append((const char*)ptr, ln);
+  };
+  void put_bytes(const char*s, size_t ln)
+  {
+    put_varint(ln);
+    put_raw(s, ln);
+  };
+  void put_bytes(const std::string&s)
+  {
+    put_bytes(s.data(), s.size());
+  };
+  void put_double(double d);
+  /// the rank of a dumpable object in the id table
+  void put_objref(BxoObject*pob);
+  void put_json(const BxoJson&js);
+  /// the whole encoding, with its header and id table
+  std::string finish(void) const;
+};        // end class BxoBinaryEncoder
+
+
+class BxoBinaryDecoder
+{
+  BxoJsonProcessor& _bd_proc;
+  const unsigned char* _bd_cur;
+  const unsigned char* _bd_end;
+  std::vector<BxoObject*> _bd_idvec;	// null for unknown ids
+public:
+  [[noreturn]] void fail(const char*why) const;
+  static bool is_binary(const char*buf, size_t sz)
+  {
+    return sz > 0 && (unsigned char)buf[0] == BXO_BINARY_MAGIC;
+  };
+  /// parse the header and the id table of buf, which should outlive the decoder
+  BxoBinaryDecoder(BxoJsonProcessor&proc, const char*buf, size_t sz);
+  BxoBinaryDecoder(const BxoBinaryDecoder&) = delete;
+  BxoJsonProcessor& processor() const
+  {
+    return _bd_proc;
+  };
+  bool at_end(void) const
+  {
+    return _bd_cur >= _bd_end;
+  };
+  uint8_t get_byte(void)
+  {
+    if (BXO_UNLIKELY(_bd_cur >= _bd_end))
+      fail("truncated");
+    return *_bd_cur++;
+  };
+  uint64_t get_varint(void)
+  {
+    uint64_t u = 0;
+    for (unsigned sh = 0; sh < 64; sh += 7)
+      {
+        uint8_t b = get_byte();
+        u |= (uint64_t)(b & 0x7f) << sh;
+        if (!(b & 0x80))
+          return u;
+      }
+    fail("overlong varint");
+  };
+  /// a count of elements, each taking at least one byte
+  size_t get_count(void)
+  {
+    uint64_t n = get_varint();
+    if (BXO_UNLIKELY(n > (uint64_t)(_bd_end - _bd_cur)))
+      fail("bad count");
+    return (size_t)n;
+  };
+  int64_t get_zigzag(void)
+  {
+    uint64_t u = get_varint();
+    return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+  };
+  /// the next ln raw bytes, inside the buffer
+  const char* get_raw(size_t ln)
+  {
+    if (BXO_UNLIKELY(ln > (size_t)(_bd_end - _bd_cur)))
+      fail("truncated bytes");
+    const char*p = (const char*)_bd_cur;
+    _bd_cur += ln;
+    return p;
+  };
+  /// a length-prefixed byte string
+  const char* get_bytes(size_t&ln)
+  {
+    ln = get_varint();
+    return get_raw(ln);
+  };
+  double get_double(void);
+  /// the referenced object, or null if its id is unknown
+  BxoObject* get_objref(void);
+  BxoJson get_json(void);
+};        // end class BxoBinaryDecoder
+
+
+/// a pull parser of the JSON texts of object and payload contents,
+/// reading them in place from a buffer which should outlive it. The
+/// callers walk the expected shape, e.g. begin_object then next_key
+/// and a value till next_key gives false, and build their values
+/// directly; unescaped strings, keys and ids are not copied. Where
+/// the text has another shape, they may go back to a mark and take
+/// the value with get_json, as a Json::Value.
+class BxoJsonReader
+{
+  BxoJsonProcessor& _jr_proc;
+  const char* const _jr_start;
+  const char* _jr_cur;
+  const char* const _jr_end;
+  /// the last key, in place or in _jr_strbuf
+  const char* _jr_key;
+  size_t _jr_keylen;
+  /// just after an opening brace or bracket, so no comma is expected
+  bool _jr_opened;
+  /// the unescaped last string or key, when it had escapes
+  std::string _jr_strbuf;
+  static constexpr unsigned _max_depth_ = 1000;
+  void skip_spaces(void)
+  {
+    while (_jr_cur < _jr_end
+           && (*_jr_cur == ' ' || *_jr_cur == '\n' || *_jr_cur == '\t' || *_jr_cur == '\r'))
+      _jr_cur++;
+  };
+  void expect_literal(const char*lit, size_t ln);
+  void unescape_string(const char*&s, size_t&ln);
+  bool next_separator(char closing);
+  void skip_nested(unsigned depth);
+public:
+  [[noreturn]] void fail(const char*why) const;
+  BxoJsonReader(BxoJsonProcessor&proc, const char*buf, size_t sz)
+    : _jr_proc(proc), _jr_start(buf), _jr_cur(buf), _jr_end(buf+sz),
+      _jr_key(nullptr), _jr_keylen(0), _jr_opened(false), _jr_strbuf() {};
+  BxoJsonReader(const BxoJsonReader&) = delete;
+  BxoJsonProcessor& processor() const
+  {
+    return _jr_proc;
+  };
+  /// the first byte of the next value, or 0 at the end
+  char peek(void)
+  {
+    skip_spaces();
+    return (_jr_cur < _jr_end) ? *_jr_cur : 0;
+  };
+  bool at_end(void)
+  {
+    skip_spaces();
+    return _jr_cur >= _jr_end;
+  };
+  /// a mark before the next value, to go back to it
+  const char* mark(void)
+  {
+    skip_spaces();
+    return _jr_cur;
+  };
+  void reset(const char*mk)
+  {
+    BXO_ASSERT(mk >= _jr_start && mk <= _jr_end, "bad JSON reader mark");
+    _jr_cur = mk;
+    _jr_opened = false;
+  };
+  void begin_object(void);
+  /// read the key of the next member and its colon, or the closing
+  /// brace and give false
+  bool next_key(void);
+  bool key_is(const char*lit) const
+  {
+    return strlen(lit) == _jr_keylen && !memcmp(_jr_key, lit, _jr_keylen);
+  };
+  void begin_array(void);
+  /// move to the next element, or read the closing bracket and give false
+  bool next_element(void)
+  {
+    return next_separator(']');
+  };
+  void get_null(void);
+  int64_t get_int(void);
+  /// the string is valid till the next string or key
+  void get_string(const char*&s, size_t&ln);
+  /// read a string, true with its hid and loid if it is an object id
+  bool get_id(Bxo_hid_t&hid, Bxo_loid_t&loid);
+  void skip_value(void)
+  {
+    skip_nested(0);
+  };
+  BxoJson get_json(void);
+};        // end class BxoJsonReader
+
+
 
 class BxoSequence : public std::enable_shared_from_this<BxoSequence>
 {
@@ -763,8 +1525,15 @@ protected:
   const BxoHash_t _hash;
   const unsigned _len;
   std::shared_ptr<BxoObject> *_seq;
+  /// the packed ordering keys of the components, BXO_OBJKEY_SIZE bytes
+  /// each, so comparing two sequences is a single memcmp
+  const unsigned char* _keys;
+  /// for a slice, the sequence owning the _seq and _keys arrays, kept
+  /// alive; null if this sequence owns them
+  const std::shared_ptr<const BxoSequence> _seqowner;
+  inline void fill_keys(void);
   BxoSequence(BxoHash_t h, unsigned len, const std::shared_ptr<BxoObject> *seq)
-    : _hash(h), _len(len), _seq(new std::shared_ptr<BxoObject>[len])
+    : _hash(h), _len(len), _seq(new std::shared_ptr<BxoObject>[len]), _keys(nullptr), _seqowner(nullptr)
   {
     for (unsigned ix=0; ix<len; ix++)
       {
@@ -772,6 +1541,53 @@ protected:
         BXO_ASSERT(comp, "nil comp#" << ix);
         _seq[ix] = comp;
       }
+    fill_keys();
+  }
+  // the concatenation of two component arrays
+  BxoSequence(BxoHash_t h, const std::shared_ptr<BxoObject> *lseq, unsigned llen,
+              const std::shared_ptr<BxoObject> *rseq, unsigned rlen)
+    : _hash(h), _len(llen+rlen), _seq(new std::shared_ptr<BxoObject>[llen+rlen]), _keys(nullptr), _seqowner(nullptr)
+  {
+    std::copy(lseq, lseq+llen, _seq);
+    std::copy(rseq, rseq+rlen, _seq+llen);
+    fill_keys();
+  }
+  struct SliceTag {};
+  /// a slice shares the components of its parent, without copying them
+  BxoSequence(SliceTag, BxoHash_t h, const std::shared_ptr<const BxoSequence>&parent, unsigned off, unsigned len)
+    : _hash(h), _len(len), _seq(parent->_seq+off), _keys(parent->_keys+off*BXO_OBJKEY_SIZE),
+      _seqowner(parent->_seqowner?parent->_seqowner:parent)
+  {
+    BXO_ASSERT(off+len <= parent->_len, "bad slice off=" << off << " len=" << len
+               << " of parent length " << parent->_len);
+  }
+  ~BxoSequence()
+  {
+    if (!_seqowner)
+      {
+        delete[] _seq;
+        delete[] _keys;
+      }
+    _seq = nullptr;
+    _keys = nullptr;
+  }
+  BxoSequence(const BxoSequence&) = delete;
+  BxoSequence(BxoSequence&&) = delete;
+  template <class Combiner>
+  static BxoHash_t fold_hash(BxoHash_t h, const std::shared_ptr<BxoObject>*seq, unsigned len, Combiner comb)
+  {
+    for (unsigned ix=0; ix<len; ix++)
+      h = comb(h, *seq[ix]);
+    return h;
+  }
+  // normalize from & to slice indexes like for at(); to is excluded
+  void slice_bounds(int& from, int& to) const
+  {
+    if (from<0) from += _len;
+    if (to<0) to += _len;
+    if (from<0) from = 0;
+    if (to>(int)_len) to = _len;
+    if (to<from) to = from;
   }
   bool same_sequence(const BxoSequence&r) const
   {
@@ -782,15 +1598,38 @@ protected:
         return false;
     return true;
   }
-  inline bool less_than_sequence(const BxoSequence&r) const;
+  /// like memcmp on the keys, comparing the components in order; most
+  /// comparisons end at the first word, so words are compared inline
+  int compare_sequence(const BxoSequence&r) const
+  {
+    if (this == &r) return 0;
+    unsigned minlen = (_len < r._len)?_len:r._len;
+    size_t nbytes = (size_t)minlen*BXO_OBJKEY_SIZE;
+    size_t ix = 0;
+    for (; ix+sizeof(uint64_t) <= nbytes; ix += sizeof(uint64_t))
+      {
+        uint64_t lw, rw;
+        memcpy(&lw, _keys+ix, sizeof(lw));
+        memcpy(&rw, r._keys+ix, sizeof(rw));
+        if (lw != rw)
+          return (be64toh(lw) < be64toh(rw))?-1:1;
+      }
+    for (; ix < nbytes; ix++)
+      if (_keys[ix] != r._keys[ix])
+        return (_keys[ix] < r._keys[ix])?-1:1;
+    return (_len < r._len)?-1:(_len > r._len)?1:0;
+  }
+  bool less_than_sequence(const BxoSequence&r) const
+  {
+    return compare_sequence(r) < 0;
+  }
   bool less_equal_sequence(const BxoSequence&r) const
   {
-    if (BXO_UNLIKELY(_hash == r._hash))
-      if (same_sequence(r)) return true;
-    return less_than_sequence(r);
+    return compare_sequence(r) <= 0;
   }
-  BxoJson sequence_to_json(BxoDumper&) const;
 public:
+  BxoJson sequence_to_json(BxoDumper&) const;
+  void sequence_write_json(BxoJsonWriter&) const;
   std::shared_ptr<BxoObject> *begin() const
   {
     return _len?_seq:nullptr;
@@ -805,6 +1644,11 @@ public:
     if (rk>=0 && rk<(int)_len) return _seq[rk];
     return nullptr;
   }
+  /// the packed ordering keys, length()*BXO_OBJKEY_SIZE bytes
+  const unsigned char* keys() const
+  {
+    return _keys;
+  };
   BxoHash_t hash()const
   {
     return _hash;
@@ -824,6 +1668,10 @@ public:
       }
   }
   inline void sequence_scan_dump(BxoDumper&) const;
+  bool is_slice() const
+  {
+    return _seqowner != nullptr;
+  };
 };        // end class BxoSequence
 
 
@@ -844,8 +1692,14 @@ class BxoSet : public BxoSequence
   static const BxoSet*make_set(const std::vector<BxoObject*> &vec);
   BxoSet(BxoHash_t h, unsigned len, const std::shared_ptr<BxoObject> * seq)
     : BxoSequence(h, len, seq) {};
+  BxoSet(SliceTag tg, BxoHash_t h, const std::shared_ptr<const BxoSet>&parent, unsigned off, unsigned len)
+    : BxoSequence(tg, h, parent, off, len) {};
 public:
   static const BxoSet*load_set(BxoJsonProcessor&, const BxoJson&);
+  /// a contiguous range of a sorted set is a set, so slices of sets
+  /// are sets sharing the components of their parent
+  static const BxoSet*make_slice(const std::shared_ptr<const BxoSet>&pset, int from, int to);
+  static const BxoSet*make_union(const BxoSet&lset, const BxoSet&rset);
   bool same_set(const BxoSet& r) const
   {
     return same_sequence(r);
@@ -871,6 +1725,11 @@ class BxoTuple : public BxoSequence
   static const BxoTuple*make_tuple(const std::vector<BxoObject*>&vec);
   BxoTuple(BxoHash_t h, unsigned len, const std::shared_ptr<BxoObject> * seq)
     : BxoSequence(h, len, seq) {};
+  BxoTuple(BxoHash_t h, const std::shared_ptr<BxoObject> *lseq, unsigned llen,
+           const std::shared_ptr<BxoObject> *rseq, unsigned rlen)
+    : BxoSequence(h, lseq, llen, rseq, rlen) {};
+  BxoTuple(SliceTag tg, BxoHash_t h, const std::shared_ptr<const BxoTuple>&parent, unsigned off, unsigned len)
+    : BxoSequence(tg, h, parent, off, len) {};
   static constexpr BxoHash_t init_hash = 127;
   static inline BxoHash_t combine_hash(BxoHash_t h, const BxoObject&ob);
   static BxoHash_t adjust_hash(BxoHash_t h, unsigned ln)
@@ -879,6 +1738,9 @@ class BxoTuple : public BxoSequence
   }
 public:
   static const BxoTuple*load_tuple(BxoJsonProcessor&, const BxoJson&);
+  /// a slice shares the components of its parent tuple
+  static const BxoTuple*make_slice(const std::shared_ptr<const BxoTuple>&ptup, int from, int to);
+  static const BxoTuple*make_concat(const BxoTuple&ltup, const BxoTuple&rtup);
   bool same_tuple(const BxoTuple& r) const
   {
     return same_sequence(r);
@@ -902,8 +1764,39 @@ class BxoString: public std::enable_shared_from_this<BxoString>
   const BxoHash_t _hash;
   const std::string _str;
   BxoString(BxoHash_t h, const std::string str) : _hash(h), _str(str) {};
+  static unsigned _hash_version_;
+  static bool _hash_version_forced_;
 public:
+  /// version 1 is the original 4-bytes-per-step hash, version 2
+  /// hashes 32-byte stripes in eight lanes, with SIMD when available
+#define BXO_STRING_HASH_VERSION_LEGACY 1
+#define BXO_STRING_HASH_VERSION_LATEST 2
   static BxoHash_t hash_cstring(const char*s, int ln= -1);
+  static BxoHash_t hash_bytes_v1(const char*s, unsigned ln);
+  static BxoHash_t hash_bytes_v2(const char*s, size_t ln);
+  static unsigned hash_version(void)
+  {
+    return _hash_version_;
+  };
+  /// should be called before any string is made, e.g. at load time
+  static void set_hash_version(unsigned v);
+  /// from the command line, then the loaded state does not change it
+  static void force_hash_version(unsigned v)
+  {
+    set_hash_version(v);
+    _hash_version_forced_ = true;
+  };
+  static bool hash_version_forced(void)
+  {
+    return _hash_version_forced_;
+  };
+  /// the version recorded by a dump, for the next load: the forced
+  /// one, else the latest, so a legacy state moves to the latest hash
+  /// when dumped; nothing dumped depends on string hashes
+  static unsigned dump_hash_version(void)
+  {
+    return _hash_version_forced_ ? _hash_version_ : BXO_STRING_HASH_VERSION_LATEST;
+  };
   BxoString(const BxoString&s) : std::enable_shared_from_this<BxoString>(s), _hash(s._hash), _str(s._str) {};
   BxoString(const char*s, int l= -1)
     : BxoString(hash_cstring(s,l),
@@ -915,25 +1808,311 @@ public:
   };
   const std::string&string(void) const
   {
-    return _str;
+    return _str;
+  };
+  bool same_string(const BxoString&r) const
+  {
+    return _hash == r._hash && _str == r._str;
+  }
+  bool same_string(const std::string&s) const
+  {
+    return _str == s;
+  }
+  bool less_than_string(const BxoString&r) const
+  {
+    return _str < r._str;
+  };
+  bool less_equal_string(const BxoString&r) const
+  {
+    return _str <= r._str;
+  };
+};        // end of BxoString
+
+
+/// an immutable packed array of int64_t, or of doubles which are
+/// never NaN, indexed in constant time; equality and hash are on the
+/// raw bytes, so for doubles -0.0 and 0.0 are distinct elements
+template <typename NumT>
+class BxoPackedArray: public std::enable_shared_from_this<BxoPackedArray<NumT>>
+{
+  static_assert(sizeof(NumT) == 8, "packed arrays are of 64 bits numbers");
+  friend class BxoVal;
+  const BxoHash_t _hash;
+  const unsigned _len;
+  const std::unique_ptr<NumT[]> _arr;
+  BxoPackedArray(BxoHash_t h, unsigned len, std::unique_ptr<NumT[]>&&arr)
+    : _hash(h), _len(len), _arr(std::move(arr)) {};
+public:
+  /// up to that length, to_json gives a JSON array, otherwise a
+  /// base64 string of the little-endian bytes
+#define BXO_PACKED_JSON_ARRAY_MAX 64
+  static const char*json_key(void);
+  static const BxoPackedArray*make_packed(const NumT*arr, unsigned len);
+  static const BxoPackedArray*make_packed(const std::vector<NumT>&vec)
+  {
+    return make_packed(vec.data(), vec.size());
+  };
+  static const BxoPackedArray*load_packed(const BxoJson&js);
+  BxoPackedArray(const BxoPackedArray&) = delete;
+  BxoPackedArray(BxoPackedArray&&) = delete;
+  BxoHash_t hash() const
+  {
+    return _hash;
+  };
+  unsigned length() const
+  {
+    return _len;
+  };
+  const NumT*data() const
+  {
+    return _arr.get();
+  };
+  const NumT*begin() const
+  {
+    return _arr.get();
+  };
+  const NumT*end() const
+  {
+    return _arr.get()+_len;
+  };
+  NumT at(int rk, NumT def=0) const
+  {
+    if (rk<0) rk += _len;
+    if (rk>=0 && rk<(int)_len) return _arr[rk];
+    return def;
+  };
+  bool same_packed(const BxoPackedArray&r) const
+  {
+    return this == &r
+           || (_hash == r._hash && _len == r._len
+               && !memcmp(_arr.get(), r._arr.get(), _len*sizeof(NumT)));
+  };
+  bool less_than_packed(const BxoPackedArray&r) const
+  {
+    return std::lexicographical_compare(begin(), end(), r.begin(), r.end());
+  };
+  bool less_equal_packed(const BxoPackedArray&r) const
+  {
+    return !r.less_than_packed(*this);
+  };
+  /// the reductions, giving 0 for an empty array; the int64_t sum wraps around
+  NumT sum() const;
+  NumT min() const;
+  NumT max() const;
+  template <typename Pred> BXO_OPTIMIZEDFUN unsigned count_if(Pred pred) const
+  {
+    unsigned cnt = 0;
+    const NumT*arr = _arr.get();
+    for (unsigned ix=0; ix<_len; ix++)
+      cnt += pred(arr[ix]) ? 1 : 0;
+    return cnt;
+  };
+  BxoJson packed_to_json(void) const;
+  void packed_write_json(BxoJsonWriter&) const;
+  /// the base64 of the little-endian bytes, for long arrays
+  std::string packed_base64(void) const;
+  void out(std::ostream&os) const;
+};        // end of BxoPackedArray
+
+
+/// an immutable binary blob; a loaded blob only knows the path, size
+/// and hash of its side file, which is mmap-ed at the first access of
+/// its bytes, so loading a state never reads the blob contents
+class BxoBlob: public std::enable_shared_from_this<BxoBlob>
+{
+  friend class BxoVal;
+  const BxoHash_t _hash;
+  const size_t _size;
+  const std::string _path;	// the side file, empty for blobs made in memory
+  const std::unique_ptr<char[]> _mem;
+  mutable std::once_flag _mapflag;
+  mutable const char* _map;
+  BxoBlob(BxoHash_t h, size_t sz, std::unique_ptr<char[]>&&mem)
+    : _hash(h), _size(sz), _path(), _mem(std::move(mem)), _mapflag(), _map(nullptr) {};
+  BxoBlob(BxoHash_t h, size_t sz, const std::string&path)
+    : _hash(h), _size(sz), _path(path), _mem(), _mapflag(), _map(nullptr) {};
+  void map_file(void) const;
+public:
+  /// side files are named from the size and hash, in the dump directory
+#define BXO_BLOB_FILE_PREFIX "_blob_"
+#define BXO_BLOB_FILE_SUFFIX ".bxblob"
+  /// up to that size, a blob is dumped inline, without any side file
+#define BXO_BLOB_INLINE_MAX 256
+  static const BxoBlob*make_blob(const void*data, size_t sz);
+  static const BxoBlob*map_blob(const std::string&path, size_t sz, BxoHash_t h);
+  static const BxoBlob*load_blob(BxoJsonProcessor&bxj, const BxoJson&js);
+  BxoBlob(const BxoBlob&) = delete;
+  BxoBlob(BxoBlob&&) = delete;
+  ~BxoBlob();
+  BxoHash_t hash() const
+  {
+    return _hash;
+  };
+  size_t size() const
+  {
+    return _size;
+  };
+  const std::string&path() const
+  {
+    return _path;
+  };
+  bool is_mapped() const
+  {
+    return _map != nullptr;
+  };
+  /// the bytes, mapping the side file if needed
+  const char*data() const
+  {
+    if (_mem || _size == 0)
+      return _mem.get();
+    std::call_once(_mapflag, [this]()
+    {
+      map_file();
+    });
+    return _map;
+  };
+  std::string file_name(unsigned variant=0) const;
+  bool same_blob(const BxoBlob&r) const
+  {
+    return this == &r
+           || (_hash == r._hash && _size == r._size
+               && ((!_path.empty() && _path == r._path)
+                   || !memcmp(data(), r.data(), _size)));
+  };
+  bool less_than_blob(const BxoBlob&r) const;
+  bool less_equal_blob(const BxoBlob&r) const
+  {
+    return !r.less_than_blob(*this);
+  };
+  BxoJson blob_to_json(BxoDumper&du) const;
+  void blob_write_json(BxoJsonWriter&jw) const;
+  void out(std::ostream&os) const;
+};        // end of BxoBlob
+
+
+/// an immutable rope of UTF-8 text, an AVL tree of chunks whose nodes
+/// are shared between versions; insert, erase, sub_rope and concat
+/// give a new rope in O(log n) time. Every node caches a polynomial
+/// hash of its bytes, so the hash does not depend on the chunking.
+/// Positions are byte offsets, and must be at character boundaries.
+class BxoRopeNode;
+class BxoRope: public std::enable_shared_from_this<BxoRope>
+{
+  friend class BxoVal;
+  const std::shared_ptr<const BxoRopeNode> _root; // null for the empty rope
+  const BxoHash_t _hash;
+  BxoRope(const std::shared_ptr<const BxoRopeNode>&root);
+  static const BxoRope*make_from_node(const std::shared_ptr<const BxoRopeNode>&root)
+  {
+    return new BxoRope(root);
+  };
+  void check_boundary(size_t pos, const char*opname) const;
+public:
+  /// the biggest chunk in a leaf
+#define BXO_ROPE_CHUNK_MAX 2048
+  static const BxoRope*make_rope(const char*s, size_t len);
+  static const BxoRope*make_rope(const std::string&str)
+  {
+    return make_rope(str.data(), str.size());
+  };
+  static const BxoRope*load_rope(const BxoJson&js);
+  BxoRope(const BxoRope&) = delete;
+  BxoRope(BxoRope&&) = delete;
+  ~BxoRope();
+  BxoHash_t hash() const
+  {
+    return _hash;
+  };
+  size_t length() const;
+  unsigned depth() const;
+  unsigned nb_chunks() const;
+  /// the byte at pos, or -1 if out of range
+  int byte_at(size_t pos) const;
+  std::string to_string() const;
+  /// up to len bytes from pos, as a string
+  std::string substring(size_t pos, size_t len) const;
+  /// the new ropes
+  const BxoRope*sub_rope(size_t pos, size_t len) const;
+  const BxoRope*insert(size_t pos, const char*s, size_t len) const;
+  const BxoRope*insert(size_t pos, const std::string&str) const
+  {
+    return insert(pos, str.data(), str.size());
+  };
+  const BxoRope*insert(size_t pos, const BxoRope&r) const;
+  const BxoRope*erase(size_t pos, size_t len) const;
+  const BxoRope*concat(const BxoRope&r) const;
+  /// call f on every chunk, in order
+  void each_chunk(const std::function<void(const char*,size_t)>&f) const;
+  /// compare the bytes, like memcmp
+  int compare(const BxoRope&r) const;
+  bool same_rope(const BxoRope&r) const
+  {
+    return this == &r || (_hash == r._hash && length() == r.length() && compare(r) == 0);
   };
-  bool same_string(const BxoString&r) const
+  bool less_than_rope(const BxoRope&r) const
   {
-    return _hash == r._hash && _str == r._str;
-  }
-  bool same_string(const std::string&s) const
+    return compare(r) < 0;
+  };
+  bool less_equal_rope(const BxoRope&r) const
   {
-    return _str == s;
-  }
-  bool less_than_string(const BxoString&r) const
+    return compare(r) <= 0;
+  };
+  BxoJson rope_to_json(void) const;
+  void out(std::ostream&os) const;
+};        // end of BxoRope
+
+
+/// an immutable map from objects to non-nil values, a compressed hash
+/// array mapped trie (with separate bitmaps for entries and subnodes)
+/// of 32 branches per level. Its shape only depends on its content, so
+/// versions share their untouched subtrees, and comparing two maps
+/// skips the shared ones. Every node caches its size and the sum of
+/// the hashes of its pairs.
+class BxoMapNode;
+class BxoMap: public std::enable_shared_from_this<BxoMap>
+{
+  friend class BxoVal;
+  const std::shared_ptr<const BxoMapNode> _root; // null for the empty map
+  const BxoHash_t _hash;
+  BxoMap(const std::shared_ptr<const BxoMapNode>&root);
+  static const BxoMap*make_from_node(const std::shared_ptr<const BxoMapNode>&root)
   {
-    return _str < r._str;
+    return new BxoMap(root);
   };
-  bool less_equal_string(const BxoString&r) const
+public:
+  typedef std::pair<std::shared_ptr<BxoObject>,BxoVal> pair_t;
+  static const BxoMap*make_map(const std::vector<pair_t>&pairs);
+  static const BxoMap*load_map(BxoJsonProcessor&bxj, const BxoJson&js);
+  BxoMap(const BxoMap&) = delete;
+  BxoMap(BxoMap&&) = delete;
+  ~BxoMap();
+  BxoHash_t hash() const
   {
-    return _str <= r._str;
+    return _hash;
   };
-};        // end of BxoString
+  size_t size() const;
+  unsigned depth() const;
+  /// the value associated to key, or nil
+  BxoVal get(const BxoObject*key) const;
+  bool has(const BxoObject*key) const;
+  /// the new maps; putting a nil value removes the key
+  const BxoMap*put(const std::shared_ptr<BxoObject>&key, const BxoVal&val) const;
+  const BxoMap*remove(const BxoObject*key) const;
+  /// call f on every pair, in hash order
+  void each(const std::function<void(const std::shared_ptr<BxoObject>&,const BxoVal&)>&f) const;
+  /// the pairs sorted by their object
+  std::vector<pair_t> sorted_pairs(void) const;
+  bool same_map(const BxoMap&r) const;
+  bool less_than_map(const BxoMap&r) const;
+  bool less_equal_map(const BxoMap&r) const
+  {
+    return !r.less_than_map(*this);
+  };
+  void map_scan_dump(BxoDumper&du) const;
+  BxoJson map_to_json(BxoDumper&du) const;
+  void map_write_json(BxoJsonWriter&jw) const;
+  void out(std::ostream&os) const;
+};        // end of BxoMap
 
 
 BxoVal::BxoVal(TagString, const std::string& s)
@@ -964,13 +2143,40 @@ BxoVal:: BxoVal(TagObject, const std::shared_ptr<BxoObject> op)
 
 BxoVal:: BxoVal(const std::shared_ptr<BxoObject> op, TagObject)
   : _kind(BxoVKind::ObjectK), _obj(op) {};
+// the empty set & tuple are static, so should never be deleted
 BxoVal:: BxoVal(TagSet, const BxoSet*pset)
-  : _kind(pset?BxoVKind::SetK:BxoVKind::NoneK), _set(pset) {};
+  : _kind(pset?BxoVKind::SetK:BxoVKind::NoneK),
+    _set((pset==&BxoSet::the_empty_set)
+         ?std::shared_ptr<const BxoSet>(pset,[](const BxoSet*) {})
+         :std::shared_ptr<const BxoSet>(pset)) {};
 
 
 BxoVal:: BxoVal(TagTuple, const BxoTuple*ptup)
-  : _kind(ptup?BxoVKind::TupleK:BxoVKind::NoneK), _tup(ptup) {};
+  : _kind(ptup?BxoVKind::TupleK:BxoVKind::NoneK),
+    _tup((ptup==&BxoTuple::the_empty_tuple)
+         ?std::shared_ptr<const BxoTuple>(ptup,[](const BxoTuple*) {})
+         :std::shared_ptr<const BxoTuple>(ptup)) {};
+
 
+BxoVal::BxoVal(TagIntVec, const BxoIntVec*pivec)
+  : _kind(pivec?BxoVKind::IntVecK:BxoVKind::NoneK),
+    _ivec(pivec?std::shared_ptr<const BxoIntVec>(pivec):nullptr) {};
+
+BxoVal::BxoVal(TagDoubleVec, const BxoDoubleVec*pdvec)
+  : _kind(pdvec?BxoVKind::DoubleVecK:BxoVKind::NoneK),
+    _dvec(pdvec?std::shared_ptr<const BxoDoubleVec>(pdvec):nullptr) {};
+
+BxoVal::BxoVal(TagBlob, const BxoBlob*pblob)
+  : _kind(pblob?BxoVKind::BlobK:BxoVKind::NoneK),
+    _blob(pblob?std::shared_ptr<const BxoBlob>(pblob):nullptr) {};
+
+BxoVal::BxoVal(TagRope, const BxoRope*prope)
+  : _kind(prope?BxoVKind::RopeK:BxoVKind::NoneK),
+    _rope(prope?std::shared_ptr<const BxoRope>(prope):nullptr) {};
+
+BxoVal::BxoVal(TagMap, const BxoMap*pmap)
+  : _kind(pmap?BxoVKind::MapK:BxoVKind::NoneK),
+    _omap(pmap?std::shared_ptr<const BxoMap>(pmap):nullptr) {};
 
 BxoVal::BxoVal(const BxoVal&v)
   : _kind(v._kind)
@@ -995,6 +2201,21 @@ BxoVal::BxoVal(const BxoVal&v)
     case BxoVKind::TupleK:
       new(&_tup) std::shared_ptr<const BxoTuple>(v._tup);
       break;
+    case BxoVKind::IntVecK:
+      new(&_ivec) std::shared_ptr<const BxoIntVec>(v._ivec);
+      break;
+    case BxoVKind::DoubleVecK:
+      new(&_dvec) std::shared_ptr<const BxoDoubleVec>(v._dvec);
+      break;
+    case BxoVKind::BlobK:
+      new(&_blob) std::shared_ptr<const BxoBlob>(v._blob);
+      break;
+    case BxoVKind::RopeK:
+      new(&_rope) std::shared_ptr<const BxoRope>(v._rope);
+      break;
+    case BxoVKind::MapK:
+      new(&_omap) std::shared_ptr<const BxoMap>(v._omap);
+      break;
     }
 } // end BxoVal::BxoVal(const BxoVal&v)
 
@@ -1026,6 +2247,21 @@ BxoVal& BxoVal::operator =(const BxoVal&s)
         case BxoVKind::TupleK:
           _tup = s._tup;
           break;
+        case BxoVKind::IntVecK:
+          _ivec = s._ivec;
+          break;
+        case BxoVKind::DoubleVecK:
+          _dvec = s._dvec;
+          break;
+        case BxoVKind::BlobK:
+          _blob = s._blob;
+          break;
+        case BxoVKind::RopeK:
+          _rope = s._rope;
+          break;
+        case BxoVKind::MapK:
+          _omap = s._omap;
+          break;
         }
       return *this;
     }
@@ -1059,6 +2295,21 @@ BxoVal::BxoVal(BxoVal&&v)
     case BxoVKind::TupleK:
       new(&_tup)  std::shared_ptr<const BxoTuple>(std::move(v._tup));
       break;
+    case BxoVKind::IntVecK:
+      new(&_ivec) std::shared_ptr<const BxoIntVec>(std::move(v._ivec));
+      break;
+    case BxoVKind::DoubleVecK:
+      new(&_dvec) std::shared_ptr<const BxoDoubleVec>(std::move(v._dvec));
+      break;
+    case BxoVKind::BlobK:
+      new(&_blob) std::shared_ptr<const BxoBlob>(std::move(v._blob));
+      break;
+    case BxoVKind::RopeK:
+      new(&_rope) std::shared_ptr<const BxoRope>(std::move(v._rope));
+      break;
+    case BxoVKind::MapK:
+      new(&_omap) std::shared_ptr<const BxoMap>(std::move(v._omap));
+      break;
     }
   *const_cast<BxoVKind*>(&v._kind) = BxoVKind::NoneK;
   v._ptr = nullptr;
@@ -1092,6 +2343,21 @@ BxoVal& BxoVal::operator =(BxoVal&&s)
         case BxoVKind::TupleK:
           _tup = std::move(s._tup);
           break;
+        case BxoVKind::IntVecK:
+          _ivec = std::move(s._ivec);
+          break;
+        case BxoVKind::DoubleVecK:
+          _dvec = std::move(s._dvec);
+          break;
+        case BxoVKind::BlobK:
+          _blob = std::move(s._blob);
+          break;
+        case BxoVKind::RopeK:
+          _rope = std::move(s._rope);
+          break;
+        case BxoVKind::MapK:
+          _omap = std::move(s._omap);
+          break;
         }
       *const_cast<BxoVKind*>(&s._kind) = BxoVKind::NoneK;
       s._ptr = nullptr;
@@ -1125,9 +2391,25 @@ void BxoVal::clear()
       break;
     case BxoVKind::SetK:
       _set.~shared_ptr<const BxoSet>();
+      break;
     case BxoVKind::TupleK:
       _tup.~shared_ptr<const BxoTuple>();
       break;
+    case BxoVKind::IntVecK:
+      _ivec.~shared_ptr<const BxoIntVec>();
+      break;
+    case BxoVKind::DoubleVecK:
+      _dvec.~shared_ptr<const BxoDoubleVec>();
+      break;
+    case BxoVKind::BlobK:
+      _blob.~shared_ptr<const BxoBlob>();
+      break;
+    case BxoVKind::RopeK:
+      _rope.~shared_ptr<const BxoRope>();
+      break;
+    case BxoVKind::MapK:
+      _omap.~shared_ptr<const BxoMap>();
+      break;
     }
   _ptr = nullptr;
 } // end BxoVal::clear()
@@ -1155,6 +2437,21 @@ BxoVal::~BxoVal()
     case BxoVKind::TupleK:
       _tup.~shared_ptr<const BxoTuple>();
       break;
+    case BxoVKind::IntVecK:
+      _ivec.~shared_ptr<const BxoIntVec>();
+      break;
+    case BxoVKind::DoubleVecK:
+      _dvec.~shared_ptr<const BxoDoubleVec>();
+      break;
+    case BxoVKind::BlobK:
+      _blob.~shared_ptr<const BxoBlob>();
+      break;
+    case BxoVKind::RopeK:
+      _rope.~shared_ptr<const BxoRope>();
+      break;
+    case BxoVKind::MapK:
+      _omap.~shared_ptr<const BxoMap>();
+      break;
     }
   *const_cast<BxoVKind*>(&_kind) = BxoVKind::NoneK;
   _ptr = nullptr;
@@ -1290,6 +2587,152 @@ BxoVal::get_tuple(void) const
 
 
 
+std::shared_ptr<const BxoIntVec>
+BxoVal::as_intvec(void) const
+{
+  if (_kind != BxoVKind::IntVecK)
+    {
+      BXO_BACKTRACELOG("as_intvec: non-intvec value " << this);
+      throw std::runtime_error("as_intvec: non-intvec value");
+    }
+  return _ivec;
+} // end BxoVal::as_intvec
+
+std::shared_ptr<const BxoIntVec>
+BxoVal::to_intvec(const std::shared_ptr<const BxoIntVec> def) const
+{
+  if (_kind != BxoVKind::IntVecK) return def;
+  return _ivec;
+}
+
+const BxoIntVec*
+BxoVal::get_intvec(void) const
+{
+  if (_kind != BxoVKind::IntVecK)
+    {
+      BXO_BACKTRACELOG("get_intvec: non-intvec value " << this);
+      throw std::runtime_error("get_intvec: non-intvec value");
+    }
+  return _ivec.get();
+} // end of BxoVal::get_intvec
+
+std::shared_ptr<const BxoDoubleVec>
+BxoVal::as_doublevec(void) const
+{
+  if (_kind != BxoVKind::DoubleVecK)
+    {
+      BXO_BACKTRACELOG("as_doublevec: non-doublevec value " << this);
+      throw std::runtime_error("as_doublevec: non-doublevec value");
+    }
+  return _dvec;
+} // end BxoVal::as_doublevec
+
+std::shared_ptr<const BxoDoubleVec>
+BxoVal::to_doublevec(const std::shared_ptr<const BxoDoubleVec> def) const
+{
+  if (_kind != BxoVKind::DoubleVecK) return def;
+  return _dvec;
+}
+
+const BxoDoubleVec*
+BxoVal::get_doublevec(void) const
+{
+  if (_kind != BxoVKind::DoubleVecK)
+    {
+      BXO_BACKTRACELOG("get_doublevec: non-doublevec value " << this);
+      throw std::runtime_error("get_doublevec: non-doublevec value");
+    }
+  return _dvec.get();
+} // end of BxoVal::get_doublevec
+
+std::shared_ptr<const BxoBlob>
+BxoVal::as_blob(void) const
+{
+  if (_kind != BxoVKind::BlobK)
+    {
+      BXO_BACKTRACELOG("as_blob: non-blob value " << this);
+      throw std::runtime_error("as_blob: non-blob value");
+    }
+  return _blob;
+} // end BxoVal::as_blob
+
+std::shared_ptr<const BxoBlob>
+BxoVal::to_blob(const std::shared_ptr<const BxoBlob> def) const
+{
+  if (_kind != BxoVKind::BlobK) return def;
+  return _blob;
+}
+
+const BxoBlob*
+BxoVal::get_blob(void) const
+{
+  if (_kind != BxoVKind::BlobK)
+    {
+      BXO_BACKTRACELOG("get_blob: non-blob value " << this);
+      throw std::runtime_error("get_blob: non-blob value");
+    }
+  return _blob.get();
+} // end of BxoVal::get_blob
+
+std::shared_ptr<const BxoRope>
+BxoVal::as_rope(void) const
+{
+  if (_kind != BxoVKind::RopeK)
+    {
+      BXO_BACKTRACELOG("as_rope: non-rope value " << this);
+      throw std::runtime_error("as_rope: non-rope value");
+    }
+  return _rope;
+} // end BxoVal::as_rope
+
+std::shared_ptr<const BxoRope>
+BxoVal::to_rope(const std::shared_ptr<const BxoRope> def) const
+{
+  if (_kind != BxoVKind::RopeK) return def;
+  return _rope;
+}
+
+const BxoRope*
+BxoVal::get_rope(void) const
+{
+  if (_kind != BxoVKind::RopeK)
+    {
+      BXO_BACKTRACELOG("get_rope: non-rope value " << this);
+      throw std::runtime_error("get_rope: non-rope value");
+    }
+  return _rope.get();
+} // end of BxoVal::get_rope
+
+std::shared_ptr<const BxoMap>
+BxoVal::as_omap(void) const
+{
+  if (_kind != BxoVKind::MapK)
+    {
+      BXO_BACKTRACELOG("as_omap: non-map value " << this);
+      throw std::runtime_error("as_omap: non-map value");
+    }
+  return _omap;
+} // end BxoVal::as_omap
+
+std::shared_ptr<const BxoMap>
+BxoVal::to_omap(const std::shared_ptr<const BxoMap> def) const
+{
+  if (_kind != BxoVKind::MapK) return def;
+  return _omap;
+}
+
+const BxoMap*
+BxoVal::get_omap(void) const
+{
+  if (_kind != BxoVKind::MapK)
+    {
+      BXO_BACKTRACELOG("get_omap: non-map value " << this);
+      throw std::runtime_error("get_omap: non-map value");
+    }
+  return _omap.get();
+} // end of BxoVal::get_omap
+
+
 std::shared_ptr<const BxoSequence>
 BxoVal::as_sequence(void) const
 {
@@ -1375,6 +2818,34 @@ BxoVal::to_objptr(BxoObject*defobp) const
   if (_kind == BxoVKind::ObjectK) return _obj.get();
   return defobp;
 } // end of BxoVal::to_objptr
+
+BxoTry<const BxoSequence*>
+BxoVal::try_as_sequence(void) const noexcept
+{
+  if (_kind == BxoVKind::TupleK)
+    return try_hit<const BxoSequence*>(_tup.get());
+  else if (_kind == BxoVKind::SetK)
+    return try_hit<const BxoSequence*>(_set.get());
+  return try_miss<const BxoSequence*>();
+} // end of BxoVal::try_as_sequence
+
+BxoVal
+BxoVal::slice(int from, int to) const
+{
+  if (_kind == BxoVKind::TupleK)
+    {
+      if (from == 0 && to >= (int)_tup->length())
+        return *this;
+      return BxoVal(TagTuple {}, BxoTuple::make_slice(_tup, from, to));
+    }
+  else if (_kind == BxoVKind::SetK)
+    {
+      if (from == 0 && to >= (int)_set->length())
+        return *this;
+      return BxoVal(TagSet {}, BxoSet::make_slice(_set, from, to));
+    }
+  return nullptr;
+} // end of BxoVal::slice
 ////////////////
 
 enum class BxoSpace: std::uint8_t
@@ -1401,9 +2872,15 @@ class BxoObject: public std::enable_shared_from_this<BxoObject>
   friend class BxoVal;
   friend class BxoPayload;
   friend class std::shared_ptr<BxoObject>;
+  friend class BxoDumper;
   const BxoHash_t _hash;
-  bool _gcmark;
+  /// the epoch of the last dump reaching the object, set while
+  /// scanning by the first thread reaching it; 0 if never reached
+  std::atomic<uint32_t> _dumpepoch;
   BxoSpace _space;
+  /// the dense object number, an index in _obnumvec_, recycled when
+  /// the object is destroyed
+  uint32_t _obnum;
   const Bxo_hid_t _hid;
   const Bxo_loid_t _loid;
   std::shared_ptr<BxoObject> _classob;
@@ -1418,10 +2895,29 @@ class BxoObject: public std::enable_shared_from_this<BxoObject>
   static std::unordered_set<BxoObject*,BxoHashObjPtr> _bucketarr_[BXO_HID_BUCKETMAX];
   static std::map<std::string,std::shared_ptr<BxoObject>> _namedict_;
   static std::unordered_map<BxoObject*,std::string> _namemap_;
+  /// the objects currently named with a predefined name, by its dense
+  /// index, so find_named_objref needs no map probe for these names
+  static BxoObject* _predefnamed_[];
+  /// a slot of the object number side table; compact containers
+  /// storing object numbers pin their objects, and the first pin
+  /// keeps the object alive till the last unpin
+  struct ObnumSlot
+  {
+    BxoObject* _ptr;
+    uint32_t _pincnt;
+    std::shared_ptr<BxoObject> _pin;
+  };
+  /// the side table is never destroyed, since objects may die after main
+  static std::vector<ObnumSlot>& _obnumvec_;
+  static std::vector<uint32_t>& _obnumfree_;
+  /// set once the whole object graph is going away; destructors then
+  /// skip maintaining the registries
+  static bool _tearingdown_;
   static inline void register_in_bucket(BxoObject*pob)
   {
     _bucketarr_[hi_id_bucketnum(pob->_hid)].insert(pob);
   }
+  static void register_obnum(BxoObject*pob);
 public:
   inline bool has_attr(const std::shared_ptr<BxoObject> pobat) const;
   inline BxoVal get_attr(const std::shared_ptr<BxoObject> pobat) const;
@@ -1440,35 +2936,47 @@ public:
   };
   void change_space(BxoSpace);
   /// since PredefTag is private this is only reachable from our
-  /// member functions
+  /// member functions; initialize_predefined_objects registers all
+  /// the predefined objects at once
   BxoObject(PredefTag, BxoHash_t hash, Bxo_hid_t hid, Bxo_loid_t loid)
     : std::enable_shared_from_this<BxoObject>(),
-      _hash(hash), _gcmark(false), _space(BxoSpace::PredefSp), _hid(hid), _loid(loid),
+      _hash(hash), _dumpepoch(0), _space(BxoSpace::PredefSp), _obnum(0), _hid(hid), _loid(loid),
       _classob {nullptr},
       _attrh {}, _compv {}, _payl {nullptr}, _mtime(0)
   {
-    register_in_bucket(this);
-    BXO_VERBOSELOG("BxoObject Predef strid:"<< strid() << " @" << (void*)this);
   };
   BxoObject(PseudoTag, BxoHash_t hash, Bxo_hid_t hid, Bxo_loid_t loid)
     : std::enable_shared_from_this<BxoObject>(),
-      _hash(hash), _gcmark(false), _space(BxoSpace::TransientSp), _hid(hid), _loid(loid),
+      _hash(hash), _dumpepoch(0), _space(BxoSpace::TransientSp), _obnum(0), _hid(hid), _loid(loid),
       _classob {nullptr},
       _attrh {}, _compv {}, _payl {nullptr}, _mtime(0)
   {
+    register_obnum(this);
   };
   BxoObject(LoadedTag, BxoHash_t hash, Bxo_hid_t hid, Bxo_loid_t loid)
     : std::enable_shared_from_this<BxoObject>(),
-      _hash(hash), _gcmark(false), _space(BxoSpace::GlobalSp), _hid(hid), _loid(loid),
+      _hash(hash), _dumpepoch(0), _space(BxoSpace::GlobalSp), _obnum(0), _hid(hid), _loid(loid),
       _classob {nullptr},
       _attrh {}, _compv {}, _payl {nullptr}, _mtime(0)
   {
     register_in_bucket(this);
+    register_obnum(this);
     BXO_VERBOSELOG("BxoObject Loaded strid:"<< strid() << " @" << (void*)this);
   };
   static void initialize_predefined_objects (void);
+  /// give every predefined object its predefined name; gives -1, or
+  /// the dense index of a predefined object which could not be named
+  static int register_predefined_names (void);
   static BxoVal set_of_predefined_objects (void);
   static const std::set<std::string> all_names (void);
+  static void begin_teardown (void)
+  {
+    _tearingdown_ = true;
+  };
+  static bool tearing_down (void)
+  {
+    return _tearingdown_;
+  };
   BxoHash_t hash()const
   {
     return _hash;
@@ -1490,6 +2998,18 @@ public:
   {
     return _loid;
   };
+  uint32_t obnum() const
+  {
+    return _obnum;
+  };
+  static BxoObject* find_from_obnum(uint32_t num)
+  {
+    if (BXO_UNLIKELY(num == 0 || num >= _obnumvec_.size()))
+      return nullptr;
+    return _obnumvec_[num]._ptr;
+  };
+  static uint32_t pin_obnum(const std::shared_ptr<BxoObject>&pob);
+  static void unpin_obnum(uint32_t num);
   bool same(const BxoObject&r) const
   {
     return this == &r;
@@ -1497,19 +3017,36 @@ public:
   bool less(const BxoObject&r) const
   {
     if (this == &r) return false;
-    if (_hid >= r._hid) return false;
-    if (_hid < r._hid) return true;
+    if (_hid != r._hid) return _hid < r._hid;
     return _loid < r._loid;
   };
   inline bool alpha_less(const BxoObject&r) const;
   bool less_equal(const BxoObject&r) const
   {
     if (this == &r) return true;
-    if (_hid >= r._hid) return false;
-    if (_hid < r._hid) return true;
+    if (_hid != r._hid) return _hid < r._hid;
     return _loid <= r._loid;
   }
+  /// store the BXO_OBJKEY_SIZE bytes of the ordering key, which
+  /// compare with memcmp like objects with less
+  void pack_key(unsigned char*key) const
+  {
+    uint32_t behid = htobe32(_hid);
+    uint64_t beloid = htobe64(_loid);
+    memcpy(key, &behid, sizeof(behid));
+    memcpy(key+sizeof(behid), &beloid, sizeof(beloid));
+  };
   static std::string str_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid);
+  /// the same id into a buffer, without allocating
+  static void cstr_from_hid_loid(char buf[BXO_CSTRIDSIZ], Bxo_hid_t hid, Bxo_loid_t loid);
+  /// a key ordering ids like their strings do, e.g. in the ob_id
+  /// column; unlike pack_key, since the ASCII order of the id digits
+  /// is not their numerical order
+  static Bxo_uint128_t id_order_key(Bxo_hid_t hid, Bxo_loid_t loid);
+  Bxo_uint128_t id_order_key(void) const
+  {
+    return id_order_key(_hid, _loid);
+  };
   static bool cstr_to_hid_loid(const char*cstr, Bxo_hid_t* phid, Bxo_loid_t* ploid, const char**endp=nullptr);
   static bool str_to_hid_loid(const std::string& str,  Bxo_hid_t* phid, Bxo_loid_t* ploid)
   {
@@ -1531,13 +3068,7 @@ public:
   bool register_named(const std::string&str);
   bool forget_named(void);
   static bool forget_name(const std::string&str);
-  static std::shared_ptr<BxoObject> find_named_objref(const std::string&str)
-  {
-    auto it = _namedict_.find(str);
-    if (it != _namedict_.end())
-      return it->second;
-    else return nullptr;
-  };
+  static inline std::shared_ptr<BxoObject> find_named_objref(const std::string&str);
   static BxoObject*find_named_objptr(const std::string&str)
   {
     return find_named_objref(str).get();
@@ -1573,7 +3104,7 @@ public:
   {
     return BxoJson(strid());
   };
-  static inline BxoHash_t hash_from_hid_loid (Bxo_hid_t hid, Bxo_loid_t loid);
+  static constexpr BxoHash_t hash_from_hid_loid (Bxo_hid_t hid, Bxo_loid_t loid);
   static BxoObject* find_from_hid_loid (Bxo_hid_t hid, Bxo_loid_t loid);
   static BxoObject* find_from_idstr(const std::string&idstr);
   static BxoObject* make_object(BxoSpace sp = BxoSpace::TransientSp);
@@ -1584,12 +3115,19 @@ public:
     return std::shared_ptr<BxoObject> {pob};
   }
   static std::shared_ptr<BxoObject> load_objref(BxoLoader&ld, const std::string& idstr);
+  static std::shared_ptr<BxoObject> load_objref(BxoLoader&ld, Bxo_hid_t hid, Bxo_loid_t loid);
   void load_content(const BxoJson&, BxoLoader&);
+  /// parse the same content as load_content, without building its JSON
+  void read_content(BxoJsonReader&, BxoLoader&);
   void load_set_class(std::shared_ptr<BxoObject> obclass, BxoLoader&);
   void load_set_payload(BxoPayload*payl, BxoLoader&);
   void touch_load(time_t, BxoLoader&);
   void scan_content_dump(BxoDumper&) const;
   BxoJson json_for_content(BxoDumper&) const;
+  /// stream the same JSON as json_for_content
+  void write_content(BxoJsonWriter&) const;
+  void load_content_binary(BxoBinaryDecoder&, BxoLoader&);
+  void binary_for_content(BxoBinaryEncoder&) const;
   std::shared_ptr<BxoObject> class_obj() const
   {
     return _classob;
@@ -1603,6 +3141,10 @@ public:
   {
     return dynamic_cast<PaylClass*>(_payl.get());
   }
+  /// like dyncast_payload but without dynamic_cast: compares the
+  /// payload kind_obptr with the static PaylClass::payload_kind(), so
+  /// PaylClass should be the only payload class of its kind
+  template <class PaylClass> inline BxoTry<PaylClass*> trycast_payload() const noexcept;
   template <class PaylClass>
   PaylClass*dynget_payload() const
   {
@@ -1694,6 +3236,125 @@ enum Bxo_PredefHash_en
 #include "_bxo_predef.h"
 };
 
+/// the dense index of predefined objects, in _bxo_predef.h order
+enum Bxo_PredefIndex_en
+{
+#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash) \
+  bxopredix_##Name,
+#include "_bxo_predef.h"
+  bxopredix__LAST
+};
+
+/// perfect hashing of predefined ids and names, by hash and
+/// displace: a key of hash h falls in bucket bxo_predef_bucket(h), and
+/// the generator of _bxo_predef.h chose for every bucket a
+/// displacement giving distinct slots to its keys and to all other
+/// keys. Ids and names have their own displacements.
+#if !defined(BXO_PREDEF_HASH_BITS) || !defined(BXO_PREDEF_BUCKET_BITS)
+#error _bxo_predef.h lacks BXO_PREDEF_HASH_BITS or BXO_PREDEF_BUCKET_BITS
+#endif
+
+/// the little-endian word of the 8 bytes at str, written so that GCC
+/// merges it into a single load
+constexpr uint64_t bxo_predef_word8(const char*str)
+{
+  return (uint64_t)(unsigned char)str[0]
+         | (uint64_t)(unsigned char)str[1] << 8
+         | (uint64_t)(unsigned char)str[2] << 16
+         | (uint64_t)(unsigned char)str[3] << 24
+         | (uint64_t)(unsigned char)str[4] << 32
+         | (uint64_t)(unsigned char)str[5] << 40
+         | (uint64_t)(unsigned char)str[6] << 48
+         | (uint64_t)(unsigned char)str[7] << 56;
+}
+
+constexpr uint64_t bxo_predef_wordn(const char*str, size_t len)
+{
+  uint64_t w = 0;
+  for (size_t ix=0; ix<len; ix++)
+    w |= (uint64_t)(unsigned char)str[ix] << (8*ix);
+  return w;
+}
+
+/// hashes only the first and last 8 bytes and the length, so probing
+/// costs a few cycles whatever the key, e.g. when most probed ids are
+/// not predefined
+constexpr uint32_t bxo_predef_strhash(const char*str, size_t len)
+{
+  uint64_t w1 = (len >= 8) ? bxo_predef_word8(str) : bxo_predef_wordn(str, len);
+  uint64_t w2 = (len >= 8) ? bxo_predef_word8(str+len-8) : 0;
+  uint64_t h = (w1 ^ (len * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+  h = (h ^ (h >> 32) ^ w2) * 0xc4ceb9fe1a85ec53ULL;
+  return (uint32_t)(h >> 32);
+}
+
+constexpr unsigned bxo_predef_bucket(uint32_t h, unsigned bucketbits)
+{
+  return h >> (32 - bucketbits);
+}
+
+constexpr unsigned bxo_predef_slot(uint32_t h, unsigned displ, unsigned hashbits)
+{
+  uint32_t m = h + displ * 0x9e3779b9u;
+  m ^= m >> 16;
+  m *= 0x85ebca6bu;
+  m ^= m >> 13;
+  m *= 0xc2b2ae35u;
+  m ^= m >> 16;
+  return m >> (32 - hashbits);
+}
+
+struct BxoPredefKey
+{
+  const char*pk_str;
+  unsigned pk_len;
+};
+
+/// maps each slot to a dense index, or -1
+struct BxoPredefTable
+{
+  static constexpr unsigned size = 1u << BXO_PREDEF_HASH_BITS;
+  static constexpr unsigned nbuckets = 1u << BXO_PREDEF_BUCKET_BITS;
+  uint16_t pt_displ[nbuckets];
+  int pt_index[size];
+  unsigned pt_collisions;
+};
+
+/// these are constexpr in object.cc, where they are statically checked
+extern const BxoPredefKey bxo_predef_idkeys[];
+extern const BxoPredefKey bxo_predef_namekeys[];
+extern std::shared_ptr<BxoObject>* const bxo_predef_vars[];
+extern const BxoPredefTable bxo_predef_idtable;
+extern const BxoPredefTable bxo_predef_nametable;
+
+/// the dense index of the predefined key equal to str, or -1; no map
+/// is probed
+inline int
+bxo_predef_lookup(const BxoPredefTable&tab, const BxoPredefKey*keys,
+                  const char*str, size_t len)
+{
+  uint32_t h = bxo_predef_strhash(str, len);
+  unsigned displ = tab.pt_displ[bxo_predef_bucket(h, BXO_PREDEF_BUCKET_BITS)];
+  int ix = tab.pt_index[bxo_predef_slot(h, displ, BXO_PREDEF_HASH_BITS)];
+  if (ix < 0 || keys[ix].pk_len != len || memcmp(keys[ix].pk_str, str, len))
+    return -1;
+  return ix;
+}
+
+inline int
+bxo_predef_idstr_index(const std::string&idstr)
+{
+  return bxo_predef_lookup(bxo_predef_idtable, bxo_predef_idkeys,
+                           idstr.data(), idstr.size());
+}
+
+inline int
+bxo_predef_name_index(const std::string&name)
+{
+  return bxo_predef_lookup(bxo_predef_nametable, bxo_predef_namekeys,
+                           name.data(), name.size());
+}
+
 #define BXO_VARGLOBAL(Nam) bxoglob_##Nam
 #define BXO_HAS_GLOBAL(Name,Idstr,Hid,Loid,Hash) \
   extern "C" std::shared_ptr<BxoObject> BXO_VARGLOBAL(Name);
@@ -1701,6 +3362,30 @@ enum Bxo_PredefHash_en
 
 
 
+std::shared_ptr<BxoObject>
+BxoObject::find_named_objref(const std::string&str)
+{
+  int pix = bxo_predef_name_index(str);
+  if (pix >= 0)
+    {
+      BxoObject* pob = _predefnamed_[pix];
+      return pob?pob->shared_from_this():nullptr;
+    }
+  auto it = _namedict_.find(str);
+  if (it != _namedict_.end())
+    return it->second;
+  else return nullptr;
+} // end BxoObject::find_named_objref
+
+std::shared_ptr<BxoObject>
+BxoLoader::find_loaded_predefobj(const std::string& str)
+{
+  int pix = bxo_predef_idstr_index(str);
+  if (pix >= 0 && *bxo_predef_vars[pix])
+    return *bxo_predef_vars[pix];
+  return find_loadedobj(str);
+} // end BxoLoader::find_loaded_predefobj
+
 ////////////////
 class BxoPayload
 {
@@ -1710,10 +3395,12 @@ class BxoPayload
   friend class std::unique_ptr<BxoPayload>;
   friend class std::shared_ptr<BxoObject>;
   BxoObject*const _owner;
+  /// the kind_ob, cached by kind_obptr; it never changes
+  mutable std::atomic<BxoObject*> _paylkindobp;
 protected:
   struct PayloadTag {};
-  BxoPayload(BxoObject& own, PayloadTag) : _owner(&own) {};
-  BxoPayload(BxoObject& own, BxoLoader&) : _owner(&own) {};
+  BxoPayload(BxoObject& own, PayloadTag) : _owner(&own), _paylkindobp(nullptr) {};
+  BxoPayload(BxoObject& own, BxoLoader&) : _owner(&own), _paylkindobp(nullptr) {};
 public:
   typedef BxoPayload*loader_create_sigt (BxoObject*,BxoLoader*);
   // each Payload class Foo of kind object of id KindId comes with a function
@@ -1724,15 +3411,54 @@ public:
   BxoPayload(const BxoPayload&) = delete;
   virtual std::shared_ptr<BxoObject> kind_ob() const =0;
   virtual std::shared_ptr<BxoObject> module_ob() const =0;
+  /// with several dump jobs, scan_payload_content and
+  /// emit_payload_content run concurrently on distinct payloads; they
+  /// should only read their payload and call the dumper's
+  /// scan_dumpable, do_after_scan, is_dumpable or emit_blob
   virtual void scan_payload_content(BxoDumper&) const =0;
   virtual const BxoJson emit_payload_content(BxoDumper&) const =0;
+  /// payloads may stream the JSON of emit_payload_content and return
+  /// true; otherwise the dumper writes what emit_payload_content gives
+  virtual bool write_payload_content(BxoDumper&, BxoJsonWriter&) const
+  {
+    return false;
+  };
   virtual void load_payload_content(const BxoJson&, BxoLoader&) =0;
+  /// payloads may parse their JSON content straight from the reader
+  /// and return true; otherwise, without having read anything, they
+  /// return false and get it by load_payload_content
+  virtual bool read_payload_content(BxoJsonReader&, BxoLoader&)
+  {
+    return false;
+  };
   BxoObject* owner () const
   {
     return _owner;
   };
+  /// the kind object, without copying a shared pointer after the first call
+  BxoObject* kind_obptr () const
+  {
+    BxoObject* kobp = _paylkindobp.load(std::memory_order_relaxed);
+    if (BXO_UNLIKELY(!kobp))
+      {
+        kobp = kind_ob().get();
+        _paylkindobp.store(kobp, std::memory_order_relaxed);
+      }
+    return kobp;
+  };
 };        // end BxoPayload
 
+template <class PaylClass> BxoTry<PaylClass*>
+BxoObject::trycast_payload() const noexcept
+{
+  BxoPayload* py = _payl.get();
+  if (!py)
+    return BxoTry<PaylClass*> {nullptr, BxoAccess::NoPayload};
+  if (py->kind_obptr() != PaylClass::payload_kind())
+    return BxoTry<PaylClass*> {nullptr, BxoAccess::WrongPayload};
+  return BxoTry<PaylClass*> {static_cast<PaylClass*>(py), BxoAccess::Ok};
+} // end BxoObject::trycast_payload
+
 
 size_t
 BxoHashObjSharedPtr::operator() (const std::shared_ptr<BxoObject>& po) const
@@ -1783,15 +3509,20 @@ bool BxoLessObjPtr::operator() (const BxoObject*lp, const BxoObject*rp) const
   return lp->less(*rp);
 }
 
-bool BxoSequence::less_than_sequence(const BxoSequence&r) const
+void BxoSequence::fill_keys(void)
 {
-  if (BXO_UNLIKELY(_hash == r._hash))
-    {
-      if (same_sequence(r)) return false;
-    }
-  return std::lexicographical_compare(_seq+0, _seq+_len, r._seq+0, r._seq+r._len, BxoLessObjSharedPtr {});
+  unsigned char*keys = new unsigned char[_len*BXO_OBJKEY_SIZE+1];
+  for (unsigned ix=0; ix<_len; ix++)
+    _seq[ix]->pack_key(keys+ix*BXO_OBJKEY_SIZE);
+  _keys = keys;
 }
 
+bool
+BxoDumper::is_dumpable(BxoObject*pob) const
+{
+  return pob && pob->_dumpepoch.load(std::memory_order_relaxed) == _du_epoch;
+} // end BxoDumper::is_dumpable
+
 void
 BxoSequence::sequence_scan_dump(BxoDumper&du) const
 {
@@ -1818,6 +3549,16 @@ bool BxoVal::equal (const BxoVal&r) const
       return _tup->same_tuple(*r._tup);
     case BxoVKind::SetK:
       return _set->same_set(*r._set);
+    case BxoVKind::IntVecK:
+      return _ivec->same_packed(*r._ivec);
+    case BxoVKind::DoubleVecK:
+      return _dvec->same_packed(*r._dvec);
+    case BxoVKind::BlobK:
+      return _blob->same_blob(*r._blob);
+    case BxoVKind::RopeK:
+      return _rope->same_rope(*r._rope);
+    case BxoVKind::MapK:
+      return _omap->same_map(*r._omap);
     }
 }
 
@@ -1829,26 +3570,67 @@ inline BxoHash_t bxo_int_hash(intptr_t i)
   return h;
 }
 
-BxoHash_t BxoVal::hash() const
+template <typename F> auto
+BxoVal::visit(F&&f) const -> decltype(f(TagNone {}, nullptr))
 {
   switch (_kind)
     {
     case BxoVKind::NoneK:
-      return 0;
+      break;
     case BxoVKind::IntK:
-      return bxo_int_hash(_int);
+      return f(TagInt {}, _int);
     case BxoVKind::StringK:
-      return _str->hash();
+      return f(TagString {}, *_str);
     case BxoVKind::ObjectK:
-      return _obj->hash();
-    case BxoVKind::TupleK:
-      return _tup->hash();
+      return f(TagObject {}, _obj);
     case BxoVKind::SetK:
-      return _set->hash();
+      return f(TagSet {}, *_set);
+    case BxoVKind::TupleK:
+      return f(TagTuple {}, *_tup);
+    case BxoVKind::IntVecK:
+      return f(TagIntVec {}, *_ivec);
+    case BxoVKind::DoubleVecK:
+      return f(TagDoubleVec {}, *_dvec);
+    case BxoVKind::BlobK:
+      return f(TagBlob {}, *_blob);
+    case BxoVKind::RopeK:
+      return f(TagRope {}, *_rope);
+    case BxoVKind::MapK:
+      return f(TagMap {}, *_omap);
     }
-}
+  return f(TagNone {}, nullptr);
+} // end BxoVal::visit
 
-BxoHash_t
+class BxoHashVisitor
+{
+public:
+  BxoHash_t operator () (BxoVal::TagNone, std::nullptr_t) const
+  {
+    return 0;
+  };
+  BxoHash_t operator () (BxoVal::TagInt, intptr_t i) const
+  {
+    return bxo_int_hash(i);
+  };
+  BxoHash_t operator () (BxoVal::TagObject,
+                         const std::shared_ptr<BxoObject>&obp) const
+  {
+    return obp->hash();
+  };
+  /// every boxed data knows its hash
+  template <typename Tag, typename Data>
+  BxoHash_t operator () (Tag, const Data&d) const
+  {
+    return d.hash();
+  };
+};        // end BxoHashVisitor
+
+BxoHash_t BxoVal::hash() const
+{
+  return visit(BxoHashVisitor {});
+} // end BxoVal::hash
+
+constexpr BxoHash_t
 BxoObject::hash_from_hid_loid (Bxo_hid_t hid, Bxo_loid_t loid)
 {
   if (hid == 0 && loid == 0)
@@ -1889,6 +3671,21 @@ BxoVSet::BxoVSet(const std::vector<BxoObject*>&vo)
 BxoVTuple::BxoVTuple(const BxoTuple& tup)
   :  BxoVal(TagTuple {},&tup) {}
 
+BxoVIntVec::BxoVIntVec(const BxoIntVec& ivec)
+  :  BxoVal(TagIntVec {},&ivec) {}
+
+BxoVDoubleVec::BxoVDoubleVec(const BxoDoubleVec& dvec)
+  :  BxoVal(TagDoubleVec {},&dvec) {}
+
+BxoVBlob::BxoVBlob(const BxoBlob& blob)
+  :  BxoVal(TagBlob {},&blob) {}
+
+BxoVRope::BxoVRope(const BxoRope& rope)
+  :  BxoVal(TagRope {},&rope) {}
+
+BxoVMap::BxoVMap(const BxoMap& map)
+  :  BxoVal(TagMap {},&map) {}
+
 
 inline std::ostream& operator << (std::ostream& os,  std::shared_ptr<BxoObject> pob)
 {
@@ -1916,35 +3713,86 @@ inline std::ostream& operator << (std::ostream& os, const BxoVal&v)
 ////////////////
 class BxoHashsetPayload final : public BxoPayload
 {
-  std::unordered_set<std::shared_ptr<BxoObject>,BxoHashObjSharedPtr> _hset;
+  /// an open-addressed table, with linear probing, of the pinned
+  /// numbers of the elements; 0 marks an empty slot; the capacity is
+  /// 0 or a power of two, 1<<_hslog
+  std::vector<uint32_t> _hsnums;
+  unsigned _hscount;
+  unsigned _hslog;
+  unsigned num_start(uint32_t num) const
+  {
+    return (unsigned)((num * UINT32_C(2654435761)) >> (32 - _hslog));
+  };
+  int num_index(uint32_t num) const;
+  void hs_erase_at(unsigned gap);
 public:
+  class const_iterator
+  {
+    const uint32_t* _itcur;
+    const uint32_t* _itend;
+    void skip_empty()
+    {
+      while (_itcur < _itend && *_itcur == 0) _itcur++;
+    };
+  public:
+    const_iterator(const uint32_t*cur, const uint32_t*end)
+      : _itcur(cur), _itend(end)
+    {
+      skip_empty();
+    };
+    BxoObject* operator * () const
+    {
+      return BxoObject::find_from_obnum(*_itcur);
+    };
+    const_iterator& operator ++ ()
+    {
+      _itcur++;
+      skip_empty();
+      return *this;
+    };
+    bool operator == (const const_iterator&r) const
+    {
+      return _itcur == r._itcur;
+    };
+    bool operator != (const const_iterator&r) const
+    {
+      return _itcur != r._itcur;
+    };
+  };
+  static BxoObject* payload_kind()
+  {
+    return BXO_VARPREDEF(payload_hashset).get();
+  };
   virtual std::shared_ptr<BxoObject> kind_ob() const;
   virtual std::shared_ptr<BxoObject> module_ob() const;
   virtual void scan_payload_content(BxoDumper&) const;
   virtual const BxoJson emit_payload_content(BxoDumper&) const;
+  virtual bool write_payload_content(BxoDumper&, BxoJsonWriter&) const;
   virtual void load_payload_content(const BxoJson&, BxoLoader&);
+  virtual bool read_payload_content(BxoJsonReader&, BxoLoader&);
   BxoHashsetPayload(BxoObject& own);
   virtual ~BxoHashsetPayload();
-  void add(std::shared_ptr<BxoObject> pob)
+  void reserve(unsigned nbel);
+  void add(std::shared_ptr<BxoObject> pob);
+  void remove(std::shared_ptr<BxoObject> pob);
+  BxoVal vset() const;
+  bool contains(std::shared_ptr<BxoObject> pob) const
   {
-    if (pob) _hset.insert(pob);
+    return pob && num_index(pob->obnum()) >= 0;
   };
-  void remove(std::shared_ptr<BxoObject> pob)
+  unsigned size() const
   {
-    if (pob) _hset.erase(pob);
+    return _hscount;
   };
-  BxoVal vset() const
+  const_iterator begin() const
   {
-    return BxoVSet(_hset);
+    return const_iterator(_hsnums.data(), _hsnums.data()+_hsnums.size());
   };
-  bool contains(std::shared_ptr<BxoObject> pob) const
+  const_iterator end() const
   {
-    return pob && _hset.find(pob) != _hset.end();
+    return const_iterator(_hsnums.data()+_hsnums.size(), _hsnums.data()+_hsnums.size());
   };
-  void clear(void)
-  {
-    _hset.clear();
-  }
+  void clear(void);
 };        // end class BxoHashsetPayload
 
 #endif /*BASIXMO_HEADER*/
@@ -0,0 +1,477 @@
+// file binary.cc - the compact binary encoding of values and JSON
+
+/**   Copyright (C)  2016 Basile Starynkevitch
+
+      BASIXMO is free software; you can redistribute it and/or modify
+      it under the terms of the GNU General Public License as published by
+      the Free Software Foundation; either version 3, or (at your option)
+      any later version.
+
+      BASIXMO is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+      GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License
+      along with BASIXMO; see the file COPYING3.   If not see
+      <http://www.gnu.org/licenses/>.
+**/
+#include "basixmo.h"
+
+/// fixed width numbers are little endian, whatever the host
+static inline void
+bxo_put_le(std::string&buf, uint64_t u, unsigned nbytes)
+{
+  for (unsigned ix=0; ix<nbytes; ix++)
+    buf.push_back((char)((u >> (8*ix)) & 0xff));
+} // end bxo_put_le
+
+static inline uint64_t
+bxo_get_le(const char*p, unsigned nbytes)
+{
+  uint64_t u = 0;
+  for (unsigned ix=0; ix<nbytes; ix++)
+    u |= (uint64_t)(unsigned char)p[ix] << (8*ix);
+  return u;
+} // end bxo_get_le
+
+
+bool
+BxoBinaryEncoder::is_dumpable(BxoObject*pob) const
+{
+  if (!pob) return false;
+  return !_be_dumper || _be_dumper->is_dumpable(pob);
+} // end BxoBinaryEncoder::is_dumpable
+
+
+void
+BxoBinaryEncoder::put_double(double d)
+{
+  uint64_t u = 0;
+  static_assert(sizeof(u) == sizeof(d), "unexpected double size");
+  memcpy(&u, &d, sizeof(u));
+  bxo_put_le(_be_body, u, sizeof(u));
+} // end BxoBinaryEncoder::put_double
+
+
+void
+BxoBinaryEncoder::put_objref(BxoObject*pob)
+{
+  BXO_ASSERT(is_dumpable(pob), "put_objref: non dumpable object " << pob);
+  auto it = _be_idmap.find(pob);
+  if (it != _be_idmap.end())
+    {
+      put_varint(it->second);
+      return;
+    }
+  unsigned rk = _be_idvec.size();
+  _be_idvec.push_back(pob);
+  _be_idmap.insert({pob,rk});
+  put_varint(rk);
+} // end BxoBinaryEncoder::put_objref
+
+
+void
+BxoBinaryEncoder::put_json(const BxoJson&js)
+{
+  switch (js.type())
+    {
+    case Json::nullValue:
+      put_byte(BinJsNull);
+      return;
+    case Json::booleanValue:
+      put_byte(js.asBool()?BinJsTrue:BinJsFalse);
+      return;
+    case Json::intValue:
+      put_byte(BinJsInt);
+      put_zigzag(js.asInt64());
+      return;
+    case Json::uintValue:
+      put_byte(BinJsUInt);
+      put_varint(js.asUInt64());
+      return;
+    case Json::realValue:
+      put_byte(BinJsDouble);
+      put_double(js.asDouble());
+      return;
+    case Json::stringValue:
+    {
+      const char*strbeg = nullptr;
+      const char*strend = nullptr;
+      js.getString(&strbeg, &strend);
+      put_byte(BinJsString);
+      put_bytes(strbeg, strend - strbeg);
+      return;
+    }
+    case Json::arrayValue:
+    {
+      unsigned ln = js.size();
+      put_byte(BinJsArray);
+      put_varint(ln);
+      for (unsigned ix=0; ix<ln; ix++)
+        put_json(js[ix]);
+      return;
+    }
+    case Json::objectValue:
+    {
+      put_byte(BinJsObject);
+      put_varint(js.size());
+      for (auto it = js.begin(); it != js.end(); it++)
+        {
+          put_bytes(it.name());
+          put_json(*it);
+        }
+      return;
+    }
+    }
+  BXO_BACKTRACELOG("put_json: unexpected json " << js);
+  throw std::runtime_error("BxoBinaryEncoder::put_json unexpected json");
+} // end BxoBinaryEncoder::put_json
+
+
+std::string
+BxoBinaryEncoder::finish(void) const
+{
+  std::string res;
+  res.reserve(_be_body.size() + 12*_be_idvec.size() + 8);
+  res.push_back((char)BXO_BINARY_MAGIC);
+  res.push_back((char)BXO_BINARY_VERSION);
+  uint64_t nbid = _be_idvec.size();
+  while (nbid >= 0x80)
+    {
+      res.push_back((char)((nbid & 0x7f) | 0x80));
+      nbid >>= 7;
+    }
+  res.push_back((char)nbid);
+  for (BxoObject*pob : _be_idvec)
+    {
+      bxo_put_le(res, pob->hid(), sizeof(Bxo_hid_t));
+      bxo_put_le(res, pob->loid(), sizeof(Bxo_loid_t));
+    }
+  res.append(_be_body);
+  return res;
+} // end BxoBinaryEncoder::finish
+
+
+
+BxoBinaryDecoder::BxoBinaryDecoder(BxoJsonProcessor&proc, const char*buf, size_t sz)
+  : _bd_proc(proc),
+    _bd_cur((const unsigned char*)buf), _bd_end((const unsigned char*)buf+sz),
+    _bd_idvec()
+{
+  if (!is_binary(buf, sz))
+    fail("bad magic");
+  get_byte();
+  unsigned version = get_byte();
+  if (version != BXO_BINARY_VERSION)
+    {
+      BXO_BACKTRACELOG("BxoBinaryDecoder: unsupported version " << version);
+      throw std::runtime_error("BxoBinaryDecoder unsupported version");
+    }
+  constexpr unsigned idsize = sizeof(Bxo_hid_t)+sizeof(Bxo_loid_t);
+  uint64_t nbid = get_varint();
+  if (nbid > (uint64_t)(_bd_end - _bd_cur)/idsize)
+    fail("bad id table");
+  _bd_idvec.reserve(nbid);
+  for (uint64_t ix=0; ix<nbid; ix++)
+    {
+      const char*p = get_raw(idsize);
+      Bxo_hid_t hid = (Bxo_hid_t)bxo_get_le(p, sizeof(Bxo_hid_t));
+      Bxo_loid_t loid = (Bxo_loid_t)bxo_get_le(p+sizeof(Bxo_hid_t), sizeof(Bxo_loid_t));
+      if (!hid || !loid)
+        fail("bad id");
+      _bd_idvec.push_back(proc.obj_from_hid_loid(hid, loid));
+    }
+} // end BxoBinaryDecoder::BxoBinaryDecoder
+
+
+void
+BxoBinaryDecoder::fail(const char*why) const
+{
+  BXO_BACKTRACELOG("binary decoding failure: " << why
+                   << " with " << (long)(_bd_end - _bd_cur) << " bytes left");
+  throw std::runtime_error(std::string {"BxoBinaryDecoder failure: "} + why);
+} // end BxoBinaryDecoder::fail
+
+
+double
+BxoBinaryDecoder::get_double(void)
+{
+  uint64_t u = bxo_get_le(get_raw(sizeof(u)), sizeof(u));
+  double d = 0.0;
+  memcpy(&d, &u, sizeof(d));
+  return d;
+} // end BxoBinaryDecoder::get_double
+
+
+BxoObject*
+BxoBinaryDecoder::get_objref(void)
+{
+  uint64_t rk = get_varint();
+  if (BXO_UNLIKELY(rk >= _bd_idvec.size()))
+    fail("bad object rank");
+  return _bd_idvec[rk];
+} // end BxoBinaryDecoder::get_objref
+
+
+BxoJson
+BxoBinaryDecoder::get_json(void)
+{
+  switch (get_byte())
+    {
+    case BxoBinaryEncoder::BinJsNull:
+      return BxoJson::nullSingleton();
+    case BxoBinaryEncoder::BinJsFalse:
+      return BxoJson(false);
+    case BxoBinaryEncoder::BinJsTrue:
+      return BxoJson(true);
+    case BxoBinaryEncoder::BinJsInt:
+      return BxoJson((Json::Int64)get_zigzag());
+    case BxoBinaryEncoder::BinJsUInt:
+      return BxoJson((Json::UInt64)get_varint());
+    case BxoBinaryEncoder::BinJsDouble:
+      return BxoJson(get_double());
+    case BxoBinaryEncoder::BinJsString:
+    {
+      size_t ln = 0;
+      const char*s = get_bytes(ln);
+      return BxoJson(s, s+ln);
+    }
+    case BxoBinaryEncoder::BinJsArray:
+    {
+      size_t ln = get_count();
+      BxoJson jarr {Json::arrayValue};
+      jarr.resize(ln);
+      for (size_t ix=0; ix<ln; ix++)
+        jarr[(Json::ArrayIndex)ix] = get_json();
+      return jarr;
+    }
+    case BxoBinaryEncoder::BinJsObject:
+    {
+      size_t ln = get_count();
+      BxoJson jobj {Json::objectValue};
+      for (size_t ix=0; ix<ln; ix++)
+        {
+          size_t nln = 0;
+          const char*nam = get_bytes(nln);
+          jobj[std::string(nam, nln)] = get_json();
+        }
+      return jobj;
+    }
+    }
+  fail("bad json tag");
+} // end BxoBinaryDecoder::get_json
+
+
+
+void
+BxoVal::to_binary(BxoBinaryEncoder&enc) const
+{
+  switch (_kind)
+    {
+    case BxoVKind::NoneK:
+      enc.put_byte(BxoBinaryEncoder::BinNone);
+      return;
+    case BxoVKind::IntK:
+      enc.put_byte(BxoBinaryEncoder::BinInt);
+      enc.put_zigzag(_int);
+      return;
+    case BxoVKind::StringK:
+      enc.put_byte(BxoBinaryEncoder::BinString);
+      enc.put_bytes(_str->string());
+      return;
+    case BxoVKind::ObjectK:
+      if (enc.is_dumpable(_obj))
+        {
+          enc.put_byte(BxoBinaryEncoder::BinObject);
+          enc.put_objref(_obj.get());
+        }
+      else
+        enc.put_byte(BxoBinaryEncoder::BinNone);
+      return;
+    case BxoVKind::SetK:
+    case BxoVKind::TupleK:
+    {
+      const BxoSequence*pseq = (_kind==BxoVKind::SetK)
+                               ?static_cast<const BxoSequence*>(_set.get())
+                               :static_cast<const BxoSequence*>(_tup.get());
+      unsigned nbdumpable = 0;
+      for (auto& comp : *pseq)
+        if (enc.is_dumpable(comp))
+          nbdumpable++;
+      enc.put_byte((_kind==BxoVKind::SetK)?BxoBinaryEncoder::BinSet:BxoBinaryEncoder::BinTuple);
+      enc.put_varint(nbdumpable);
+      for (auto& comp : *pseq)
+        if (enc.is_dumpable(comp))
+          enc.put_objref(comp.get());
+      return;
+    }
+    case BxoVKind::IntVecK:
+    {
+      unsigned ln = _ivec->length();
+      const int64_t*arr = _ivec->data();
+      enc.put_byte(BxoBinaryEncoder::BinIntVec);
+      enc.put_varint(ln);
+      for (unsigned ix=0; ix<ln; ix++)
+        enc.put_zigzag(arr[ix]);
+      return;
+    }
+    case BxoVKind::DoubleVecK:
+    {
+      unsigned ln = _dvec->length();
+      const double*arr = _dvec->data();
+      enc.put_byte(BxoBinaryEncoder::BinDoubleVec);
+      enc.put_varint(ln);
+      for (unsigned ix=0; ix<ln; ix++)
+        enc.put_double(arr[ix]);
+      return;
+    }
+    case BxoVKind::BlobK:
+      // without a dumper, there is no side file to write
+      if (_blob->size() <= BXO_BLOB_INLINE_MAX || !enc.dumper())
+        {
+          enc.put_byte(BxoBinaryEncoder::BinBlob);
+          enc.put_bytes(_blob->data(), _blob->size());
+        }
+      else
+        {
+          enc.put_byte(BxoBinaryEncoder::BinBlobFile);
+          enc.put_bytes(enc.dumper()->emit_blob(*_blob));
+          enc.put_varint(_blob->size());
+          enc.put_varint(_blob->hash());
+        }
+      return;
+    case BxoVKind::RopeK:
+      enc.put_byte(BxoBinaryEncoder::BinRope);
+      enc.put_varint(_rope->length());
+      _rope->each_chunk([&](const char*s, size_t ln)
+      {
+        enc.put_raw(s, ln);
+      });
+      return;
+    case BxoVKind::MapK:
+    {
+      // in the hash order of the trie, which only depends on the content
+      std::vector<std::pair<BxoObject*,const BxoVal*>> pairs;
+      pairs.reserve(_omap->size());
+      _omap->each([&](const std::shared_ptr<BxoObject>&pob, const BxoVal&val)
+      {
+        if (enc.is_dumpable(pob))
+          pairs.push_back({pob.get(),&val});
+      });
+      enc.put_byte(BxoBinaryEncoder::BinMap);
+      enc.put_varint(pairs.size());
+      for (auto& p : pairs)
+        {
+          enc.put_objref(p.first);
+          p.second->to_binary(enc);
+        }
+      return;
+    }
+    }
+  BXO_BACKTRACELOG("to_binary: unexpected kind " << (int)_kind);
+  throw std::runtime_error("BxoVal::to_binary unexpected kind");
+} // end BxoVal::to_binary
+
+
+
+BxoVal
+BxoVal::from_binary(BxoBinaryDecoder&dec)
+{
+  uint8_t tag = dec.get_byte();
+  switch (tag)
+    {
+    case BxoBinaryEncoder::BinNone:
+      return BxoVNone();
+    case BxoBinaryEncoder::BinInt:
+      return BxoVInt(dec.get_zigzag());
+    case BxoBinaryEncoder::BinString:
+    {
+      size_t ln = 0;
+      const char*s = dec.get_bytes(ln);
+      if (!bxo_utf8_valid(s, ln))
+        dec.fail("invalid UTF-8 string");
+      return BxoVString(std::string(s, ln));
+    }
+    case BxoBinaryEncoder::BinObject:
+    {
+      BxoObject*pob = dec.get_objref();
+      if (!pob)
+        dec.fail("unknown object");
+      return BxoVObj(pob->shared_from_this());
+    }
+    case BxoBinaryEncoder::BinSet:
+    case BxoBinaryEncoder::BinTuple:
+    {
+      size_t ln = dec.get_count();
+      std::vector<BxoObject*> vec;
+      vec.reserve(ln);
+      for (size_t ix=0; ix<ln; ix++)
+        {
+          BxoObject*pob = dec.get_objref();
+          if (pob)
+            vec.push_back(pob);
+        }
+      if (tag == BxoBinaryEncoder::BinSet)
+        return BxoVal(TagSet {}, BxoSet::make_set(vec));
+      return BxoVal(TagTuple {}, BxoTuple::make_tuple(vec));
+    }
+    case BxoBinaryEncoder::BinIntVec:
+    {
+      size_t ln = dec.get_count();
+      std::vector<int64_t> vec(ln);
+      for (size_t ix=0; ix<ln; ix++)
+        vec[ix] = dec.get_zigzag();
+      return BxoVIntVec(vec);
+    }
+    case BxoBinaryEncoder::BinDoubleVec:
+    {
+      size_t ln = dec.get_count();
+      std::vector<double> vec(ln);
+      for (size_t ix=0; ix<ln; ix++)
+        vec[ix] = dec.get_double();
+      return BxoVDoubleVec(vec);
+    }
+    case BxoBinaryEncoder::BinBlob:
+    {
+      size_t ln = 0;
+      const char*s = dec.get_bytes(ln);
+      return BxoVBlob(s, ln);
+    }
+    case BxoBinaryEncoder::BinBlobFile:
+    {
+      size_t nln = 0;
+      const char*nam = dec.get_bytes(nln);
+      std::string filnam(nam, nln);
+      size_t sz = dec.get_varint();
+      BxoHash_t h = (BxoHash_t)dec.get_varint();
+      if (filnam.compare(0, strlen(BXO_BLOB_FILE_PREFIX), BXO_BLOB_FILE_PREFIX)
+          || filnam.find('/') != std::string::npos)
+        dec.fail("bad blob file name");
+      // like for JSON, the side file is mapped at first access
+      auto pblob = BxoBlob::map_blob(dec.processor().side_file_path(filnam), sz, h);
+      return BxoVBlob(*pblob);
+    }
+    case BxoBinaryEncoder::BinRope:
+    {
+      size_t ln = dec.get_varint();
+      const char*s = dec.get_raw(ln);
+      auto prope = BxoRope::make_rope(s, ln);
+      return BxoVRope(*prope);
+    }
+    case BxoBinaryEncoder::BinMap:
+    {
+      size_t ln = dec.get_count();
+      std::vector<BxoMap::pair_t> pairs;
+      pairs.reserve(ln);
+      for (size_t ix=0; ix<ln; ix++)
+        {
+          BxoObject*pob = dec.get_objref();
+          BxoVal val = from_binary(dec);
+          if (pob)
+            pairs.push_back({pob->shared_from_this(), val});
+        }
+      return BxoVMap(pairs);
+    }
+    }
+  dec.fail("bad value tag");
+} // end BxoVal::from_binary
@@ -52,6 +52,10 @@ public:
   BxoMainWindowPayl(BxoObject*own, std::shared_ptr<BxoObject> grascenob);
   BxoMainWindowPayl(BxoObject*own, BxoMainGraphicsScenePayl*grascenpayl);
   ~BxoMainWindowPayl();
+  static BxoObject* payload_kind()
+  {
+    return BXO_VARPREDEF(payload_main_window).get();
+  };
   virtual std::shared_ptr<BxoObject> kind_ob() const
   {
     return BXO_VARPREDEF(payload_main_window);
@@ -427,6 +431,10 @@ public:
   {
     return pob && _shownobjmap.find(pob) != _shownobjmap.end();
   }
+  static BxoObject* payload_kind()
+  {
+    return BXO_VARPREDEF(payload_main_graphics_scene).get();
+  };
   virtual std::shared_ptr<BxoObject> kind_ob() const
   {
     return BXO_VARPREDEF(payload_main_graphics_scene);
@@ -534,7 +542,7 @@ BxoMainWindowPayl::BxoMainWindowPayl(BxoObject*own, std::shared_ptr<BxoObject> g
     _grascenob = grascenob = BxoObject::make_objref();
   if (!grascenob->payload())
     grscenpy = _grascenob->put_payload<BxoMainGraphicsScenePayl>();
-  else if (!(grscenpy=grascenob->dyncast_payload<BxoMainGraphicsScenePayl>()))
+  else if (!(grscenpy=grascenob->trycast_payload<BxoMainGraphicsScenePayl>().val))
     {
       BXO_BACKTRACELOG("BxoMainWindowPayl owned by " << own << " with bad grascenob " << grascenob
                        << " of payload kind " << grascenob->payload()->kind_ob());
@@ -604,7 +612,7 @@ BxoMainWindowPayl::~BxoMainWindowPayl()
 std::shared_ptr<BxoObject>
 BxoMainWindowPayl::grascen_ob() const
 {
-  if (_grascenob && _grascenob->dyncast_payload<BxoMainGraphicsScenePayl>())
+  if (_grascenob && _grascenob->trycast_payload<BxoMainGraphicsScenePayl>())
     return _grascenob;
   else
     return nullptr;
@@ -741,7 +749,6 @@ BxoMainGraphicsScenePayl* BxoAnyShow::gscene() const
 QGraphicsItem*
 BxoMainGraphicsScenePayl::value_gitem(const BxoVal&val, int depth)
 {
-  bool got_set = false;
   switch (val.kind())
     {
     case BxoVKind::NoneK:
@@ -787,15 +794,32 @@ BxoMainGraphicsScenePayl::value_gitem(const BxoVal&val, int depth)
       auto shob = objref_gitem(val.as_object(), depth);
       return shob->gitem();
     }
+    case BxoVKind::RopeK:
+    {
+      auto qit = new QGraphicsTextItem(val.get_rope()->to_string().c_str());
+      qit->setFont(*_bigstringfont_);
+      qit->setDefaultTextColor(*_bigstringcolor_);
+      QFontMetrics fm(*_bigstringfont_);
+      qit->setTextWidth(fm.averageCharWidth()*4*64/3);
+      return qit;
+    }
     case BxoVKind::SetK:
-      got_set = true;
-    // failthru
     case BxoVKind::TupleK:
+    case BxoVKind::IntVecK:
+    case BxoVKind::DoubleVecK:
+    case BxoVKind::BlobK:
+    case BxoVKind::MapK:
     {
-      auto seq = val.get_sequence();
-      unsigned len = seq->length();
+      std::ostringstream outs;
+      val.out(outs);
+      auto qit = new QGraphicsSimpleTextItem(outs.str().c_str());
+      qit->setFont(*_intfont_);
+      qit->setBrush(*_intbrush_);
+      return qit;
     }
     }
+  BXO_BACKTRACELOG("value_gitem: unexpected kind " << (int)val.kind());
+  throw std::runtime_error("BxoMainGraphicsScenePayl::value_gitem unexpected kind");
 } // end  BxoMainGraphicsScenePayl::value_gitem
 
 
@@ -850,11 +874,25 @@ void bxo_gui_init(QApplication*qapp)
   BXO_VERBOSELOG("empty mainwinob=" << mainwinob);
   mainwinob->put_payload<BxoMainWindowPayl>();
   BXO_VERBOSELOG("mainwinob=" << mainwinob);
-  auto mainwin = mainwinob->dyncast_payload<BxoMainWindowPayl>();
+  auto trywin = mainwinob->trycast_payload<BxoMainWindowPayl>();
+  if (!trywin)
+    {
+      BXO_BACKTRACELOG("bxo_gui_init mainwinob=" << mainwinob << " without main window payload, access#"
+                       << (int)trywin.err);
+      throw std::runtime_error("bxo_gui_init without main window payload");
+    }
+  auto mainwin = trywin.val;
   mainwin->show();
   mainwin->resize(300,200);
   BXO_VERBOSELOG("shown mainwin=" << mainwin << " of " << bxo_demangled_typename(typeid(*mainwin)));
-  auto theguihset = BXO_VARPREDEF(the_GUI)->dyncast_payload<BxoHashsetPayload>();
+  auto tryhset = BXO_VARPREDEF(the_GUI)->trycast_payload<BxoHashsetPayload>();
+  if (!tryhset)
+    {
+      BXO_BACKTRACELOG("bxo_gui_init the_GUI=" << BXO_VARPREDEF(the_GUI) << " without hashset payload, access#"
+                       << (int)tryhset.err);
+      throw std::runtime_error("bxo_gui_init the_GUI without hashset payload");
+    }
+  auto theguihset = tryhset.val;
   theguihset->add(mainwinob);
   BXO_VERBOSELOG("bxo_gui_init end");
 } // end bxo_gui_init
@@ -866,15 +904,29 @@ bxo_gui_stop(QApplication*qapp)
 {
   BXO_BACKTRACELOG("bxo_gui_stop start qapp=" << qapp);
   BXO_ASSERT(qapp != nullptr, "no qapp");
-  auto theguihset = BXO_VARPREDEF(the_GUI)->dyncast_payload<BxoHashsetPayload>();
+  auto tryhset = BXO_VARPREDEF(the_GUI)->trycast_payload<BxoHashsetPayload>();
+  if (!tryhset)
+    {
+      BXO_BACKTRACELOG("bxo_gui_stop the_GUI=" << BXO_VARPREDEF(the_GUI) << " without hashset payload, access#"
+                       << (int)tryhset.err);
+      throw std::runtime_error("bxo_gui_stop the_GUI without hashset payload");
+    }
+  auto theguihset = tryhset.val;
   {
-    auto pset = theguihset->vset().get_set();
+    BxoVal vset = theguihset->vset();
+    auto pset = vset.get_set();
     BXO_VERBOSELOG("bxo_gui_stop pset length=" << pset->length() << "; pset=" << pset);
     for (auto pob: *pset)
       {
         BXO_VERBOSELOG("bxo_gui_stop loop pob=" << pob);
-        auto winp = pob->dyncast_payload<BxoMainWindowPayl>();
-        BXO_ASSERT(winp != nullptr, "no winp");
+        auto trywin = pob->trycast_payload<BxoMainWindowPayl>();
+        if (!trywin)
+          {
+            BXO_BACKTRACELOG("bxo_gui_stop GUI object " << pob << " without main window payload, access#"
+                             << (int)trywin.err);
+            throw std::runtime_error("bxo_gui_stop GUI object without main window payload");
+          }
+        auto winp = trywin.val;
         BXO_VERBOSELOG("bxo_gui_stop winp=" << winp << " pob=" << pob);
         winp->ask_when_closing(false);
         winp->close();
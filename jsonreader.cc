@@ -0,0 +1,357 @@
+// file jsonreader.cc - the streaming JSON reader
+
+/**   Copyright (C)  2016 Basile Starynkevitch
+
+      BASIXMO is free software; you can redistribute it and/or modify
+      it under the terms of the GNU General Public License as published by
+      the Free Software Foundation; either version 3, or (at your option)
+      any later version.
+
+      BASIXMO is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+      GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License
+      along with BASIXMO; see the file COPYING3.   If not see
+      <http://www.gnu.org/licenses/>.
+**/
+#include "basixmo.h"
+
+/// The reader accepts the JSON of Json::Reader in strict mode, with
+/// the same unescaping of strings; it only checks the syntax of what
+/// its callers skip, and leaves the values of other shapes to it.
+
+void
+BxoJsonReader::fail(const char*why) const
+{
+  size_t nearlen = std::min<size_t>(_jr_end - _jr_cur, 40);
+  BXO_BACKTRACELOG("JSON reading failure: " << why
+                   << " at offset " << (long)(_jr_cur - _jr_start)
+                   << " near " << std::string(_jr_cur, nearlen));
+  throw std::runtime_error(std::string {"BxoJsonReader failure: "} + why);
+} // end BxoJsonReader::fail
+
+
+void
+BxoJsonReader::expect_literal(const char*lit, size_t ln)
+{
+  if ((size_t)(_jr_end - _jr_cur) < ln || memcmp(_jr_cur, lit, ln))
+    fail("bad literal");
+  _jr_cur += ln;
+} // end BxoJsonReader::expect_literal
+
+
+/// after the opening, an element or a member, read the comma before
+/// the next one, or the closing brace or bracket and give false
+bool
+BxoJsonReader::next_separator(char closing)
+{
+  char c = peek();
+  if (c == closing)
+    {
+      _jr_cur++;
+      _jr_opened = false;
+      return false;
+    }
+  if (_jr_opened)
+    {
+      _jr_opened = false;
+      return true;
+    }
+  if (c != ',')
+    fail((closing == '}') ? "expecting a comma or }" : "expecting a comma or ]");
+  _jr_cur++;
+  return true;
+} // end BxoJsonReader::next_separator
+
+
+void
+BxoJsonReader::begin_object(void)
+{
+  if (peek() != '{')
+    fail("expecting an object");
+  _jr_cur++;
+  _jr_opened = true;
+} // end BxoJsonReader::begin_object
+
+bool
+BxoJsonReader::next_key(void)
+{
+  if (!next_separator('}'))
+    return false;
+  if (peek() != '"')
+    fail("expecting a key");
+  get_string(_jr_key, _jr_keylen);
+  if (peek() != ':')
+    fail("expecting a colon");
+  _jr_cur++;
+  return true;
+} // end BxoJsonReader::next_key
+
+void
+BxoJsonReader::begin_array(void)
+{
+  if (peek() != '[')
+    fail("expecting an array");
+  _jr_cur++;
+  _jr_opened = true;
+} // end BxoJsonReader::begin_array
+
+
+void
+BxoJsonReader::get_null(void)
+{
+  skip_spaces();
+  expect_literal("null", 4);
+} // end BxoJsonReader::get_null
+
+
+int64_t
+BxoJsonReader::get_int(void)
+{
+  skip_spaces();
+  const char* p = _jr_cur;
+  bool neg = false;
+  if (p < _jr_end && *p == '-')
+    {
+      neg = true;
+      p++;
+    }
+  if (p >= _jr_end || *p < '0' || *p > '9')
+    fail("expecting a number");
+  // like Json::Value::asInt64, reject what does not fit an int64_t
+  const uint64_t lim = neg ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+  uint64_t u = 0;
+  while (p < _jr_end && *p >= '0' && *p <= '9')
+    {
+      unsigned d = *p - '0';
+      if (BXO_UNLIKELY(u > (lim - d)/10))
+        fail("integer out of range");
+      u = u*10 + d;
+      p++;
+    }
+  if (p < _jr_end && (*p == '.' || *p == 'e' || *p == 'E'))
+    fail("expecting an integer");
+  _jr_cur = p;
+  return neg ? (int64_t)(0 - u) : (int64_t)u;
+} // end BxoJsonReader::get_int
+
+
+void
+BxoJsonReader::get_string(const char*&s, size_t&ln)
+{
+  if (peek() != '"')
+    fail("expecting a string");
+  const char* startp = ++_jr_cur;
+  const char* p = startp;
+  while (p < _jr_end && *p != '"' && *p != '\\')
+    p++;
+  if (BXO_LIKELY(p < _jr_end && *p == '"'))
+    {
+      s = startp;
+      ln = p - startp;
+      _jr_cur = p+1;
+      return;
+    }
+  unescape_string(s, ln);
+} // end BxoJsonReader::get_string
+
+
+/// the four hexadecimal digits of a \u escape
+static bool
+bxo_json_hex4(const char*p, unsigned&cp)
+{
+  cp = 0;
+  for (int ix=0; ix<4; ix++)
+    {
+      char c = p[ix];
+      cp <<= 4;
+      if (c >= '0' && c <= '9') cp += c - '0';
+      else if (c >= 'a' && c <= 'f') cp += c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F') cp += c - 'A' + 10;
+      else return false;
+    }
+  return true;
+} // end bxo_json_hex4
+
+
+/// the string from _jr_cur has escapes, so is unescaped in _jr_strbuf
+void
+BxoJsonReader::unescape_string(const char*&s, size_t&ln)
+{
+  _jr_strbuf.clear();
+  const char* p = _jr_cur;
+  for (;;)
+    {
+      const char* q = p;
+      while (q < _jr_end && *q != '"' && *q != '\\')
+        q++;
+      _jr_strbuf.append(p, q-p);
+      _jr_cur = q;
+      if (q >= _jr_end)
+        fail("unterminated string");
+      if (*q == '"')
+        break;
+      if (q+1 >= _jr_end)
+        fail("unterminated escape");
+      p = q+2;
+      switch (q[1])
+        {
+        case '"':
+        case '/':
+        case '\\':
+          _jr_strbuf.push_back(q[1]);
+          break;
+        case 'b':
+          _jr_strbuf.push_back('\b');
+          break;
+        case 'f':
+          _jr_strbuf.push_back('\f');
+          break;
+        case 'n':
+          _jr_strbuf.push_back('\n');
+          break;
+        case 'r':
+          _jr_strbuf.push_back('\r');
+          break;
+        case 't':
+          _jr_strbuf.push_back('\t');
+          break;
+        case 'u':
+        {
+          unsigned cp = 0;
+          if (_jr_end - p < 4 || !bxo_json_hex4(p, cp))
+            fail("bad unicode escape");
+          p += 4;
+          // as Json::Reader, a high surrogate takes the next escape
+          if (cp >= 0xD800 && cp <= 0xDBFF)
+            {
+              unsigned lowcp = 0;
+              if (_jr_end - p < 6 || p[0] != '\\' || p[1] != 'u' || !bxo_json_hex4(p+2, lowcp))
+                fail("bad unicode surrogate pair");
+              p += 6;
+              cp = 0x10000 + ((cp & 0x3FF) << 10) + (lowcp & 0x3FF);
+            }
+          if (cp < 0x80)
+            _jr_strbuf.push_back((char)cp);
+          else if (cp < 0x800)
+            {
+              _jr_strbuf.push_back((char)(0xC0 | (cp >> 6)));
+              _jr_strbuf.push_back((char)(0x80 | (cp & 0x3F)));
+            }
+          else if (cp < 0x10000)
+            {
+              _jr_strbuf.push_back((char)(0xE0 | (cp >> 12)));
+              _jr_strbuf.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+              _jr_strbuf.push_back((char)(0x80 | (cp & 0x3F)));
+            }
+          else
+            {
+              _jr_strbuf.push_back((char)(0xF0 | (cp >> 18)));
+              _jr_strbuf.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+              _jr_strbuf.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+              _jr_strbuf.push_back((char)(0x80 | (cp & 0x3F)));
+            }
+        }
+        break;
+        default:
+          fail("bad escape in string");
+        }
+    }
+  _jr_cur++;
+  s = _jr_strbuf.data();
+  ln = _jr_strbuf.size();
+} // end BxoJsonReader::unescape_string
+
+
+bool
+BxoJsonReader::get_id(Bxo_hid_t&hid, Bxo_loid_t&loid)
+{
+  const char* s = nullptr;
+  size_t ln = 0;
+  get_string(s, ln);
+  return ln == BXO_CSTRIDLEN && BxoObject::cstr_to_hid_loid(s, &hid, &loid);
+} // end BxoJsonReader::get_id
+
+
+void
+BxoJsonReader::skip_nested(unsigned depth)
+{
+  if (BXO_UNLIKELY(depth > _max_depth_))
+    fail("too deeply nested");
+  switch (peek())
+    {
+    case '{':
+      begin_object();
+      while (next_key())
+        skip_nested(depth+1);
+      return;
+    case '[':
+      begin_array();
+      while (next_element())
+        skip_nested(depth+1);
+      return;
+    case '"':
+    {
+      const char* s = nullptr;
+      size_t ln = 0;
+      get_string(s, ln);
+      return;
+    }
+    case 't':
+      expect_literal("true", 4);
+      return;
+    case 'f':
+      expect_literal("false", 5);
+      return;
+    case 'n':
+      expect_literal("null", 4);
+      return;
+    default:
+      break;
+    }
+  // a number, maybe with a fraction and an exponent
+  const char* p = _jr_cur;
+  auto skip_digits = [&]()
+  {
+    const char* startp = p;
+    while (p < _jr_end && *p >= '0' && *p <= '9')
+      p++;
+    if (p == startp)
+      fail("bad number");
+  };
+  if (p < _jr_end && *p == '-')
+    p++;
+  skip_digits();
+  if (p < _jr_end && *p == '.')
+    {
+      p++;
+      skip_digits();
+    }
+  if (p < _jr_end && (*p == 'e' || *p == 'E'))
+    {
+      p++;
+      if (p < _jr_end && (*p == '+' || *p == '-'))
+        p++;
+      skip_digits();
+    }
+  _jr_cur = p;
+} // end BxoJsonReader::skip_nested
+
+
+BxoJson
+BxoJsonReader::get_json(void)
+{
+  const char* startp = mark();
+  skip_value();
+  Json::Features feat = Json::Features::strictMode();
+  feat.strictRoot_ = false;
+  Json::Reader jrd(feat);
+  BxoJson js;
+  if (!jrd.parse(startp, _jr_cur, js, false))
+    {
+      BXO_BACKTRACELOG("get_json parse failure: " << jrd.getFormattedErrorMessages());
+      fail("unparsable JSON value");
+    }
+  return js;
+} // end BxoJsonReader::get_json
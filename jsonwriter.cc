@@ -0,0 +1,386 @@
+// file jsonwriter.cc - the streaming JSON writer
+
+/**   Copyright (C)  2016 Basile Starynkevitch
+
+      BASIXMO is free software; you can redistribute it and/or modify
+      it under the terms of the GNU General Public License as published by
+      the Free Software Foundation; either version 3, or (at your option)
+      any later version.
+
+      BASIXMO is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+      GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License
+      along with BASIXMO; see the file COPYING3.   If not see
+      <http://www.gnu.org/licenses/>.
+**/
+#include "basixmo.h"
+
+/// The canonical layout is the one of Json::StyledWriter: objects
+/// have a member per line, indented by 3 spaces; arrays stay on one
+/// line as "[ a, b ]" when they have fewer than 25 elements, none of
+/// them a non-empty array or object, and the line is shorter than 74
+/// bytes. Since the elements come one by one, an array is first
+/// written on one line, and broken into lines once it cannot fit.
+/// An array or object is only opened with its first element, so
+/// empty ones are written as "[]" or "{}".
+
+bool
+BxoJsonWriter::is_dumpable(BxoObject*pob) const
+{
+  if (!pob) return false;
+  return !_jw_dumper || _jw_dumper->is_dumpable(pob);
+} // end BxoJsonWriter::is_dumpable
+
+
+/// the array or object of index frix gets its first element,
+/// which is flat if it is a scalar or an empty array or object
+void
+BxoJsonWriter::open_frame(size_t frix, bool flat)
+{
+  before_value(frix, false);
+  JwFrame& fr = _jw_frames[frix];
+  BXO_ASSERT(!fr.jf_open, "open_frame already open frame #" << frix);
+  fr.jf_open = true;
+  if (fr.jf_object)
+    _jw_buf.push_back('{');
+  else if (_jw_mode == JwCanonical && flat)
+    {
+      fr.jf_inline = true;
+      fr.jf_start = _jw_buf.size();
+      _jw_inlineoffs.clear();
+      _jw_buf.append("[ ");
+    }
+  else
+    _jw_buf.push_back('[');
+} // end BxoJsonWriter::open_frame
+
+
+/// a value is going to be written inside the depth first frames
+void
+BxoJsonWriter::before_value(size_t depth, bool flat)
+{
+  if (depth == 0)
+    return;
+  size_t pix = depth-1;
+  if (_jw_frames[pix].jf_object)
+    {
+      // its key has been written, opening the object
+      BXO_ASSERT(_jw_frames[pix].jf_open, "before_value without key");
+      return;
+    }
+  if (!_jw_frames[pix].jf_open)
+    open_frame(pix, flat);
+  JwFrame& fr = _jw_frames[pix];
+  if (fr.jf_inline && (!flat || (fr.jf_count+1)*3 >= _right_margin_))
+    break_inline(fr, pix);
+  if (_jw_mode == JwCompact)
+    {
+      if (fr.jf_count > 0)
+        _jw_buf.push_back(',');
+    }
+  else if (fr.jf_inline)
+    {
+      if (fr.jf_count > 0)
+        _jw_buf.append(", ");
+      _jw_inlineoffs.push_back(_jw_buf.size());
+    }
+  else
+    {
+      if (fr.jf_count > 0)
+        _jw_buf.push_back(',');
+      put_indent(pix+1);
+    }
+  fr.jf_count++;
+} // end BxoJsonWriter::before_value
+
+
+void
+BxoJsonWriter::after_flat_value(void)
+{
+  if (_jw_frames.empty())
+    return;
+  JwFrame& fr = _jw_frames.back();
+  // the inline array would end with " ]"
+  if (fr.jf_inline && _jw_buf.size() - fr.jf_start + 2 >= _right_margin_)
+    break_inline(fr, _jw_frames.size()-1);
+} // end BxoJsonWriter::after_flat_value
+
+
+/// put each element of the inline array on its own line
+void
+BxoJsonWriter::break_inline(JwFrame&fr, size_t level)
+{
+  BXO_ASSERT(fr.jf_inline, "break_inline of non-inline array");
+  std::string elems(_jw_buf, fr.jf_start);
+  size_t nbelem = _jw_inlineoffs.size();
+  _jw_buf.resize(fr.jf_start);
+  _jw_buf.push_back('[');
+  for (size_t ix=0; ix<nbelem; ix++)
+    {
+      size_t startoff = _jw_inlineoffs[ix] - fr.jf_start;
+      size_t endoff = (ix+1<nbelem)
+                      ? _jw_inlineoffs[ix+1] - fr.jf_start - 2 : elems.size();
+      if (ix > 0)
+        _jw_buf.push_back(',');
+      put_indent(level+1);
+      _jw_buf.append(elems, startoff, endoff-startoff);
+    }
+  fr.jf_inline = false;
+  _jw_inlineoffs.clear();
+} // end BxoJsonWriter::break_inline
+
+
+void
+BxoJsonWriter::put_quoted(const char*s, size_t ln)
+{
+  bool plain = true;
+  for (size_t ix=0; ix<ln && plain; ix++)
+    {
+      unsigned char c = s[ix];
+      plain = c >= ' ' && c < 0x7f && c != '"' && c != '\\';
+    }
+  if (BXO_LIKELY(plain))
+    {
+      _jw_buf.push_back('"');
+      _jw_buf.append(s, ln);
+      _jw_buf.push_back('"');
+      return;
+    }
+  // rare escapes are left to the Json writers, which agree on them
+  Json::FastWriter fwr;
+  std::string qs = fwr.write(BxoJson(s, s+ln));
+  if (!qs.empty() && qs.back() == '\n')
+    qs.pop_back();
+  _jw_buf.append(qs);
+} // end BxoJsonWriter::put_quoted
+
+
+void
+BxoJsonWriter::begin_array(void)
+{
+  _jw_frames.push_back(JwFrame {false, false, false, 0, 0});
+} // end BxoJsonWriter::begin_array
+
+void
+BxoJsonWriter::end_array(void)
+{
+  BXO_ASSERT(!_jw_frames.empty() && !_jw_frames.back().jf_object,
+             "end_array outside of an array");
+  JwFrame fr = _jw_frames.back();
+  size_t level = _jw_frames.size()-1;
+  _jw_frames.pop_back();
+  if (!fr.jf_open)
+    {
+      before_value(level, true);
+      _jw_buf.append("[]");
+      after_flat_value();
+    }
+  else if (_jw_mode == JwCompact)
+    _jw_buf.push_back(']');
+  else if (fr.jf_inline)
+    {
+      _jw_buf.append(" ]");
+      _jw_inlineoffs.clear();
+    }
+  else
+    {
+      put_indent(level);
+      _jw_buf.push_back(']');
+    }
+} // end BxoJsonWriter::end_array
+
+void
+BxoJsonWriter::begin_object(void)
+{
+  _jw_frames.push_back(JwFrame {true, false, false, 0, 0});
+} // end BxoJsonWriter::begin_object
+
+void
+BxoJsonWriter::end_object(void)
+{
+  BXO_ASSERT(!_jw_frames.empty() && _jw_frames.back().jf_object,
+             "end_object outside of an object");
+  JwFrame fr = _jw_frames.back();
+  size_t level = _jw_frames.size()-1;
+  _jw_frames.pop_back();
+  if (!fr.jf_open)
+    {
+      before_value(level, true);
+      _jw_buf.append("{}");
+      after_flat_value();
+    }
+  else if (_jw_mode == JwCompact)
+    _jw_buf.push_back('}');
+  else
+    {
+      put_indent(level);
+      _jw_buf.push_back('}');
+    }
+} // end BxoJsonWriter::end_object
+
+void
+BxoJsonWriter::key(const char*k, size_t ln)
+{
+  BXO_ASSERT(!_jw_frames.empty() && _jw_frames.back().jf_object,
+             "key outside of an object");
+  size_t frix = _jw_frames.size()-1;
+  if (!_jw_frames[frix].jf_open)
+    open_frame(frix, false);
+  JwFrame& fr = _jw_frames[frix];
+  if (fr.jf_count > 0)
+    _jw_buf.push_back(',');
+  if (_jw_mode == JwCompact)
+    {
+      put_quoted(k, ln);
+      _jw_buf.push_back(':');
+    }
+  else
+    {
+      // StyledWriter quotes the key as a C string
+      put_indent(frix+1);
+      put_quoted(k, strnlen(k, ln));
+      _jw_buf.append(" : ");
+    }
+  fr.jf_count++;
+} // end BxoJsonWriter::key
+
+
+void
+BxoJsonWriter::put_null(void)
+{
+  before_value(_jw_frames.size(), true);
+  _jw_buf.append("null");
+  after_flat_value();
+} // end BxoJsonWriter::put_null
+
+void
+BxoJsonWriter::put_bool(bool b)
+{
+  before_value(_jw_frames.size(), true);
+  _jw_buf.append(b?"true":"false");
+  after_flat_value();
+} // end BxoJsonWriter::put_bool
+
+void
+BxoJsonWriter::put_uint(uint64_t u)
+{
+  before_value(_jw_frames.size(), true);
+  char digits[24];
+  char* pd = digits + sizeof(digits);
+  do
+    {
+      *--pd = '0' + (u % 10);
+      u /= 10;
+    }
+  while (u > 0);
+  _jw_buf.append(pd, digits + sizeof(digits) - pd);
+  after_flat_value();
+} // end BxoJsonWriter::put_uint
+
+void
+BxoJsonWriter::put_int(int64_t i)
+{
+  before_value(_jw_frames.size(), true);
+  char digits[24];
+  char* pd = digits + sizeof(digits);
+  uint64_t u = (i<0) ? -(uint64_t)i : (uint64_t)i;
+  do
+    {
+      *--pd = '0' + (u % 10);
+      u /= 10;
+    }
+  while (u > 0);
+  if (i < 0)
+    *--pd = '-';
+  _jw_buf.append(pd, digits + sizeof(digits) - pd);
+  after_flat_value();
+} // end BxoJsonWriter::put_int
+
+void
+BxoJsonWriter::put_double(double d)
+{
+  before_value(_jw_frames.size(), true);
+  _jw_buf.append(Json::valueToString(d));
+  after_flat_value();
+} // end BxoJsonWriter::put_double
+
+void
+BxoJsonWriter::put_string(const char*s, size_t ln)
+{
+  before_value(_jw_frames.size(), true);
+  put_quoted(s, ln);
+  after_flat_value();
+} // end BxoJsonWriter::put_string
+
+void
+BxoJsonWriter::put_objid(const BxoObject*pob)
+{
+  BXO_ASSERT(pob != nullptr, "put_objid: null object");
+  char idbuf[BXO_CSTRIDSIZ];
+  BxoObject::cstr_from_hid_loid(idbuf, pob->hid(), pob->loid());
+  put_string(idbuf, strlen(idbuf));
+} // end BxoJsonWriter::put_objid
+
+
+void
+BxoJsonWriter::put_json(const BxoJson&js)
+{
+  switch (js.type())
+    {
+    case Json::nullValue:
+      put_null();
+      return;
+    case Json::intValue:
+      put_int(js.asLargestInt());
+      return;
+    case Json::uintValue:
+      put_uint(js.asLargestUInt());
+      return;
+    case Json::realValue:
+      put_double(js.asDouble());
+      return;
+    case Json::stringValue:
+    {
+      const char* strb = nullptr;
+      const char* stre = nullptr;
+      if (js.getString(&strb, &stre))
+        put_string(strb, stre-strb);
+      else
+        put_string("", 0);
+      return;
+    }
+    case Json::booleanValue:
+      put_bool(js.asBool());
+      return;
+    case Json::arrayValue:
+      begin_array();
+      for (Json::ArrayIndex ix=0; ix<js.size(); ix++)
+        put_json(js[ix]);
+      end_array();
+      return;
+    case Json::objectValue:
+      // the members come in the order of their keys
+      begin_object();
+      for (auto it = js.begin(); it != js.end(); ++it)
+        {
+          const char* keye = nullptr;
+          const char* keyb = it.memberName(&keye);
+          key(keyb, keye-keyb);
+          put_json(*it);
+        }
+      end_object();
+      return;
+    }
+} // end BxoJsonWriter::put_json
+
+
+void
+BxoJsonWriter::finish_into(std::string&dest)
+{
+  BXO_ASSERT(_jw_frames.empty(), "finish_into with unclosed arrays or objects");
+  _jw_buf.push_back('\n');
+  dest.swap(_jw_buf);
+  clear();
+} // end BxoJsonWriter::finish_into
@@ -35,6 +35,15 @@ void bxo_abort(void)
   abort();
 } // end of bxo_abort
 
+void bxo_fast_exit(int status)
+{
+  BxoObject::begin_teardown();
+  std::cout.flush();
+  std::cerr.flush();
+  fflush(NULL);
+  _exit(status);
+} // end of bxo_fast_exit
+
 char *
 bxo_strftime_centi (char *buf, size_t len, const char *fmt, double ti)
 {
@@ -248,6 +257,28 @@ main (int argc_main, char **argv_main)
                                 "give various info");
   QCommandLineOption verboseoption(QStringList() <<"V" << "verbose",
                                    "give verbose debug output");
+  QCommandLineOption strhashoption("string-hash-version",
+                                   "use string hash <version> (1 is legacy, 2 is latest),"
+                                   " overriding the one of the loaded state and recording it"
+                                   " in the dump; otherwise dumps record the latest",
+                                   "version");
+  QCommandLineOption binarycontoption("binary-content",
+                                      "dump the object and payload contents in the compact binary"
+                                      " encoding, not as JSON text (loading accepts both)");
+  QCommandLineOption compactjsonoption("compact-json",
+                                       "dump the JSON contents on a single line, not indented");
+  QCommandLineOption commitrowsoption("dump-commit-rows",
+                                      "commit the dumped rows every <rows> objects (0 commits once)",
+                                      "rows");
+  QCommandLineOption loadjobsoption("load-jobs",
+                                     "fill the loaded object contents in <jobs> threads",
+                                     "jobs");
+  QCommandLineOption dumpjobsoption("dump-jobs",
+                                    "scan the object graph for dumping in <jobs> threads",
+                                    "jobs");
+  QCommandLineOption cleanexitoption("clean-exit",
+                                     "return from main and destroy every object at exit,"
+                                     " instead of terminating at once after the final dump");
   cmdlinparser.addHelpOption();
   cmdlinparser.addVersionOption();
   cmdlinparser.addOption(noguioption);
@@ -255,6 +286,13 @@ main (int argc_main, char **argv_main)
   cmdlinparser.addOption(loaddiroption);
   cmdlinparser.addOption(infooption);
   cmdlinparser.addOption(verboseoption);
+  cmdlinparser.addOption(strhashoption);
+  cmdlinparser.addOption(binarycontoption);
+  cmdlinparser.addOption(compactjsonoption);
+  cmdlinparser.addOption(commitrowsoption);
+  cmdlinparser.addOption(loadjobsoption);
+  cmdlinparser.addOption(dumpjobsoption);
+  cmdlinparser.addOption(cleanexitoption);
   cmdlinparser.process(*app);
   if (cmdlinparser.isSet(infooption))
     {
@@ -262,6 +300,30 @@ main (int argc_main, char **argv_main)
     }
   if (cmdlinparser.isSet(verboseoption))
     bxo_verboseflag = true;
+  if (cmdlinparser.isSet(strhashoption))
+    {
+      bool ok = false;
+      int hashversion = cmdlinparser.value(strhashoption).toInt(&ok);
+      if (!ok || hashversion < BXO_STRING_HASH_VERSION_LEGACY
+          || hashversion > BXO_STRING_HASH_VERSION_LATEST)
+        {
+          fprintf(stderr, "%s: bad --string-hash-version %s, expecting %d to %d\n",
+                  argv_main[0], cmdlinparser.value(strhashoption).toStdString().c_str(),
+                  BXO_STRING_HASH_VERSION_LEGACY, BXO_STRING_HASH_VERSION_LATEST);
+          exit(EXIT_FAILURE);
+        }
+      BxoString::force_hash_version(hashversion);
+    }
+  if (cmdlinparser.isSet(binarycontoption))
+    BxoDumper::set_binary_content(true);
+  if (cmdlinparser.isSet(compactjsonoption))
+    BxoDumper::set_compact_json(true);
+  if (cmdlinparser.isSet(commitrowsoption))
+    BxoDumper::set_commit_rows(std::max(cmdlinparser.value(commitrowsoption).toInt(), 0));
+  if (cmdlinparser.isSet(loadjobsoption))
+    BxoLoader::set_load_jobs(std::max(cmdlinparser.value(loadjobsoption).toInt(), 1));
+  if (cmdlinparser.isSet(dumpjobsoption))
+    BxoDumper::set_dump_jobs(std::max(cmdlinparser.value(dumpjobsoption).toInt(), 1));
   if (cmdlinparser.isSet(dumpdiroption))
     {
       auto dumpdirstr = cmdlinparser.value(dumpdiroption).toStdString();
@@ -318,6 +380,9 @@ main (int argc_main, char **argv_main)
   printf("Basixmo ending pid %d (%.4f elapsed, %.4f process cpu seconds)\n",
          (int)getpid(), bxo_elapsed_real_time (), bxo_process_cpu_time ());
   fflush(nullptr);
+  if (!cmdlinparser.isSet(cleanexitoption))
+    bxo_fast_exit(EXIT_SUCCESS);
+  BxoObject::begin_teardown();
 } // end of main
 
 double
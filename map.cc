@@ -0,0 +1,632 @@
+// file map.cc - immutable maps from objects to values, as hash array mapped tries
+
+/**   Copyright (C)  2016 Basile Starynkevitch
+
+      BASIXMO is free software; you can redistribute it and/or modify
+      it under the terms of the GNU General Public License as published by
+      the Free Software Foundation; either version 3, or (at your option)
+      any later version.
+
+      BASIXMO is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+      GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License
+      along with BASIXMO; see the file COPYING3.   If not see
+      <http://www.gnu.org/licenses/>.
+**/
+#include "basixmo.h"
+
+/// five bits of the object hash per level; past the 32 bits of the
+/// hash, colliding objects go into a collision node, whose entries
+/// are kept in a plain array without any bitmap
+#define BXO_MAP_BITS 5
+#define BXO_MAP_MASK 31
+
+class BxoMapNode
+{
+  friend class BxoMap;
+public:
+  typedef std::shared_ptr<const BxoMapNode> ptr_t;
+  typedef BxoMap::pair_t pair_t;
+private:
+  const uint32_t _datamap;	// the slots holding an entry
+  const uint32_t _nodemap;	// the slots holding a subnode
+  const std::vector<pair_t> _data;
+  const std::vector<ptr_t> _nodes;
+  const size_t _count;		// number of pairs in the subtree
+  const uint32_t _sumhash;	// sum of the pair hashes in the subtree
+public:
+  BxoMapNode(uint32_t datamap, uint32_t nodemap, std::vector<pair_t>&&data, std::vector<ptr_t>&&nodes);
+  BxoMapNode(const BxoMapNode&) = delete;
+  BxoMapNode(BxoMapNode&&) = delete;
+  static uint32_t pair_hash(const BxoObject*key, const BxoVal&val)
+  {
+    uint32_t h = key->hash() * UINT32_C(2654435761) + val.hash() * UINT32_C(2246822519);
+    h ^= h >> 15;
+    h *= UINT32_C(3266489917);
+    h ^= h >> 13;
+    return h;
+  };
+  static unsigned slot(BxoHash_t h, unsigned shift)
+  {
+    return (h >> shift) & BXO_MAP_MASK;
+  };
+  static unsigned index(uint32_t bitmap, uint32_t bit)
+  {
+    return __builtin_popcount(bitmap & (bit - 1));
+  };
+  static bool is_collision_shift(unsigned shift)
+  {
+    return shift >= 32;
+  };
+  bool is_singleton() const
+  {
+    return _nodes.empty() && _data.size() == 1;
+  };
+  static ptr_t make_node(uint32_t datamap, uint32_t nodemap, std::vector<pair_t>&&data, std::vector<ptr_t>&&nodes)
+  {
+    return ptr_t(new BxoMapNode(datamap, nodemap, std::move(data), std::move(nodes)));
+  };
+  static const pair_t*find(const BxoMapNode*n, const BxoObject*key);
+  static ptr_t make_two(const pair_t&p1, const pair_t&p2, unsigned shift);
+  static uint32_t trie_order(BxoHash_t h);
+  static ptr_t build(const std::vector<pair_t>&pairs, size_t lo, size_t hi, unsigned shift);
+  static ptr_t put(const ptr_t&n, const pair_t&pair, unsigned shift);
+  static ptr_t remove(const ptr_t&n, const BxoObject*key, unsigned shift);
+  static bool same(const BxoMapNode*l, const BxoMapNode*r);
+  static unsigned depth(const BxoMapNode*n);
+  static void each(const BxoMapNode*n, const std::function<void(const std::shared_ptr<BxoObject>&,const BxoVal&)>&f);
+};        // end class BxoMapNode
+
+
+BxoMapNode::BxoMapNode(uint32_t datamap, uint32_t nodemap, std::vector<pair_t>&&data, std::vector<ptr_t>&&nodes)
+  : _datamap(datamap), _nodemap(nodemap),
+    _data(std::move(data)), _nodes(std::move(nodes)),
+    _count(0), _sumhash(0)
+{
+  size_t cnt = _data.size();
+  uint32_t sumh = 0;
+  for (auto& p : _data)
+    sumh += pair_hash(p.first.get(), p.second);
+  for (auto& sub : _nodes)
+    {
+      cnt += sub->_count;
+      sumh += sub->_sumhash;
+    }
+  *const_cast<size_t*>(&_count) = cnt;
+  *const_cast<uint32_t*>(&_sumhash) = sumh;
+} // end BxoMapNode::BxoMapNode
+
+
+const BxoMap::pair_t*
+BxoMapNode::find(const BxoMapNode*n, const BxoObject*key)
+{
+  BxoHash_t h = key->hash();
+  unsigned shift = 0;
+  while (n)
+    {
+      if (is_collision_shift(shift))
+        {
+          for (auto& p : n->_data)
+            if (p.first.get() == key)
+              return &p;
+          return nullptr;
+        }
+      uint32_t bit = UINT32_C(1) << slot(h, shift);
+      if (n->_datamap & bit)
+        {
+          const pair_t& p = n->_data[index(n->_datamap, bit)];
+          return (p.first.get() == key) ? &p : nullptr;
+        }
+      if (!(n->_nodemap & bit))
+        return nullptr;
+      n = n->_nodes[index(n->_nodemap, bit)].get();
+      shift += BXO_MAP_BITS;
+    }
+  return nullptr;
+} // end BxoMapNode::find
+
+
+/// a subnode for two pairs of distinct objects, at the given shift
+BxoMapNode::ptr_t
+BxoMapNode::make_two(const pair_t&p1, const pair_t&p2, unsigned shift)
+{
+  if (is_collision_shift(shift))
+    return make_node(0, 0, std::vector<pair_t> {p1, p2}, std::vector<ptr_t> {});
+  unsigned s1 = slot(p1.first->hash(), shift);
+  unsigned s2 = slot(p2.first->hash(), shift);
+  if (s1 == s2)
+    return make_node(0, UINT32_C(1) << s1, std::vector<pair_t> {},
+                     std::vector<ptr_t> {make_two(p1, p2, shift+BXO_MAP_BITS)});
+  uint32_t datamap = (UINT32_C(1) << s1) | (UINT32_C(1) << s2);
+  if (s1 < s2)
+    return make_node(datamap, 0, std::vector<pair_t> {p1, p2}, std::vector<ptr_t> {});
+  return make_node(datamap, 0, std::vector<pair_t> {p2, p1}, std::vector<ptr_t> {});
+} // end BxoMapNode::make_two
+
+
+/// the hash with its five bits slots reversed, so sorting by it
+/// groups together the pairs of every subtrie
+uint32_t
+BxoMapNode::trie_order(BxoHash_t h)
+{
+  uint32_t k = 0;
+  for (unsigned shift = 0; shift < 32; shift += BXO_MAP_BITS)
+    {
+      unsigned width = std::min(BXO_MAP_BITS, 32 - (int)shift);
+      k = (k << width) | ((h >> shift) & ((UINT32_C(1) << width) - 1));
+    }
+  return k;
+} // end BxoMapNode::trie_order
+
+
+/// build bottom up the trie of pairs[lo,hi), which have distinct
+/// objects and are sorted by trie_order
+BxoMapNode::ptr_t
+BxoMapNode::build(const std::vector<pair_t>&pairs, size_t lo, size_t hi, unsigned shift)
+{
+  if (lo >= hi)
+    return nullptr;
+  if (is_collision_shift(shift))
+    return make_node(0, 0, std::vector<pair_t>(pairs.begin()+lo, pairs.begin()+hi), std::vector<ptr_t> {});
+  uint32_t datamap = 0, nodemap = 0;
+  std::vector<pair_t> data;
+  std::vector<ptr_t> nodes;
+  size_t ix = lo;
+  while (ix < hi)
+    {
+      unsigned sl = slot(pairs[ix].first->hash(), shift);
+      size_t endix = ix+1;
+      while (endix < hi && slot(pairs[endix].first->hash(), shift) == sl)
+        endix++;
+      if (endix == ix+1)
+        {
+          datamap |= UINT32_C(1) << sl;
+          data.push_back(pairs[ix]);
+        }
+      else
+        {
+          nodemap |= UINT32_C(1) << sl;
+          nodes.push_back(build(pairs, ix, endix, shift+BXO_MAP_BITS));
+        }
+      ix = endix;
+    }
+  return make_node(datamap, nodemap, std::move(data), std::move(nodes));
+} // end BxoMapNode::build
+
+
+/// return n itself when nothing changed
+BxoMapNode::ptr_t
+BxoMapNode::put(const ptr_t&n, const pair_t&pair, unsigned shift)
+{
+  const BxoObject*key = pair.first.get();
+  if (!n)
+    return make_node(UINT32_C(1) << slot(key->hash(), shift), 0,
+                     std::vector<pair_t> {pair}, std::vector<ptr_t> {});
+  if (is_collision_shift(shift))
+    {
+      std::vector<pair_t> data(n->_data);
+      for (auto& p : data)
+        if (p.first.get() == key)
+          {
+            if (p.second == pair.second)
+              return n;
+            p.second = pair.second;
+            return make_node(0, 0, std::move(data), std::vector<ptr_t> {});
+          }
+      data.push_back(pair);
+      return make_node(0, 0, std::move(data), std::vector<ptr_t> {});
+    }
+  uint32_t bit = UINT32_C(1) << slot(key->hash(), shift);
+  if (n->_datamap & bit)
+    {
+      unsigned dix = index(n->_datamap, bit);
+      const pair_t& old = n->_data[dix];
+      std::vector<pair_t> data(n->_data);
+      if (old.first.get() == key)
+        {
+          if (old.second == pair.second)
+            return n;
+          data[dix].second = pair.second;
+          return make_node(n->_datamap, n->_nodemap, std::move(data), std::vector<ptr_t>(n->_nodes));
+        }
+      // move the old entry down into a new subnode with the new pair
+      auto sub = make_two(old, pair, shift+BXO_MAP_BITS);
+      data.erase(data.begin() + dix);
+      std::vector<ptr_t> nodes(n->_nodes);
+      nodes.insert(nodes.begin() + index(n->_nodemap, bit), sub);
+      return make_node(n->_datamap & ~bit, n->_nodemap | bit, std::move(data), std::move(nodes));
+    }
+  if (n->_nodemap & bit)
+    {
+      unsigned nix = index(n->_nodemap, bit);
+      auto sub = put(n->_nodes[nix], pair, shift+BXO_MAP_BITS);
+      if (sub == n->_nodes[nix])
+        return n;
+      std::vector<ptr_t> nodes(n->_nodes);
+      nodes[nix] = sub;
+      return make_node(n->_datamap, n->_nodemap, std::vector<pair_t>(n->_data), std::move(nodes));
+    }
+  std::vector<pair_t> data(n->_data);
+  data.insert(data.begin() + index(n->_datamap, bit), pair);
+  return make_node(n->_datamap | bit, n->_nodemap, std::move(data), std::vector<ptr_t>(n->_nodes));
+} // end BxoMapNode::put
+
+
+/// return n itself when key is absent, and null when the node becomes
+/// empty; a subnode left with a single pair is inlined into its
+/// parent, so the shape of the trie only depends on its pairs
+BxoMapNode::ptr_t
+BxoMapNode::remove(const ptr_t&n, const BxoObject*key, unsigned shift)
+{
+  if (!n)
+    return n;
+  if (is_collision_shift(shift))
+    {
+      for (unsigned ix=0; ix<n->_data.size(); ix++)
+        if (n->_data[ix].first.get() == key)
+          {
+            if (n->_data.size() == 1)
+              return nullptr;
+            std::vector<pair_t> data(n->_data);
+            data.erase(data.begin() + ix);
+            return make_node(0, 0, std::move(data), std::vector<ptr_t> {});
+          }
+      return n;
+    }
+  uint32_t bit = UINT32_C(1) << slot(key->hash(), shift);
+  if (n->_datamap & bit)
+    {
+      unsigned dix = index(n->_datamap, bit);
+      if (n->_data[dix].first.get() != key)
+        return n;
+      if (n->_count == 1)
+        return nullptr;
+      std::vector<pair_t> data(n->_data);
+      data.erase(data.begin() + dix);
+      return make_node(n->_datamap & ~bit, n->_nodemap, std::move(data), std::vector<ptr_t>(n->_nodes));
+    }
+  if (n->_nodemap & bit)
+    {
+      unsigned nix = index(n->_nodemap, bit);
+      auto sub = remove(n->_nodes[nix], key, shift+BXO_MAP_BITS);
+      if (sub == n->_nodes[nix])
+        return n;
+      BXO_ASSERT(sub, "BxoMapNode::remove emptied a subnode");
+      if (sub->is_singleton())
+        {
+          if (n->_count == 2)
+            // the whole node is left with one pair; the parent inlines it
+            return make_node(UINT32_C(1) << slot(sub->_data[0].first->hash(), shift), 0,
+                             std::vector<pair_t>(sub->_data), std::vector<ptr_t> {});
+          std::vector<pair_t> data(n->_data);
+          data.insert(data.begin() + index(n->_datamap, bit), sub->_data[0]);
+          std::vector<ptr_t> nodes(n->_nodes);
+          nodes.erase(nodes.begin() + nix);
+          return make_node(n->_datamap | bit, n->_nodemap & ~bit, std::move(data), std::move(nodes));
+        }
+      std::vector<ptr_t> nodes(n->_nodes);
+      nodes[nix] = sub;
+      return make_node(n->_datamap, n->_nodemap, std::vector<pair_t>(n->_data), std::move(nodes));
+    }
+  return n;
+} // end BxoMapNode::remove
+
+
+/// since the shape is canonical, equal maps have the same bitmaps
+/// everywhere, except for the order inside collision nodes
+bool
+BxoMapNode::same(const BxoMapNode*l, const BxoMapNode*r)
+{
+  if (l == r)
+    return true;
+  if (!l || !r)
+    return false;
+  if (l->_count != r->_count || l->_sumhash != r->_sumhash
+      || l->_datamap != r->_datamap || l->_nodemap != r->_nodemap
+      || l->_data.size() != r->_data.size() || l->_nodes.size() != r->_nodes.size())
+    return false;
+  if (l->_datamap == 0 && l->_nodemap == 0)
+    {
+      // a collision node, the pairs may come in any order
+      for (auto& lp : l->_data)
+        {
+          bool found = false;
+          for (auto& rp : r->_data)
+            if (lp.first == rp.first)
+              {
+                found = (lp.second == rp.second);
+                break;
+              }
+          if (!found)
+            return false;
+        }
+      return true;
+    }
+  for (unsigned ix=0; ix<l->_data.size(); ix++)
+    if (l->_data[ix].first != r->_data[ix].first
+        || !(l->_data[ix].second == r->_data[ix].second))
+      return false;
+  for (unsigned ix=0; ix<l->_nodes.size(); ix++)
+    if (!same(l->_nodes[ix].get(), r->_nodes[ix].get()))
+      return false;
+  return true;
+} // end BxoMapNode::same
+
+
+unsigned
+BxoMapNode::depth(const BxoMapNode*n)
+{
+  if (!n)
+    return 0;
+  unsigned d = 0;
+  for (auto& sub : n->_nodes)
+    d = std::max(d, depth(sub.get()));
+  return d+1;
+} // end BxoMapNode::depth
+
+
+void
+BxoMapNode::each(const BxoMapNode*n, const std::function<void(const std::shared_ptr<BxoObject>&,const BxoVal&)>&f)
+{
+  if (!n)
+    return;
+  for (auto& p : n->_data)
+    f(p.first, p.second);
+  for (auto& sub : n->_nodes)
+    each(sub.get(), f);
+} // end BxoMapNode::each
+
+
+
+static BxoHash_t
+bxo_map_fold_hash(uint32_t sumhash, size_t count)
+{
+  uint32_t h = sumhash ^ ((uint32_t)count * UINT32_C(668265263));
+  h ^= h >> 16;
+  h *= UINT32_C(2246822519);
+  h ^= h >> 13;
+  if (BXO_UNLIKELY(h == 0))
+    h = (count & 0xffff) + 23;
+  return h;
+} // end bxo_map_fold_hash
+
+
+BxoMap::BxoMap(const std::shared_ptr<const BxoMapNode>&root)
+  : _root(root),
+    _hash(bxo_map_fold_hash(root?root->_sumhash:0, root?root->_count:0))
+{
+} // end BxoMap::BxoMap
+
+BxoMap::~BxoMap()
+{
+} // end BxoMap::~BxoMap
+
+
+/// the last pair of an object wins, and a nil value removes it; the
+/// trie is built at once, not by successive puts
+const BxoMap*
+BxoMap::make_map(const std::vector<pair_t>&pairs)
+{
+  std::unordered_map<const BxoObject*,size_t> lastix;
+  lastix.reserve(pairs.size());
+  for (size_t ix=0; ix<pairs.size(); ix++)
+    if (pairs[ix].first)
+      lastix[pairs[ix].first.get()] = ix;
+  std::vector<std::pair<uint32_t,size_t>> order;
+  order.reserve(lastix.size());
+  for (auto& p : lastix)
+    if (!pairs[p.second].second.is_null())
+      order.push_back({BxoMapNode::trie_order(p.first->hash()), p.second});
+  std::sort(order.begin(), order.end());
+  std::vector<pair_t> sorted;
+  sorted.reserve(order.size());
+  for (auto& o : order)
+    sorted.push_back(pairs[o.second]);
+  return make_from_node(BxoMapNode::build(sorted, 0, sorted.size(), 0));
+} // end BxoMap::make_map
+
+
+const BxoMap*
+BxoMap::load_map(BxoJsonProcessor&bxj, const BxoJson&js)
+{
+  if (!js.isArray()) return nullptr;
+  std::vector<pair_t> pairs;
+  auto ln = js.size();
+  pairs.reserve(ln);
+  for (int ix=0; ix<(int)ln; ix++)
+    {
+      const BxoJson& jpair = js[ix];
+      if (!jpair.isObject() || !jpair["at"].isString())
+        {
+          BXO_BACKTRACELOG("load_map: invalid jpair=" << jpair << " at ix=" << ix);
+          throw std::runtime_error("BxoMap::load_map invalid jpair");
+        }
+      auto pob = bxj.obj_from_idstr(jpair["at"].asString());
+      if (!pob) continue;
+      pairs.push_back({pob->shared_from_this(), BxoVal::from_json(bxj, jpair["va"])});
+    }
+  return make_map(pairs);
+} // end BxoMap::load_map
+
+
+size_t
+BxoMap::size() const
+{
+  return _root?_root->_count:0;
+} // end BxoMap::size
+
+unsigned
+BxoMap::depth() const
+{
+  return BxoMapNode::depth(_root.get());
+} // end BxoMap::depth
+
+
+BxoVal
+BxoMap::get(const BxoObject*key) const
+{
+  if (!key) return nullptr;
+  auto p = BxoMapNode::find(_root.get(), key);
+  if (!p) return nullptr;
+  return p->second;
+} // end BxoMap::get
+
+
+bool
+BxoMap::has(const BxoObject*key) const
+{
+  return key && BxoMapNode::find(_root.get(), key) != nullptr;
+} // end BxoMap::has
+
+
+const BxoMap*
+BxoMap::put(const std::shared_ptr<BxoObject>&key, const BxoVal&val) const
+{
+  if (BXO_UNLIKELY(!key))
+    {
+      BXO_BACKTRACELOG("BxoMap::put: null key");
+      throw std::runtime_error("BxoMap::put null key");
+    }
+  if (val.is_null())
+    return remove(key.get());
+  return make_from_node(BxoMapNode::put(_root, pair_t {key, val}, 0));
+} // end BxoMap::put
+
+
+const BxoMap*
+BxoMap::remove(const BxoObject*key) const
+{
+  if (!key)
+    return make_from_node(_root);
+  return make_from_node(BxoMapNode::remove(_root, key, 0));
+} // end BxoMap::remove
+
+
+void
+BxoMap::each(const std::function<void(const std::shared_ptr<BxoObject>&,const BxoVal&)>&f) const
+{
+  BxoMapNode::each(_root.get(), f);
+} // end BxoMap::each
+
+
+std::vector<BxoMap::pair_t>
+BxoMap::sorted_pairs(void) const
+{
+  // sort pointers into the trie nodes, which live as long as the map,
+  // and copy the pairs once in order, without moving values around
+  typedef std::pair<const std::shared_ptr<BxoObject>*,const BxoVal*> ptrpair_t;
+  std::vector<ptrpair_t> ptrpairs;
+  ptrpairs.reserve(size());
+  each([&](const std::shared_ptr<BxoObject>&key, const BxoVal&val)
+  {
+    ptrpairs.push_back({&key, &val});
+  });
+  std::sort(ptrpairs.begin(), ptrpairs.end(), [](const ptrpair_t&l, const ptrpair_t&r)
+  {
+    return (*l.first)->less(**r.first);
+  });
+  std::vector<pair_t> pairs;
+  pairs.reserve(ptrpairs.size());
+  for (const ptrpair_t& pp : ptrpairs)
+    pairs.push_back({*pp.first, *pp.second});
+  return pairs;
+} // end BxoMap::sorted_pairs
+
+
+bool
+BxoMap::same_map(const BxoMap&r) const
+{
+  return this == &r
+         || (_hash == r._hash && BxoMapNode::same(_root.get(), r._root.get()));
+} // end BxoMap::same_map
+
+
+/// maps are ordered by size, then hash, and only then by their sorted pairs
+bool
+BxoMap::less_than_map(const BxoMap&r) const
+{
+  if (size() != r.size()) return size() < r.size();
+  if (_hash != r._hash) return _hash < r._hash;
+  if (same_map(r)) return false;
+  auto lpairs = sorted_pairs();
+  auto rpairs = r.sorted_pairs();
+  for (unsigned ix=0; ix<lpairs.size(); ix++)
+    {
+      if (lpairs[ix].first != rpairs[ix].first)
+        return lpairs[ix].first->less(*rpairs[ix].first);
+      if (!(lpairs[ix].second == rpairs[ix].second))
+        return lpairs[ix].second < rpairs[ix].second;
+    }
+  return false;
+} // end BxoMap::less_than_map
+
+
+void
+BxoMap::map_scan_dump(BxoDumper&du) const
+{
+  each([&](const std::shared_ptr<BxoObject>&key, const BxoVal&val)
+  {
+    if (du.scan_dumpable(key.get()))
+      val.scan_dump(du);
+  });
+} // end BxoMap::map_scan_dump
+
+
+BxoJson
+BxoMap::map_to_json(BxoDumper&du) const
+{
+  BxoJson jarr {Json::arrayValue};
+  for (auto& p : sorted_pairs())
+    {
+      if (!du.is_dumpable(p.first)) continue;
+      BxoJson jpair {Json::objectValue};
+      jpair["at"] = p.first->strid();
+      jpair["va"] = p.second.to_json(du);
+      jarr.append(jpair);
+    }
+  return jarr;
+} // end BxoMap::map_to_json
+
+void
+BxoMap::map_write_json(BxoJsonWriter&jw) const
+{
+  jw.begin_array();
+  for (auto& p : sorted_pairs())
+    {
+      if (!jw.is_dumpable(p.first)) continue;
+      jw.begin_object();
+      jw.key("at");
+      jw.put_objid(p.first.get());
+      jw.key("va");
+      p.second.write_json(jw);
+      jw.end_object();
+    }
+  jw.end_array();
+} // end BxoMap::map_write_json
+
+
+void
+BxoMap::out(std::ostream&os) const
+{
+  constexpr unsigned maxshown = 8;
+  unsigned cnt = 0;
+  os << "<map " << size() << ":";
+  for (auto& p : sorted_pairs())
+    {
+      if (cnt++ >= maxshown)
+        {
+          os << " ...";
+          break;
+        }
+      os << " " << p.first->pname() << "=" << p.second;
+    }
+  os << ">";
+} // end BxoMap::out
+
+
+BxoVMap::BxoVMap(const std::vector<std::pair<std::shared_ptr<BxoObject>,BxoVal>>&pairs)
+  : BxoVal(TagMap {}, BxoMap::make_map(pairs))
+{
+}
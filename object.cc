@@ -16,12 +16,17 @@
       <http://www.gnu.org/licenses/>.
 **/
 #include "basixmo.h"
+#include <array>
 
 std::unordered_set<std::shared_ptr<BxoObject>,BxoHashObjSharedPtr> BxoObject::_predef_set_;
 
 std::unordered_set<BxoObject*,BxoHashObjPtr> BxoObject::_bucketarr_[BXO_HID_BUCKETMAX];
 std::map<std::string,std::shared_ptr<BxoObject>> BxoObject::_namedict_;
+BxoObject* BxoObject::_predefnamed_[bxopredix__LAST+1];
 std::unordered_map<BxoObject*,std::string> BxoObject::_namemap_;
+std::vector<BxoObject::ObnumSlot>& BxoObject::_obnumvec_ = *new std::vector<BxoObject::ObnumSlot>(1);
+std::vector<uint32_t>& BxoObject::_obnumfree_ = *new std::vector<uint32_t>();
+bool BxoObject::_tearingdown_;
 
 // we choose base 60, because with a 0-9 decimal digit then 13 extended
 // digits in base 60 we can express a 80-bit number.  Notice that
@@ -76,13 +81,19 @@ char14_to_num80_bxo (const char *buf)
 std::string BxoObject::str_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid)
 {
   if (hid==0 && loid==0) return "";
+  char buf[BXO_CSTRIDSIZ];
+  cstr_from_hid_loid(buf, hid, loid);
+  return std::string {buf};
+}
+
+void BxoObject::cstr_from_hid_loid(char buf[BXO_CSTRIDSIZ], Bxo_hid_t hid, Bxo_loid_t loid)
+{
   if (!hid || !loid)
     {
       BXO_BACKTRACELOG("str_from_hid_loid: bad hid=" << hid << ", loid=" << loid);
       throw std::runtime_error("str_from_hid_loid: invalid id");
     }
-  char buf[BXO_CSTRIDSIZ];
-  memset (buf, 0, sizeof(buf));
+  memset (buf, 0, BXO_CSTRIDSIZ);
   unsigned bn = hi_id_bucketnum(hid);
   char d0 = '0' + bn / (60 * 60);
   bn = bn % (60 * 60);
@@ -98,8 +109,43 @@ std::string BxoObject::str_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid)
   buf[2] = c1;
   buf[3] = c2;
   strcpy(buf+4, s16);
-  return std::string {buf};
-}
+} // end BxoObject::cstr_from_hid_loid
+
+Bxo_uint128_t
+BxoObject::id_order_key(Bxo_hid_t hid, Bxo_loid_t loid)
+{
+  // the rank of each digit value in the ASCII order of the digits
+  static const std::array<unsigned char,ID_BASE_BXO> digrank = []()
+  {
+    std::array<unsigned char,ID_BASE_BXO> rk;
+    for (unsigned v=0; v<ID_BASE_BXO; v++)
+      {
+        rk[v] = 0;
+        for (unsigned w=0; w<ID_BASE_BXO; w++)
+          if (ID_DIGITS_BXO[w] < ID_DIGITS_BXO[v])
+            rk[v]++;
+      }
+    return rk;
+  }();
+  // the digits of the id after its underscore, as in str_from_hid_loid
+  unsigned char digs[BXO_CSTRIDLEN-1];
+  unsigned bn = hi_id_bucketnum(hid);
+  digs[0] = bn / (60 * 60);
+  digs[1] = (bn % (60 * 60)) / 60;
+  digs[2] = bn % 60;
+  Bxo_uint128_t wn =
+    ((Bxo_uint128_t) (hid & 0xffff) << 64) + (Bxo_uint128_t) loid;
+  for (int ix = BXO_CSTRIDLEN-2; ix > 3; ix--)
+    {
+      digs[ix] = wn % ID_BASE_BXO;
+      wn = wn / ID_BASE_BXO;
+    }
+  digs[3] = wn;
+  Bxo_uint128_t key = 0;
+  for (unsigned ix = 0; ix < BXO_CSTRIDLEN-1; ix++)
+    key = key * ID_BASE_BXO + digrank[digs[ix]];
+  return key;
+} // end BxoObject::id_order_key
 
 bool BxoObject::cstr_to_hid_loid(const char*buf, Bxo_hid_t* phid, Bxo_loid_t* ploid, const char**endp)
 {
@@ -143,6 +189,158 @@ std::shared_ptr<BxoObject> BXO_VARPREDEF(Name);
 std::shared_ptr<BxoObject> BXO_VARGLOBAL(Name);
 #include "_bxo_global.h"
 
+constexpr BxoPredefKey bxo_predef_idkeys[bxopredix__LAST+1] =
+{
+#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash) \
+  {#Idstr, sizeof(#Idstr)-1},
+#include "_bxo_predef.h"
+  {nullptr, 0}
+};
+
+constexpr BxoPredefKey bxo_predef_namekeys[bxopredix__LAST+1] =
+{
+#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash) \
+  {#Name, sizeof(#Name)-1},
+#include "_bxo_predef.h"
+  {nullptr, 0}
+};
+
+std::shared_ptr<BxoObject>* const bxo_predef_vars[bxopredix__LAST+1] =
+{
+#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash) \
+  &BXO_VARPREDEF(Name),
+#include "_bxo_predef.h"
+  nullptr
+};
+
+static constexpr BxoPredefTable
+bxo_predef_make_table(const BxoPredefKey*keys, const uint16_t*displ)
+{
+  BxoPredefTable tab {};
+  for (unsigned bu=0; bu<BxoPredefTable::nbuckets; bu++)
+    tab.pt_displ[bu] = displ[bu];
+  for (unsigned sl=0; sl<BxoPredefTable::size; sl++)
+    tab.pt_index[sl] = -1;
+  for (unsigned ix=0; ix<(unsigned)bxopredix__LAST; ix++)
+    {
+      uint32_t h = bxo_predef_strhash(keys[ix].pk_str, keys[ix].pk_len);
+      unsigned sl = bxo_predef_slot(h, displ[bxo_predef_bucket(h, BXO_PREDEF_BUCKET_BITS)],
+                                    BXO_PREDEF_HASH_BITS);
+      if (tab.pt_index[sl] >= 0)
+        tab.pt_collisions++;
+      else
+        tab.pt_index[sl] = ix;
+    }
+  return tab;
+}
+
+static constexpr uint16_t bxo_predef_iddispl[BxoPredefTable::nbuckets] = { BXO_PREDEF_ID_DISPL };
+static constexpr uint16_t bxo_predef_namedispl[BxoPredefTable::nbuckets] = { BXO_PREDEF_NAME_DISPL };
+constexpr BxoPredefTable bxo_predef_idtable = bxo_predef_make_table(bxo_predef_idkeys, bxo_predef_iddispl);
+constexpr BxoPredefTable bxo_predef_nametable = bxo_predef_make_table(bxo_predef_namekeys, bxo_predef_namedispl);
+static_assert(bxo_predef_idtable.pt_collisions == 0,
+              "predefined ids collide, regenerate _bxo_predef.h");
+static_assert(bxo_predef_nametable.pt_collisions == 0,
+              "predefined names collide, regenerate _bxo_predef.h");
+
+/// so that a switch on Bxo_PredefHash_en cannot confuse two
+/// predefined objects; a small open addressing set keeps it linear
+static constexpr bool
+bxo_predef_distinct_hashes(void)
+{
+  constexpr BxoHash_t hashes[bxopredix__LAST+1] =
+  {
+#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash) \
+    Hash,
+#include "_bxo_predef.h"
+    0
+  };
+  constexpr unsigned setsiz = 2u << BXO_PREDEF_HASH_BITS;
+  BxoHash_t set[setsiz] = {};
+  for (unsigned ix=0; ix<(unsigned)bxopredix__LAST; ix++)
+    {
+      BxoHash_t h = hashes[ix];
+      if (h == 0)
+        return false;
+      unsigned sl = bxo_predef_slot(h, 0, BXO_PREDEF_HASH_BITS+1);
+      while (set[sl] != 0)
+        {
+          if (set[sl] == h)
+            return false;
+          sl = (sl + 1) & (setsiz - 1);
+        }
+      set[sl] = h;
+    }
+  return true;
+}
+static_assert(bxo_predef_distinct_hashes(),
+              "two predefined objects have the same hash");
+
+/// the identity of the predefined objects, by dense index
+struct BxoPredefIdent
+{
+  BxoHash_t pi_hash;
+  Bxo_hid_t pi_hid;
+  Bxo_loid_t pi_loid;
+};
+
+static constexpr BxoPredefIdent bxo_predef_idents[bxopredix__LAST+1] =
+{
+#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash) \
+  {Hash, Hid, Loid},
+#include "_bxo_predef.h"
+  {0, 0, 0}
+};
+
+static constexpr bool
+bxo_predef_idents_ok(void)
+{
+  for (unsigned ix=0; ix<(unsigned)bxopredix__LAST; ix++)
+    if (BxoObject::hash_from_hid_loid(bxo_predef_idents[ix].pi_hid, bxo_predef_idents[ix].pi_loid)
+        != bxo_predef_idents[ix].pi_hash)
+      return false;
+  return true;
+}
+static_assert(bxo_predef_idents_ok(), "bad hash of some predefined object");
+
+/// the predefined objects, with their shared_ptr control blocks, are
+/// carved from a static arena, so creating thousands of them does not
+/// touch the heap; they are never freed before exit
+#define BXO_PREDEF_ARENA_SLOT (sizeof(BxoObject)+64)
+alignas(std::max_align_t) static unsigned char
+bxo_predef_arena[(bxopredix__LAST+1)*BXO_PREDEF_ARENA_SLOT];
+static size_t bxo_predef_arena_used;
+
+template <typename T> class BxoPredefAllocator
+{
+public:
+  typedef T value_type;
+  BxoPredefAllocator() = default;
+  template <typename U> BxoPredefAllocator(const BxoPredefAllocator<U>&) {};
+  T* allocate(size_t n)
+  {
+    size_t off = (bxo_predef_arena_used + alignof(T) - 1) & ~(alignof(T) - 1);
+    if (BXO_UNLIKELY(off + n*sizeof(T) > sizeof(bxo_predef_arena)))
+      return static_cast<T*>(::operator new(n*sizeof(T)));
+    bxo_predef_arena_used = off + n*sizeof(T);
+    return reinterpret_cast<T*>(bxo_predef_arena + off);
+  };
+  void deallocate(T*p, size_t)
+  {
+    auto ad = reinterpret_cast<unsigned char*>(p);
+    if (ad < bxo_predef_arena || ad >= bxo_predef_arena + sizeof(bxo_predef_arena))
+      ::operator delete(p);
+  };
+  template <typename U> bool operator == (const BxoPredefAllocator<U>&) const
+  {
+    return true;
+  };
+  template <typename U> bool operator != (const BxoPredefAllocator<U>&) const
+  {
+    return false;
+  };
+};        // end BxoPredefAllocator
+
 void
 BxoObject::initialize_predefined_objects(void)
 {
@@ -153,20 +351,55 @@ BxoObject::initialize_predefined_objects(void)
       bxo_abort();
     }
   inited = true;
-
-#define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash)    \
-  BXO_VARPREDEF(Name) =                                 \
-    std::make_shared<BxoObject>(PredefTag{},            \
-           Hash,Hid,Loid);                              \
-  BXO_ASSERT(hash_from_hid_loid(Hid,Loid) == Hash,      \
-       "bad predefined " #Name);                        \
-  _predef_set_.insert(BXO_VARPREDEF(Name));
-
-#include "_bxo_predef.h"
-  printf("created %d predefined objects\n", (int)_predef_set_.size());
-  fflush(NULL);
+  constexpr unsigned nbpredef = bxopredix__LAST;
+  for (unsigned ix=0; ix<nbpredef; ix++)
+    {
+      const BxoPredefIdent& pi = bxo_predef_idents[ix];
+      *bxo_predef_vars[ix] =
+        std::allocate_shared<BxoObject>(BxoPredefAllocator<BxoObject> {}, PredefTag {},
+                                        pi.pi_hash, pi.pi_hid, pi.pi_loid);
+    }
+  /// register them all at once
+  _obnumvec_.reserve(_obnumvec_.size() + nbpredef);
+  _predef_set_.reserve(_predef_set_.size() + nbpredef);
+  for (unsigned ix=0; ix<nbpredef; ix++)
+    {
+      BxoObject*pob = bxo_predef_vars[ix]->get();
+      register_in_bucket(pob);
+      register_obnum(pob);
+      _predef_set_.insert(*bxo_predef_vars[ix]);
+    }
+  BXO_VERBOSELOG("created " << _predef_set_.size() << " predefined objects using "
+                 << bxo_predef_arena_used << " static bytes");
 } // end BxoObject::initialize_predefined_objects
 
+int
+BxoObject::register_predefined_names(void)
+{
+  constexpr unsigned nbpredef = bxopredix__LAST;
+  _namemap_.reserve(_namemap_.size() + nbpredef);
+  /// _bxo_predef.h is sorted by name, like _namedict_, so each
+  /// insertion goes just after the previous one
+  auto hint = _namedict_.begin();
+  for (unsigned ix=0; ix<nbpredef; ix++)
+    {
+      BxoObject*pob = bxo_predef_vars[ix]->get();
+      if (_predefnamed_[ix] == pob)
+        continue;
+      if (_predefnamed_[ix] != nullptr || _namemap_.find(pob) != _namemap_.end())
+        return ix;
+      std::string nam(bxo_predef_namekeys[ix].pk_str, bxo_predef_namekeys[ix].pk_len);
+      hint = _namedict_.emplace_hint(hint, nam, *bxo_predef_vars[ix]);
+      ++hint;
+      _namemap_.emplace(pob, std::move(nam));
+      _predefnamed_[ix] = pob;
+    }
+  BXO_ASSERT(_namedict_.size() == _namemap_.size(),
+             "different sizes namedict!" << _namedict_.size()
+             << " namemap!" << _namemap_.size());
+  return -1;
+} // end BxoObject::register_predefined_names
+
 void BxoObject::change_space(BxoSpace newsp)
 {
   BXO_ASSERT(newsp < BxoSpace::_Last, "bad newsp:" << (int)newsp);
@@ -213,6 +446,10 @@ BxoObject::all_names (void)
 
 BxoObject::~BxoObject()
 {
+  /// during global teardown every registry is going away as well, so
+  /// don't bother removing ourself from them
+  if (_tearingdown_)
+    return;
   /// objects are destroyed after main, then the bucket might be empty
   auto& curbuck = _bucketarr_[hi_id_bucketnum(_hid)];
   if (!curbuck.empty())
@@ -228,16 +465,82 @@ BxoObject::~BxoObject()
       if (it != _namemap_.end())
         {
           const std::string& nstr = it->second;
+          int pix = bxo_predef_name_index(nstr);
+          if (pix >= 0)
+            _predefnamed_[pix] = nullptr;
           _namedict_.erase(nstr);
           _namemap_.erase(it);
         }
     }
+  if (_obnum > 0)
+    {
+      auto& slot = _obnumvec_[_obnum];
+      BXO_ASSERT(slot._ptr == this && slot._pincnt == 0,
+                 "corrupted obnum#" << _obnum);
+      slot._ptr = nullptr;
+      _obnumfree_.push_back(_obnum);
+      _obnum = 0;
+    }
   _classob.reset();
   _attrh.clear();
   _compv.clear();
   _payl.reset();
 } // end of BxoObject::~BxoObject
 
+
+void
+BxoObject::register_obnum(BxoObject*pob)
+{
+  BXO_ASSERT(pob != nullptr && pob->_obnum == 0, "bad pob to register_obnum");
+  uint32_t num = 0;
+  if (!_obnumfree_.empty())
+    {
+      num = _obnumfree_.back();
+      _obnumfree_.pop_back();
+    }
+  else
+    {
+      if (BXO_UNLIKELY(_obnumvec_.size() >= UINT32_MAX))
+        {
+          BXO_BACKTRACELOG("register_obnum: too many objects");
+          throw std::runtime_error("BxoObject::register_obnum too many objects");
+        }
+      num = _obnumvec_.size();
+      _obnumvec_.emplace_back();
+    }
+  auto& slot = _obnumvec_[num];
+  slot._ptr = pob;
+  slot._pincnt = 0;
+  pob->_obnum = num;
+} // end BxoObject::register_obnum
+
+
+uint32_t
+BxoObject::pin_obnum(const std::shared_ptr<BxoObject>&pob)
+{
+  BXO_ASSERT(pob && pob->_obnum > 0, "bad pob to pin_obnum");
+  auto& slot = _obnumvec_[pob->_obnum];
+  if (slot._pincnt++ == 0)
+    slot._pin = pob;
+  return pob->_obnum;
+} // end BxoObject::pin_obnum
+
+
+void
+BxoObject::unpin_obnum(uint32_t num)
+{
+  BXO_ASSERT(num > 0 && num < _obnumvec_.size() && _obnumvec_[num]._pincnt > 0,
+             "bad num#" << num << " to unpin_obnum");
+  auto& slot = _obnumvec_[num];
+  if (--slot._pincnt == 0)
+    {
+      /// releasing the last pin might destroy the object, which
+      /// updates its slot, so move it out first
+      std::shared_ptr<BxoObject> pin = std::move(slot._pin);
+      slot._pin.reset();
+    }
+} // end BxoObject::unpin_obnum
+
 BxoObject*
 BxoObject::find_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid)
 {
@@ -257,6 +560,9 @@ BxoObject::find_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid)
 BxoObject*
 BxoObject::find_from_idstr(const std::string&idstr)
 {
+  int pix = bxo_predef_idstr_index(idstr);
+  if (pix >= 0 && *bxo_predef_vars[pix])
+    return bxo_predef_vars[pix]->get();
   Bxo_hid_t hid=0;
   Bxo_loid_t loid=0;
   if (!str_to_hid_loid(idstr, &hid, &loid)) return nullptr;
@@ -304,8 +610,6 @@ BxoObject::make_object(BxoSpace sp)
 std::shared_ptr<BxoObject>
 BxoObject::load_objref(BxoLoader&ld, const std::string& idstr)
 {
-  std::shared_ptr<BxoObject> pob = ld.find_loadedobj(idstr);
-  if (pob) return pob;
   Bxo_hid_t hid=0;
   Bxo_loid_t loid=0;
   if (!str_to_hid_loid(idstr,&hid,&loid))
@@ -313,9 +617,17 @@ BxoObject::load_objref(BxoLoader&ld, const std::string& idstr)
       BXO_BACKTRACELOG("load_objref bad idstr:" << idstr);
       throw std::runtime_error("BxoObject::load_objref bad idstr");
     }
+  return load_objref(ld,hid,loid);
+} // end BxoObject::load_objref
+
+std::shared_ptr<BxoObject>
+BxoObject::load_objref(BxoLoader&ld, Bxo_hid_t hid, Bxo_loid_t loid)
+{
+  std::shared_ptr<BxoObject> pob = ld.find_loadedobj(hid,loid);
+  if (pob) return pob;
   auto h = hash_from_hid_loid(hid,loid);
   pob.reset(new BxoObject(LoadedTag {},h,hid,loid));
-  ld.register_objref(idstr,pob);
+  ld.register_objref(pob);
   return pob;
 } // end BxoObject::load_objref
 
@@ -355,6 +667,9 @@ BxoObject::register_named(const std::string&namstr)
   BXO_VERBOSELOG("this=" << (void*)this << ":" << strid() << " namstr='" << namstr << "'");
   _namedict_.insert({namstr,shared_from_this()});
   _namemap_.insert({this,namstr});
+  int pix = bxo_predef_name_index(namstr);
+  if (pix >= 0)
+    _predefnamed_[pix] = this;
   BXO_ASSERT(_namedict_.size() == _namemap_.size(),
              "different sizes namedict!" << _namedict_.size()
              << " namemap!" << _namemap_.size());
@@ -376,6 +691,9 @@ BxoObject::forget_named(void)
              "corrupted _namedict_ for " << nam);
   _namedict_.erase(nam);
   _namemap_.erase (it);
+  int pix = bxo_predef_name_index(nam);
+  if (pix >= 0)
+    _predefnamed_[pix] = nullptr;
   return true;
 } // end BxoObject::forget_named
 
@@ -390,5 +708,8 @@ BxoObject::forget_name(const std::string&nam)
              "corrupted _namemap_ for " << nam);
   _namemap_.erase (obj);
   _namedict_.erase (it);
+  int pix = bxo_predef_name_index(nam);
+  if (pix >= 0)
+    _predefnamed_[pix] = nullptr;
   return true;
 } // end BxoObject::forget_name
@@ -47,6 +47,10 @@ class BxoAssovalPayload final : public BxoPayload
 {
   std::unordered_map<const std::shared_ptr<BxoObject>,BxoVal,BxoHashObjSharedPtr> _asso;
 public:
+  static BxoObject* payload_kind()
+  {
+    return BXO_VARPREDEF(payload_assoval).get();
+  };
   virtual std::shared_ptr<BxoObject> kind_ob() const
   {
     return BXO_VARPREDEF(payload_assoval);
@@ -57,7 +61,9 @@ public:
   };
   virtual void scan_payload_content(BxoDumper&) const;
   virtual const BxoJson emit_payload_content(BxoDumper&) const;
+  virtual bool write_payload_content(BxoDumper&, BxoJsonWriter&) const;
   virtual void load_payload_content(const BxoJson&, BxoLoader&);
+  virtual bool read_payload_content(BxoJsonReader&, BxoLoader&);
   BxoAssovalPayload(BxoObject& own)
     : BxoPayload(own, PayloadTag {}),
       _asso() {};
@@ -109,6 +115,41 @@ BxoAssovalPayload::emit_payload_content(BxoDumper&du) const
   return job;
 } // end BxoAssovalPayload::emit_payload_content
 
+bool
+BxoAssovalPayload::write_payload_content(BxoDumper&, BxoJsonWriter&jw) const
+{
+  std::vector<std::pair<BxoObject*,const BxoVal*>> atvec;
+  atvec.reserve(_asso.size());
+  for (const auto& p: _asso)
+    {
+      if (!jw.is_dumpable(p.first)) continue;
+      atvec.push_back({p.first.get(), &p.second});
+    }
+  std::sort(atvec.begin(), atvec.end(),
+            [](const std::pair<BxoObject*,const BxoVal*>&l,
+               const std::pair<BxoObject*,const BxoVal*>&r)
+  {
+    return BxoLessObjPtr()(l.first, r.first);
+  });
+  jw.begin_object();
+  jw.key("@owner");
+  jw.put_objid(owner());
+  jw.key("assoval");
+  jw.begin_array();
+  for (auto& p: atvec)
+    {
+      jw.begin_object();
+      jw.key("at");
+      jw.put_objid(p.first);
+      jw.key("va");
+      p.second->write_json(jw);
+      jw.end_object();
+    }
+  jw.end_array();
+  jw.end_object();
+  return true;
+} // end BxoAssovalPayload::write_payload_content
+
 void
 BxoAssovalPayload::load_payload_content(const BxoJson&jv, BxoLoader&ld)
 {
@@ -135,6 +176,29 @@ BxoAssovalPayload::load_payload_content(const BxoJson&jv, BxoLoader&ld)
     }
 } // end BxoAssovalPayload::load_payload_content
 
+bool
+BxoAssovalPayload::read_payload_content(BxoJsonReader&jr, BxoLoader&ld)
+{
+  jr.begin_object();
+  while (jr.next_key())
+    {
+      if (jr.key_is("assoval") && jr.peek() == '[')
+        {
+          jr.begin_array();
+          while (jr.next_element())
+            {
+              std::shared_ptr<BxoObject> pobat;
+              BxoVal aval;
+              if (ld.read_attribute(jr,pobat,aval))
+                _asso.insert({pobat,aval});
+            }
+        }
+      else
+        jr.skip_value();
+    }
+  return true;
+} // end BxoAssovalPayload::read_payload_content
+
 
 BxoPayload*
 bxoload_payload_assoval(BxoObject*obj,BxoLoader*ld)
@@ -149,13 +213,131 @@ bxoload_payload_assoval(BxoObject*obj,BxoLoader*ld)
 
 BxoHashsetPayload::BxoHashsetPayload(BxoObject& own)
   : BxoPayload(own, PayloadTag {}),
-    _hset() {};
+    _hsnums(), _hscount(0), _hslog(0) {};
 
 BxoHashsetPayload::~BxoHashsetPayload()
 {
-  _hset.clear();
+  clear();
 };
 
+int
+BxoHashsetPayload::num_index(uint32_t num) const
+{
+  if (num == 0 || _hscount == 0)
+    return -1;
+  unsigned mask = _hsnums.size() - 1;
+  /// the table is never full, so we end on an empty slot
+  for (unsigned ix = num_start(num); ; ix = (ix+1) & mask)
+    {
+      uint32_t curnum = _hsnums[ix];
+      if (curnum == num)
+        return (int)ix;
+      if (curnum == 0)
+        return -1;
+    }
+} // end BxoHashsetPayload::num_index
+
+void
+BxoHashsetPayload::reserve(unsigned nbel)
+{
+  unsigned log = 4;
+  while (((uint64_t)1 << log) * 3 < (uint64_t)nbel * 4)
+    log++;
+  if (((size_t)1 << log) <= _hsnums.size())
+    return;
+  if (BXO_UNLIKELY(log > 31))
+    {
+      BXO_BACKTRACELOG("BxoHashsetPayload::reserve too big nbel=" << nbel);
+      throw std::runtime_error("BxoHashsetPayload::reserve too big");
+    }
+  std::vector<uint32_t> oldnums(1U << log, 0);
+  oldnums.swap(_hsnums);
+  _hslog = log;
+  unsigned mask = _hsnums.size() - 1;
+  for (uint32_t num : oldnums)
+    {
+      if (!num) continue;
+      unsigned ix = num_start(num);
+      while (_hsnums[ix] != 0)
+        ix = (ix+1) & mask;
+      _hsnums[ix] = num;
+    }
+} // end BxoHashsetPayload::reserve
+
+/// backward shift deletion, so we don't need tombstones
+void
+BxoHashsetPayload::hs_erase_at(unsigned gap)
+{
+  unsigned mask = _hsnums.size() - 1;
+  unsigned ix = gap;
+  for (;;)
+    {
+      ix = (ix+1) & mask;
+      uint32_t curnum = _hsnums[ix];
+      if (curnum == 0)
+        break;
+      unsigned home = num_start(curnum);
+      if (((ix - home) & mask) >= ((ix - gap) & mask))
+        {
+          _hsnums[gap] = curnum;
+          gap = ix;
+        }
+    }
+  _hsnums[gap] = 0;
+} // end BxoHashsetPayload::hs_erase_at
+
+void
+BxoHashsetPayload::add(std::shared_ptr<BxoObject> pob)
+{
+  if (!pob || num_index(pob->obnum()) >= 0)
+    return;
+  reserve(_hscount+1);
+  uint32_t num = BxoObject::pin_obnum(pob);
+  unsigned mask = _hsnums.size() - 1;
+  unsigned ix = num_start(num);
+  while (_hsnums[ix] != 0)
+    ix = (ix+1) & mask;
+  _hsnums[ix] = num;
+  _hscount++;
+} // end BxoHashsetPayload::add
+
+void
+BxoHashsetPayload::remove(std::shared_ptr<BxoObject> pob)
+{
+  if (!pob)
+    return;
+  int ix = num_index(pob->obnum());
+  if (ix < 0)
+    return;
+  uint32_t num = _hsnums[ix];
+  hs_erase_at(ix);
+  _hscount--;
+  BxoObject::unpin_obnum(num);
+} // end BxoHashsetPayload::remove
+
+void
+BxoHashsetPayload::clear(void)
+{
+  /// unpinning could destroy our owner, so empty the table first
+  std::vector<uint32_t> oldnums;
+  oldnums.swap(_hsnums);
+  _hscount = 0;
+  _hslog = 0;
+  for (uint32_t num : oldnums)
+    if (num)
+      BxoObject::unpin_obnum(num);
+} // end BxoHashsetPayload::clear
+
+BxoVal
+BxoHashsetPayload::vset() const
+{
+  std::vector<BxoObject*> vecob;
+  vecob.reserve(_hscount);
+  for (BxoObject*pob : *this)
+    vecob.push_back(pob);
+  return BxoVSet(vecob);
+} // end BxoHashsetPayload::vset
+
 std::shared_ptr<BxoObject>
 BxoHashsetPayload::kind_ob() const
 {
@@ -171,15 +353,15 @@ BxoHashsetPayload::module_ob() const
 void
 BxoHashsetPayload::scan_payload_content(BxoDumper&du) const
 {
-  for (auto pob : _hset)
-    du.scan_dumpable(pob.get());
+  for (BxoObject*pob : *this)
+    du.scan_dumpable(pob);
 } // end of BxoHashsetPayload::scan_payload_content
 
 const BxoJson
 BxoHashsetPayload::emit_payload_content(BxoDumper&du) const
 {
-  std::set<std::shared_ptr<BxoObject>,BxoLessObjSharedPtr> elset;
-  for (auto pob: _hset)
+  std::set<BxoObject*,BxoLessObjPtr> elset;
+  for (BxoObject*pob : *this)
     {
       BXO_ASSERT(pob, "null element");
       if (!du.is_dumpable(pob)) continue;
@@ -196,6 +378,29 @@ BxoHashsetPayload::emit_payload_content(BxoDumper&du) const
   return job;
 } // end of BxoHashsetPayload::emit_payload_content
 
+bool
+BxoHashsetPayload::write_payload_content(BxoDumper&, BxoJsonWriter&jw) const
+{
+  std::vector<BxoObject*> elvec;
+  for (BxoObject*pob : *this)
+    {
+      BXO_ASSERT(pob, "null element");
+      if (!jw.is_dumpable(pob)) continue;
+      elvec.push_back(pob);
+    }
+  std::sort(elvec.begin(), elvec.end(), BxoLessObjPtr());
+  jw.begin_object();
+  jw.key("@owner");
+  jw.put_objid(owner());
+  jw.key("hashset");
+  jw.begin_array();
+  for (BxoObject*pob : elvec)
+    jw.put_objid(pob);
+  jw.end_array();
+  jw.end_object();
+  return true;
+} // end of BxoHashsetPayload::write_payload_content
+
 void
 BxoHashsetPayload::load_payload_content(const BxoJson&jv, BxoLoader&ld)
 {
@@ -205,19 +410,49 @@ BxoHashsetPayload::load_payload_content(const BxoJson&jv, BxoLoader&ld)
       if (jhs.isArray())
         {
           auto nbel = jhs.size();
-          _hset.reserve(5*nbel/4+1);
+          reserve(nbel);
           for (int ix=0; ix<(int)nbel; ix++)
             {
               const BxoJson& jel = jhs[ix];
               if (!jel.isString()) continue;
               auto pobel = ld.find_loadedobj(jel.asString());
               if (!pobel) continue;
-              _hset.insert(pobel);
+              add(pobel);
             }
         }
     }
 } // end of BxoHashsetPayload::load_payload_content
 
+bool
+BxoHashsetPayload::read_payload_content(BxoJsonReader&jr, BxoLoader&ld)
+{
+  jr.begin_object();
+  while (jr.next_key())
+    {
+      if (jr.key_is("hashset") && jr.peek() == '[')
+        {
+          jr.begin_array();
+          while (jr.next_element())
+            {
+              Bxo_hid_t hid=0;
+              Bxo_loid_t loid=0;
+              if (jr.peek() != '"')
+                {
+                  jr.skip_value();
+                  continue;
+                }
+              if (!jr.get_id(hid,loid)) continue;
+              auto pobel = ld.find_loadedobj(hid,loid);
+              if (!pobel) continue;
+              add(pobel);
+            }
+        }
+      else
+        jr.skip_value();
+    }
+  return true;
+} // end of BxoHashsetPayload::read_payload_content
+
 
 BxoPayload*
 bxoload_payload_hashset(BxoObject*obj,BxoLoader*ld)
@@ -236,6 +471,10 @@ class BxoSystemPayload final : public BxoPayload
 public:
   void generate_predef(BxoDumper*du) const;
   void generate_global(BxoDumper*du) const;
+  static BxoObject* payload_kind()
+  {
+    return BXO_VARPREDEF(payload_system).get();
+  };
   virtual std::shared_ptr<BxoObject> kind_ob() const
   {
     return BXO_VARPREDEF(payload_system);
@@ -246,6 +485,7 @@ public:
   };
   virtual void scan_payload_content(BxoDumper&) const;
   virtual const BxoJson emit_payload_content(BxoDumper&) const;
+  virtual bool write_payload_content(BxoDumper&, BxoJsonWriter&) const;
   virtual void load_payload_content(const BxoJson&, BxoLoader&);
   BxoSystemPayload(BxoObject& own)
     : BxoPayload(own, PayloadTag {}),
@@ -276,6 +516,58 @@ BxoSystemPayload::scan_payload_content(BxoDumper&du) const
 
 
 
+/// hash and displace: for each bucket of keys, biggest first, find a
+/// displacement putting all its keys in free slots
+static bool
+bxo_predef_displace(const std::vector<std::string>&keys, unsigned hashbits,
+                    unsigned bucketbits, std::vector<uint16_t>&displ)
+{
+  std::vector<std::vector<uint32_t>> buckets(1u << bucketbits);
+  for (auto& k : keys)
+    {
+      uint32_t h = bxo_predef_strhash(k.data(), k.size());
+      buckets[bxo_predef_bucket(h, bucketbits)].push_back(h);
+    }
+  std::vector<unsigned> order(buckets.size());
+  for (unsigned bu=0; bu<order.size(); bu++)
+    order[bu] = bu;
+  std::stable_sort(order.begin(), order.end(), [&](unsigned l, unsigned r)
+  {
+    return buckets[l].size() > buckets[r].size();
+  });
+  std::vector<bool> used(1u << hashbits);
+  std::vector<unsigned> slots;
+  displ.assign(buckets.size(), 0);
+  for (unsigned bu : order)
+    {
+      auto& bucket = buckets[bu];
+      if (bucket.empty())
+        break;
+      bool placed = false;
+      for (unsigned d=0; d<=UINT16_MAX && !placed; d++)
+        {
+          slots.clear();
+          for (uint32_t h : bucket)
+            {
+              unsigned sl = bxo_predef_slot(h, d, hashbits);
+              if (used[sl] || std::find(slots.begin(), slots.end(), sl) != slots.end())
+                break;
+              slots.push_back(sl);
+            }
+          if (slots.size() == bucket.size())
+            {
+              for (unsigned sl : slots)
+                used[sl] = true;
+              displ[bu] = d;
+              placed = true;
+            }
+        }
+      if (!placed)
+        return false;
+    }
+  return true;
+} // end bxo_predef_displace
+
 void
 BxoSystemPayload::generate_predef(BxoDumper*pdu) const
 {
@@ -286,7 +578,9 @@ BxoSystemPayload::generate_predef(BxoDumper*pdu) const
                  << " prpath=" << prpath);
   std::ofstream os(prpath);
   os << BxoGplv3LicenseOut(_predefpath, "//", "") << std::flush;
-  auto prset = BxoObject::set_of_predefined_objects().get_set();
+  // keep the set value alive while we iterate on its elements
+  BxoVal prsetv = BxoObject::set_of_predefined_objects();
+  auto prset = prsetv.get_set();
   std::vector<std::shared_ptr<BxoObject>> prvec;
   prvec.reserve(prset->length()+1);
   auto pbeg = prset->begin();
@@ -310,6 +604,47 @@ BxoSystemPayload::generate_predef(BxoDumper*pdu) const
      << "#undef BXO_NB_PREDEFINED" << std::endl
      << "#define BXO_NB_PREDEFINED  " << prvec.size() << std::endl;
 
+  /// perfect hash tables of the ids and of the names, with a quarter
+  /// of free slots and about four keys per bucket
+  std::vector<std::string> idkeys, namekeys;
+  for (auto pob: prvec)
+    {
+      idkeys.push_back(pob->strid());
+      namekeys.push_back(pob->pname());
+    }
+  unsigned hashbits = 1, bucketbits = 1;
+  while ((1u << hashbits) < prvec.size() + prvec.size()/4)
+    hashbits++;
+  while ((4u << bucketbits) < prvec.size())
+    bucketbits++;
+  std::vector<uint16_t> iddispl, namedispl;
+  while (!bxo_predef_displace(idkeys, hashbits, bucketbits, iddispl)
+         || !bxo_predef_displace(namekeys, hashbits, bucketbits, namedispl))
+    {
+      BXO_ASSERT(hashbits < 30, "generate_predef cannot hash " << prvec.size() << " predefined");
+      hashbits++;
+    }
+  BXO_VERBOSELOG("generate_predef " << prvec.size() << " predefined, hash bits " << hashbits
+                 << " bucket bits " << bucketbits);
+  auto emit_displ = [&](const char*macname, const std::vector<uint16_t>&displ)
+  {
+    os << "#undef " << macname << std::endl
+       << "#define " << macname << " \\" << std::endl << " ";
+    for (unsigned ix=0; ix<displ.size(); ix++)
+      {
+        os << " " << displ[ix] << ",";
+        if (ix % 16 == 15 && ix+1 < displ.size())
+          os << " \\" << std::endl << " ";
+      }
+    os << std::endl;
+  };
+  os << "#undef BXO_PREDEF_HASH_BITS" << std::endl
+     << "#define BXO_PREDEF_HASH_BITS  " << hashbits << std::endl
+     << "#undef BXO_PREDEF_BUCKET_BITS" << std::endl
+     << "#define BXO_PREDEF_BUCKET_BITS  " << bucketbits << std::endl;
+  emit_displ("BXO_PREDEF_ID_DISPL", iddispl);
+  emit_displ("BXO_PREDEF_NAME_DISPL", namedispl);
+
   os << "/// BXO_HAS_PREDEFINED(Nam,Idstr,Hid,Loid,Hash)" << std::endl;
   os << std::endl;
 
@@ -438,6 +773,22 @@ BxoSystemPayload::emit_payload_content(BxoDumper&du BXO_UNUSED) const
   return job;
 } // end of BxoSystemPayload::emit_payload_content
 
+bool
+BxoSystemPayload::write_payload_content(BxoDumper&, BxoJsonWriter&jw) const
+{
+  jw.begin_object();
+  jw.key("@owner");
+  jw.put_objid(owner());
+  jw.key("globalpath");
+  jw.put_string(_globalpath);
+  jw.key("predefpath");
+  jw.put_string(_predefpath);
+  jw.key("system");
+  jw.put_bool(true);
+  jw.end_object();
+  return true;
+} // end of BxoSystemPayload::write_payload_content
+
 void
 BxoSystemPayload::load_payload_content(const BxoJson&jv, BxoLoader&ld BXO_UNUSED)
 {
@@ -0,0 +1,649 @@
+// file rope.cc - immutable ropes of UTF-8 text
+
+/**   Copyright (C)  2016 Basile Starynkevitch
+
+      BASIXMO is free software; you can redistribute it and/or modify
+      it under the terms of the GNU General Public License as published by
+      the Free Software Foundation; either version 3, or (at your option)
+      any later version.
+
+      BASIXMO is distributed in the hope that it will be useful,
+      but WITHOUT ANY WARRANTY; without even the implied warranty of
+      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+      GNU General Public License for more details.
+      You should have received a copy of the GNU General Public License
+      along with BASIXMO; see the file COPYING3.   If not see
+      <http://www.gnu.org/licenses/>.
+**/
+#include "basixmo.h"
+
+/// the polynomial hash of the n bytes s is the sum of s[i]*B^(n-1-i)
+/// modulo 2^64, so the hash of a concatenation l+r is
+/// hash(l)*B^len(r)+hash(r), whatever the chunking
+#define BXO_ROPE_HASHBASE UINT64_C(0x100000001b3)
+
+class BxoRopeNode
+{
+  friend class BxoRope;
+  friend class BxoRopeCursor;
+public:
+  typedef std::shared_ptr<const BxoRopeNode> ptr_t;
+  struct TagLeaf {};
+  struct TagInner {};
+private:
+  const ptr_t _left;		// null in leaves
+  const ptr_t _right;		// null in leaves
+  const std::string _chunk;	// empty in inner nodes
+  const size_t _len;
+  const uint64_t _polyhash;
+  const uint64_t _polypow;	// B^_len
+  const unsigned _height;	// 1 for leaves
+public:
+  BxoRopeNode(TagLeaf, const char*s, size_t len);
+  BxoRopeNode(TagInner, const ptr_t&l, const ptr_t&r)
+    : _left(l), _right(r), _chunk(), _len(l->_len + r->_len),
+      _polyhash(l->_polyhash * r->_polypow + r->_polyhash),
+      _polypow(l->_polypow * r->_polypow),
+      _height(1 + std::max(l->_height, r->_height)) {};
+  BxoRopeNode(const BxoRopeNode&) = delete;
+  BxoRopeNode(BxoRopeNode&&) = delete;
+  bool is_leaf() const
+  {
+    return !_left;
+  };
+  static unsigned height(const ptr_t&n)
+  {
+    return n?n->_height:0;
+  };
+  static size_t length(const ptr_t&n)
+  {
+    return n?n->_len:0;
+  };
+  static ptr_t make_leaf(const char*s, size_t len)
+  {
+    return ptr_t(new BxoRopeNode(TagLeaf {}, s, len));
+  };
+  static ptr_t make_inner(const ptr_t&l, const ptr_t&r)
+  {
+    return ptr_t(new BxoRopeNode(TagInner {}, l, r));
+  };
+  static ptr_t make_chunked(const char*s, size_t len);
+  static ptr_t balance(const ptr_t&l, const ptr_t&r);
+  static ptr_t join(const ptr_t&l, const ptr_t&r);
+  static ptr_t concat(const ptr_t&l, const ptr_t&r);
+  static void split(const ptr_t&n, size_t pos, ptr_t&lft, ptr_t&rgt);
+  static void each_chunk(const BxoRopeNode*n, const std::function<void(const char*,size_t)>&f);
+  static void copy_range(const BxoRopeNode*n, size_t pos, size_t len, std::string&out);
+};        // end class BxoRopeNode
+
+
+static uint64_t
+bxo_rope_pow(uint64_t b, size_t n)
+{
+  uint64_t r = 1;
+  while (n > 0)
+    {
+      if (n & 1) r *= b;
+      b *= b;
+      n >>= 1;
+    }
+  return r;
+} // end bxo_rope_pow
+
+/// eight bytes per step, so the multiply chain is eight times shorter
+static uint64_t BXO_OPTIMIZEDFUN
+bxo_rope_polyhash(const unsigned char*p, size_t n)
+{
+  constexpr uint64_t b1 = BXO_ROPE_HASHBASE;
+  constexpr uint64_t b2 = b1*b1, b3 = b2*b1, b4 = b3*b1;
+  constexpr uint64_t b5 = b4*b1, b6 = b5*b1, b7 = b6*b1, b8 = b7*b1;
+  uint64_t h = 0;
+  size_t ix = 0;
+  for (; ix+8 <= n; ix += 8, p += 8)
+    h = h*b8 + (p[0]*b7 + p[1]*b6 + p[2]*b5 + p[3]*b4
+                + p[4]*b3 + p[5]*b2 + p[6]*b1 + (uint64_t)p[7]);
+  for (; ix < n; ix++, p++)
+    h = h*b1 + *p;
+  return h;
+} // end bxo_rope_polyhash
+
+
+BxoRopeNode::BxoRopeNode(TagLeaf, const char*s, size_t len)
+  : _left(nullptr), _right(nullptr), _chunk(s, len), _len(len),
+    _polyhash(bxo_rope_polyhash((const unsigned char*)s, len)),
+    _polypow(bxo_rope_pow(BXO_ROPE_HASHBASE, len)),
+    _height(1)
+{
+} // end BxoRopeNode::BxoRopeNode leaf
+
+
+/// a balanced tree of chunks, never cutting inside a UTF-8 character
+BxoRopeNode::ptr_t
+BxoRopeNode::make_chunked(const char*s, size_t len)
+{
+  if (len == 0) return nullptr;
+  std::vector<ptr_t> leaves;
+  leaves.reserve(len/BXO_ROPE_CHUNK_MAX + 1);
+  size_t off = 0;
+  while (off < len)
+    {
+      size_t cut = off + BXO_ROPE_CHUNK_MAX;
+      if (cut >= len)
+        cut = len;
+      else
+        while (cut > off + 1 && ((unsigned char)s[cut] & 0xc0) == 0x80)
+          cut--;
+      leaves.push_back(make_leaf(s+off, cut-off));
+      off = cut;
+    }
+  // pair the nodes level by level; sibling heights differ by at most one
+  while (leaves.size() > 1)
+    {
+      size_t nbpairs = leaves.size()/2;
+      std::vector<ptr_t> upper;
+      upper.reserve(nbpairs+1);
+      for (size_t ix=0; ix<nbpairs; ix++)
+        upper.push_back(make_inner(leaves[2*ix], leaves[2*ix+1]));
+      if (leaves.size() % 2)
+        upper.back() = join(upper.back(), leaves.back());
+      leaves.swap(upper);
+    }
+  return leaves[0];
+} // end BxoRopeNode::make_chunked
+
+
+/// join l & r whose heights differ by at most two, rotating if needed
+BxoRopeNode::ptr_t
+BxoRopeNode::balance(const ptr_t&l, const ptr_t&r)
+{
+  unsigned hl = height(l), hr = height(r);
+  if (hl > hr+1)
+    {
+      if (height(l->_left) >= height(l->_right))
+        return make_inner(l->_left, make_inner(l->_right, r));
+      const ptr_t&lr = l->_right;
+      return make_inner(make_inner(l->_left, lr->_left), make_inner(lr->_right, r));
+    }
+  if (hr > hl+1)
+    {
+      if (height(r->_right) >= height(r->_left))
+        return make_inner(make_inner(l, r->_left), r->_right);
+      const ptr_t&rl = r->_left;
+      return make_inner(make_inner(l, rl->_left), make_inner(rl->_right, r->_right));
+    }
+  return make_inner(l, r);
+} // end BxoRopeNode::balance
+
+
+/// the AVL join, going down the spine of the taller tree
+BxoRopeNode::ptr_t
+BxoRopeNode::join(const ptr_t&l, const ptr_t&r)
+{
+  if (!l) return r;
+  if (!r) return l;
+  unsigned hl = l->_height, hr = r->_height;
+  if (hl > hr+1)
+    return balance(l->_left, join(l->_right, r));
+  if (hr > hl+1)
+    return balance(join(l, r->_left), r->_right);
+  return make_inner(l, r);
+} // end BxoRopeNode::join
+
+
+/// join, but first merge the last leaf of l with the first leaf of r
+/// when they fit in one chunk, so repeated small edits do not leave
+/// tiny leaves behind
+BxoRopeNode::ptr_t
+BxoRopeNode::concat(const ptr_t&l, const ptr_t&r)
+{
+  if (!l) return r;
+  if (!r) return l;
+  const BxoRopeNode*lastleaf = l.get();
+  while (!lastleaf->is_leaf())
+    lastleaf = lastleaf->_right.get();
+  const BxoRopeNode*firstleaf = r.get();
+  while (!firstleaf->is_leaf())
+    firstleaf = firstleaf->_left.get();
+  if (lastleaf->_len + firstleaf->_len > BXO_ROPE_CHUNK_MAX)
+    return join(l, r);
+  std::string merged;
+  merged.reserve(lastleaf->_len + firstleaf->_len);
+  merged.append(lastleaf->_chunk);
+  merged.append(firstleaf->_chunk);
+  ptr_t lhead, ltail, rhead, rtail;
+  // splitting at leaf boundaries copies no chunk
+  split(l, l->_len - lastleaf->_len, lhead, ltail);
+  split(r, firstleaf->_len, rhead, rtail);
+  return join(join(lhead, make_leaf(merged.data(), merged.size())), rtail);
+} // end BxoRopeNode::concat
+
+
+void
+BxoRopeNode::split(const ptr_t&n, size_t pos, ptr_t&lft, ptr_t&rgt)
+{
+  if (!n || pos == 0)
+    {
+      lft = nullptr;
+      rgt = n;
+      return;
+    }
+  if (pos >= n->_len)
+    {
+      lft = n;
+      rgt = nullptr;
+      return;
+    }
+  if (n->is_leaf())
+    {
+      lft = make_leaf(n->_chunk.data(), pos);
+      rgt = make_leaf(n->_chunk.data()+pos, n->_len-pos);
+      return;
+    }
+  size_t leftlen = n->_left->_len;
+  if (pos < leftlen)
+    {
+      ptr_t sublft, subrgt;
+      split(n->_left, pos, sublft, subrgt);
+      lft = sublft;
+      rgt = join(subrgt, n->_right);
+    }
+  else if (pos == leftlen)
+    {
+      lft = n->_left;
+      rgt = n->_right;
+    }
+  else
+    {
+      ptr_t sublft, subrgt;
+      split(n->_right, pos-leftlen, sublft, subrgt);
+      lft = join(n->_left, sublft);
+      rgt = subrgt;
+    }
+} // end BxoRopeNode::split
+
+
+void
+BxoRopeNode::each_chunk(const BxoRopeNode*n, const std::function<void(const char*,size_t)>&f)
+{
+  while (n && !n->is_leaf())
+    {
+      each_chunk(n->_left.get(), f);
+      n = n->_right.get();
+    }
+  if (n)
+    f(n->_chunk.data(), n->_len);
+} // end BxoRopeNode::each_chunk
+
+
+void
+BxoRopeNode::copy_range(const BxoRopeNode*n, size_t pos, size_t len, std::string&out)
+{
+  while (n && len > 0)
+    {
+      if (n->is_leaf())
+        {
+          out.append(n->_chunk.data()+pos, std::min(len, n->_len-pos));
+          return;
+        }
+      size_t leftlen = n->_left->_len;
+      if (pos < leftlen)
+        {
+          size_t leftpart = std::min(len, leftlen-pos);
+          copy_range(n->_left.get(), pos, leftpart, out);
+          len -= leftpart;
+          pos = 0;
+        }
+      else
+        pos -= leftlen;
+      n = n->_right.get();
+    }
+} // end BxoRopeNode::copy_range
+
+
+
+static BxoHash_t
+bxo_rope_fold_hash(uint64_t polyhash, size_t len)
+{
+  uint64_t h = polyhash ^ ((uint64_t)len * UINT64_C(0x9e3779b97f4a7c15));
+  h ^= h >> 29;
+  h *= UINT64_C(0xbf58476d1ce4e5b9);
+  h ^= h >> 32;
+  BxoHash_t r = (BxoHash_t)h;
+  if (BXO_UNLIKELY(r == 0))
+    r = (len & 0xffff) + 17;
+  return r;
+} // end bxo_rope_fold_hash
+
+
+BxoRope::BxoRope(const std::shared_ptr<const BxoRopeNode>&root)
+  : _root(root),
+    _hash(bxo_rope_fold_hash(root?root->_polyhash:0, BxoRopeNode::length(root)))
+{
+} // end BxoRope::BxoRope
+
+BxoRope::~BxoRope()
+{
+} // end BxoRope::~BxoRope
+
+
+const BxoRope*
+BxoRope::make_rope(const char*s, size_t len)
+{
+  if (BXO_UNLIKELY(!s && len>0))
+    {
+      BXO_BACKTRACELOG("make_rope: null string of length " << len);
+      throw std::runtime_error("BxoRope::make_rope null string");
+    }
+  if (!bxo_utf8_valid(s, len))
+    {
+      BXO_BACKTRACELOG("make_rope: invalid UTF-8 of length " << len);
+      throw std::runtime_error("BxoRope::make_rope invalid UTF-8");
+    }
+  return make_from_node(BxoRopeNode::make_chunked(s, len));
+} // end BxoRope::make_rope
+
+
+const BxoRope*
+BxoRope::load_rope(const BxoJson&js)
+{
+  if (!js.isString()) return nullptr;
+  const char*strbeg = nullptr;
+  const char*strend = nullptr;
+  js.getString(&strbeg, &strend);
+  return make_rope(strbeg, strend - strbeg);
+} // end BxoRope::load_rope
+
+
+size_t
+BxoRope::length() const
+{
+  return BxoRopeNode::length(_root);
+} // end BxoRope::length
+
+unsigned
+BxoRope::depth() const
+{
+  return BxoRopeNode::height(_root);
+} // end BxoRope::depth
+
+/// in linear time, for statistics
+unsigned
+BxoRope::nb_chunks() const
+{
+  unsigned nb = 0;
+  each_chunk([&](const char*, size_t)
+  {
+    nb++;
+  });
+  return nb;
+} // end BxoRope::nb_chunks
+
+
+int
+BxoRope::byte_at(size_t pos) const
+{
+  const BxoRopeNode*n = _root.get();
+  if (!n || pos >= n->_len)
+    return -1;
+  while (!n->is_leaf())
+    {
+      size_t leftlen = n->_left->_len;
+      if (pos < leftlen)
+        n = n->_left.get();
+      else
+        {
+          pos -= leftlen;
+          n = n->_right.get();
+        }
+    }
+  return (unsigned char)n->_chunk[pos];
+} // end BxoRope::byte_at
+
+
+void
+BxoRope::check_boundary(size_t pos, const char*opname) const
+{
+  if (BXO_UNLIKELY(pos > length()))
+    {
+      BXO_BACKTRACELOG(opname << ": position " << pos
+                       << " beyond rope of length " << length());
+      throw std::runtime_error("BxoRope position out of range");
+    }
+  int b = byte_at(pos);
+  if (BXO_UNLIKELY(b >= 0 && (b & 0xc0) == 0x80))
+    {
+      BXO_BACKTRACELOG(opname << ": position " << pos
+                       << " inside a UTF-8 character");
+      throw std::runtime_error("BxoRope position inside a character");
+    }
+} // end BxoRope::check_boundary
+
+
+void
+BxoRope::each_chunk(const std::function<void(const char*,size_t)>&f) const
+{
+  BxoRopeNode::each_chunk(_root.get(), f);
+} // end BxoRope::each_chunk
+
+
+std::string
+BxoRope::to_string() const
+{
+  std::string res;
+  res.reserve(length());
+  each_chunk([&](const char*s, size_t len)
+  {
+    res.append(s, len);
+  });
+  return res;
+} // end BxoRope::to_string
+
+
+std::string
+BxoRope::substring(size_t pos, size_t len) const
+{
+  check_boundary(pos, "BxoRope::substring");
+  len = std::min(len, length()-pos);
+  check_boundary(pos+len, "BxoRope::substring");
+  std::string res;
+  res.reserve(len);
+  BxoRopeNode::copy_range(_root.get(), pos, len, res);
+  return res;
+} // end BxoRope::substring
+
+
+const BxoRope*
+BxoRope::sub_rope(size_t pos, size_t len) const
+{
+  check_boundary(pos, "BxoRope::sub_rope");
+  len = std::min(len, length()-pos);
+  check_boundary(pos+len, "BxoRope::sub_rope");
+  BxoRopeNode::ptr_t head, rest, mid, tail;
+  BxoRopeNode::split(_root, pos, head, rest);
+  BxoRopeNode::split(rest, len, mid, tail);
+  return make_from_node(mid);
+} // end BxoRope::sub_rope
+
+
+const BxoRope*
+BxoRope::insert(size_t pos, const char*s, size_t len) const
+{
+  check_boundary(pos, "BxoRope::insert");
+  if (BXO_UNLIKELY(!s && len>0))
+    {
+      BXO_BACKTRACELOG("BxoRope::insert: null string of length " << len);
+      throw std::runtime_error("BxoRope::insert null string");
+    }
+  if (!bxo_utf8_valid(s, len))
+    {
+      BXO_BACKTRACELOG("BxoRope::insert: invalid UTF-8 of length " << len);
+      throw std::runtime_error("BxoRope::insert invalid UTF-8");
+    }
+  BxoRopeNode::ptr_t head, tail;
+  BxoRopeNode::split(_root, pos, head, tail);
+  auto mid = BxoRopeNode::make_chunked(s, len);
+  return make_from_node(BxoRopeNode::concat(BxoRopeNode::concat(head, mid), tail));
+} // end BxoRope::insert
+
+
+const BxoRope*
+BxoRope::insert(size_t pos, const BxoRope&r) const
+{
+  check_boundary(pos, "BxoRope::insert");
+  BxoRopeNode::ptr_t head, tail;
+  BxoRopeNode::split(_root, pos, head, tail);
+  return make_from_node(BxoRopeNode::concat(BxoRopeNode::concat(head, r._root), tail));
+} // end BxoRope::insert rope
+
+
+const BxoRope*
+BxoRope::erase(size_t pos, size_t len) const
+{
+  check_boundary(pos, "BxoRope::erase");
+  len = std::min(len, length()-pos);
+  check_boundary(pos+len, "BxoRope::erase");
+  BxoRopeNode::ptr_t head, rest, mid, tail;
+  BxoRopeNode::split(_root, pos, head, rest);
+  BxoRopeNode::split(rest, len, mid, tail);
+  return make_from_node(BxoRopeNode::concat(head, tail));
+} // end BxoRope::erase
+
+
+const BxoRope*
+BxoRope::concat(const BxoRope&r) const
+{
+  return make_from_node(BxoRopeNode::concat(_root, r._root));
+} // end BxoRope::concat
+
+
+
+/// walks the leaves of a rope; the pending subtrees are kept on a
+/// stack, so two cursors at the same offset can skip a shared subtree
+class BxoRopeCursor
+{
+  std::vector<const BxoRopeNode*> _pending;
+public:
+  const char*_ptr;
+  size_t _rem;
+  BxoRopeCursor(const BxoRopeNode*root) : _pending(), _ptr(nullptr), _rem(0)
+  {
+    if (root)
+      _pending.push_back(root);
+  };
+  const BxoRopeNode*top() const
+  {
+    return _pending.empty()?nullptr:_pending.back();
+  };
+  void pop()
+  {
+    _pending.pop_back();
+  };
+  void expand_top()
+  {
+    const BxoRopeNode*n = _pending.back();
+    _pending.pop_back();
+    _pending.push_back(n->_right.get());
+    _pending.push_back(n->_left.get());
+  };
+  bool next_leaf()
+  {
+    while (!_pending.empty())
+      {
+        const BxoRopeNode*n = _pending.back();
+        if (!n->is_leaf())
+          {
+            expand_top();
+            continue;
+          }
+        _pending.pop_back();
+        if (n->_len == 0)
+          continue;
+        _ptr = n->_chunk.data();
+        _rem = n->_len;
+        return true;
+      }
+    return false;
+  };
+  friend class BxoRope;
+};        // end class BxoRopeCursor
+
+
+int
+BxoRope::compare(const BxoRope&r) const
+{
+  if (_root == r._root)
+    return 0;
+  BxoRopeCursor lcur(_root.get()), rcur(r._root.get());
+  for (;;)
+    {
+      if (lcur._rem == 0 && rcur._rem == 0)
+        {
+          // at the same offset in both ropes; skip the identical subtrees
+          for (;;)
+            {
+              const BxoRopeNode*ln = lcur.top();
+              const BxoRopeNode*rn = rcur.top();
+              if (!ln || !rn)
+                break;
+              if (ln == rn)
+                {
+                  lcur.pop();
+                  rcur.pop();
+                  continue;
+                }
+              if (ln->is_leaf() && rn->is_leaf())
+                break;
+              if (!ln->is_leaf() && (rn->is_leaf() || ln->_len >= rn->_len))
+                lcur.expand_top();
+              else
+                rcur.expand_top();
+            }
+        }
+      if (lcur._rem == 0 && !lcur.next_leaf())
+        return (rcur._rem > 0 || rcur.next_leaf()) ? -1 : 0;
+      if (rcur._rem == 0 && !rcur.next_leaf())
+        return 1;
+      size_t n = std::min(lcur._rem, rcur._rem);
+      int c = memcmp(lcur._ptr, rcur._ptr, n);
+      if (c != 0)
+        return c;
+      lcur._ptr += n;
+      lcur._rem -= n;
+      rcur._ptr += n;
+      rcur._rem -= n;
+    }
+} // end BxoRope::compare
+
+
+BxoJson
+BxoRope::rope_to_json(void) const
+{
+  return BxoJson(to_string());
+} // end BxoRope::rope_to_json
+
+
+void
+BxoRope::out(std::ostream&os) const
+{
+  constexpr size_t maxshown = 64;
+  size_t len = length();
+  size_t shown = std::min(len, maxshown);
+  while (shown < len && shown > 0 && (byte_at(shown) & 0xc0) == 0x80)
+    shown--;
+  std::string prefix = substring(0, shown);
+  std::string buf;
+  buf.reserve(shown+16);
+  buf.push_back('"');
+  bxo_utf8_escape(buf, prefix.data(), prefix.size());
+  buf.push_back('"');
+  os << "<rope " << len << " bytes " << buf;
+  if (shown < len)
+    os << "...";
+  os << ">";
+} // end BxoRope::out
+
+
+BxoVRope::BxoVRope(const std::string&str)
+  : BxoVal(TagRope {}, BxoRope::make_rope(str))
+{
+}
@@ -19,11 +19,94 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <QtSql>
-#include <QSqlDatabase>
-#include <QSqlQuery>
+#include "sqlite3.h"
 #include <QProcess>
 #include <QFileInfo>
+#include <thread>
+#include <condition_variable>
+
+/// a prepared sqlite3 statement, finalized when going out of scope;
+/// the bound strings are not copied, so must outlive the exec
+class BxoSqlStatement
+{
+  sqlite3* _sq_db;
+  sqlite3_stmt* _sq_stmt;
+  int _sq_laststep;
+public:
+  BxoSqlStatement(sqlite3*db, const char*sql)
+    : _sq_db(db), _sq_stmt(nullptr), _sq_laststep(SQLITE_OK)
+  {
+    if (sqlite3_prepare_v2(db, sql, -1, &_sq_stmt, nullptr) != SQLITE_OK)
+      {
+        sqlite3_finalize(_sq_stmt);
+        _sq_stmt = nullptr;
+      }
+  };
+  ~BxoSqlStatement()
+  {
+    sqlite3_finalize(_sq_stmt);
+    _sq_stmt = nullptr;
+  };
+  BxoSqlStatement(const BxoSqlStatement&) = delete;
+  BxoSqlStatement& operator = (const BxoSqlStatement&) = delete;
+  bool ok() const
+  {
+    return _sq_stmt != nullptr;
+  };
+  /// true when the last step failed, not just ended
+  bool failed() const
+  {
+    return _sq_laststep != SQLITE_ROW && _sq_laststep != SQLITE_DONE;
+  };
+  std::string error() const
+  {
+    return sqlite3_errmsg(_sq_db);
+  };
+  bool next()
+  {
+    _sq_laststep = sqlite3_step(_sq_stmt);
+    return _sq_laststep == SQLITE_ROW;
+  };
+  /// run a statement without result rows, then make it ready for the
+  /// next bindings
+  bool exec()
+  {
+    _sq_laststep = sqlite3_step(_sq_stmt);
+    sqlite3_reset(_sq_stmt);
+    sqlite3_clear_bindings(_sq_stmt);
+    return _sq_laststep == SQLITE_DONE;
+  };
+  /// the bytes of a text or blob column, valid till the next step
+  const char* bytes(int ix, size_t&len) const
+  {
+    const char* ptr = (const char*)sqlite3_column_blob(_sq_stmt, ix);
+    len = sqlite3_column_bytes(_sq_stmt, ix);
+    return ptr?ptr:"";
+  };
+  std::string text(int ix) const
+  {
+    size_t len = 0;
+    const char* ptr = bytes(ix, len);
+    return std::string(ptr, len);
+  };
+  double real(int ix) const
+  {
+    return sqlite3_column_double(_sq_stmt, ix);
+  };
+  // the bind indexes start at 0, like our column indexes
+  void bind_text(int ix, const std::string&str)
+  {
+    sqlite3_bind_text(_sq_stmt, ix+1, str.data(), str.size(), SQLITE_STATIC);
+  };
+  void bind_blob(int ix, const std::string&str)
+  {
+    sqlite3_bind_blob(_sq_stmt, ix+1, str.data(), str.size(), SQLITE_STATIC);
+  };
+  void bind_int64(int ix, int64_t i)
+  {
+    sqlite3_bind_int64(_sq_stmt, ix+1, i);
+  };
+};        // end class BxoSqlStatement
 
 BxoLoader::BxoLoader(const std::string dirnam)
   : _ld_dirname(dirnam), _ld_sqldb(nullptr),
@@ -33,18 +116,44 @@ BxoLoader::BxoLoader(const std::string dirnam)
 } // end of BxoLoader::BxoLoader
 
 
+BxoObject*
+BxoJsonProcessor::obj_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid)
+{
+  return obj_from_idstr(BxoObject::str_from_hid_loid(hid,loid));
+} // end BxoJsonProcessor::obj_from_hid_loid
+
 BxoObject*
 BxoLoader::obj_from_idstr(const std::string&s)
 {
-  auto p = _ld_idtoobjmap.find(s);
+  Bxo_hid_t hid=0;
+  Bxo_loid_t loid=0;
+  if (!BxoObject::str_to_hid_loid(s,&hid,&loid))
+    return nullptr;
+  return obj_from_hid_loid(hid,loid);
+}
+
+BxoObject*
+BxoLoader::obj_from_hid_loid(Bxo_hid_t hid, Bxo_loid_t loid)
+{
+  auto p = _ld_idtoobjmap.find(IdKey {hid,loid});
   if (p != _ld_idtoobjmap.end())
     return p->second.get();
-  return BxoObject::find_from_idstr(s);
-}
+  return BxoObject::find_from_hid_loid(hid,loid);
+} // end BxoLoader::obj_from_hid_loid
+
+std::shared_ptr<BxoObject>
+BxoLoader::find_loadedobj(const std::string& str)
+{
+  Bxo_hid_t hid=0;
+  Bxo_loid_t loid=0;
+  if (str.size() != BXO_CSTRIDLEN || !BxoObject::str_to_hid_loid(str,&hid,&loid))
+    return nullptr;
+  return find_loadedobj(hid,loid);
+} // end BxoLoader::find_loadedobj
 
 BxoLoader::~BxoLoader()
 {
-  delete _ld_sqldb;
+  sqlite3_close(_ld_sqldb);
   _ld_sqldb = nullptr;
 }
 
@@ -119,35 +228,29 @@ BxoTuple::load_tuple(BxoJsonProcessor&bxj, const BxoJson&js)
 void
 BxoLoader::load()
 {
-  if (!QSqlDatabase::drivers().contains("QSQLITE"))
+  std::string sqlitepath = _ld_dirname+"/"+basixmo_statebase+".sqlite";
+  std::string sqlpath = _ld_dirname+"/"+basixmo_statebase+".sql";
+  if (!QFileInfo::exists(sqlitepath.c_str()) || !QFileInfo::exists(sqlpath.c_str()))
     {
-      BXO_BACKTRACELOG("load: missing QSQLITE driver");
-      throw std::runtime_error("BxoLoader::load missing QSQLITE");
-    }
-  _ld_sqldb = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE","bxoloader"));
-  QString sqlitepath((_ld_dirname+"/"+basixmo_statebase+".sqlite").c_str());
-  QString sqlpath((_ld_dirname+"/"+basixmo_statebase+".sql").c_str());
-  if (!QFileInfo::exists(sqlitepath) || !QFileInfo::exists(sqlpath))
-    {
-      BXO_BACKTRACELOG("load: missing " << sqlitepath.toStdString()
-                       << " or " << sqlpath.toStdString());
+      BXO_BACKTRACELOG("load: missing " << sqlitepath
+                       << " or " << sqlpath);
       throw std::runtime_error("BxoLoader::load missing file");
     }
-  if (QFileInfo(sqlitepath).lastModified() > QFileInfo(sqlpath).lastModified())
+  if (QFileInfo(sqlitepath.c_str()).lastModified() > QFileInfo(sqlpath.c_str()).lastModified())
     {
-      BXO_BACKTRACELOG("load: " << sqlitepath.toStdString()
-                       << " younger than " << sqlpath.toStdString());
+      BXO_BACKTRACELOG("load: " << sqlitepath
+                       << " younger than " << sqlpath);
       throw std::runtime_error("BxoLoader::load .sqlite youger");
     }
-  _ld_sqldb->setDatabaseName(sqlitepath);
-  if (!_ld_sqldb->open())
+  if (sqlite3_open_v2(sqlitepath.c_str(), &_ld_sqldb, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
     {
-      BXO_BACKTRACELOG("load " << sqlitepath.toStdString()
-                       << " failed to open: " << _ld_sqldb->lastError().text().toStdString());
+      BXO_BACKTRACELOG("load " << sqlitepath
+                       << " failed to open: " << (_ld_sqldb?sqlite3_errmsg(_ld_sqldb):"no memory"));
       throw std::runtime_error("BxoLoader::load open failure");
     }
+  load_params();
   bind_predefined();
-  create_objects();
+  read_objects();
   set_globals ();
   name_objects ();
   name_predefined ();
@@ -156,12 +259,11 @@ BxoLoader::load()
   load_objects_class ();
   load_objects_create_payload ();
   load_objects_fill_payload ();
-  _ld_sqldb->close();
   int nbobj = _ld_idtoobjmap.size();
   _ld_idtoobjmap.clear();
-  delete _ld_sqldb;
+  _ld_batches.clear();
+  sqlite3_close(_ld_sqldb);
   _ld_sqldb = nullptr;
-  QSqlDatabase::removeDatabase("bxoloader");
   double elaptim = bxo_elapsed_real_time() - _ld_startelapsedtime;
   double cputim = bxo_process_cpu_time () - _ld_startprocesstime;
   printf("\n"
@@ -170,31 +272,114 @@ BxoLoader::load()
   fflush(nullptr);
 } // end of BxoLoader::load
 
+void
+BxoLoader::load_params(void)
+{
+  BxoSqlStatement query(_ld_sqldb, "SELECT par_name, par_value FROM t_params");
+  enum { ResixName, ResixValue, Resix_LAST };
+  // a state without any string_hash_version was dumped with the legacy
+  // hash; it is loaded with it, and its next dump records the latest one
+  unsigned strhashversion = BXO_STRING_HASH_VERSION_LEGACY;
+  if (!query.ok())
+    {
+      BXO_BACKTRACELOG("load_params Sql query failure: " <<  query.error());
+      throw std::runtime_error("BxoLoader::load_params query failure");
+    }
+  while (query.next())
+    {
+      std::string namstr = query.text(ResixName);
+      std::string valstr = query.text(ResixValue);
+      BXO_VERBOSELOG("load_params " << namstr << "=" << valstr);
+      if (namstr == "string_hash_version")
+        strhashversion = atoi(valstr.c_str());
+    }
+  if (query.failed())
+    {
+      BXO_BACKTRACELOG("load_params Sql step failure: " <<  query.error());
+      throw std::runtime_error("BxoLoader::load_params query failure");
+    }
+  if (!BxoString::hash_version_forced())
+    BxoString::set_hash_version(strhashversion);
+} // end BxoLoader::load_params
+
 void
 BxoLoader::bind_predefined(void)
 {
 #define BXO_HAS_PREDEFINED(Name,Idstr,Hid,Loid,Hash)            \
-    _ld_idtoobjmap.insert({BXO_VARPREDEF(Name)->strid(),        \
+    _ld_idtoobjmap.insert({IdKey {Hid,Loid},                    \
                            BXO_VARPREDEF(Name)});
 #include "_bxo_predef.h"
 } // end BxoLoader::bind_predefined
 
+unsigned BxoLoader::_loadjobs_ = 1;
+
+size_t
+BxoLoader::stage_bytes(StagedBatch&sb, const char*ptr, size_t len, uint32_t&rlen)
+{
+  if (BXO_UNLIKELY(len >= UINT32_MAX))
+    {
+      BXO_BACKTRACELOG("stage_bytes too long column " << len);
+      throw std::runtime_error("BxoLoader::stage_bytes too long column");
+    }
+  size_t off = sb.sb_bytes.size();
+  sb.sb_bytes.append(ptr, len);
+  rlen = (uint32_t)len;
+  return off;
+} // end BxoLoader::stage_bytes
+
+/// read all of t_objects in one pass, creating every object and
+/// staging its columns for the later fill, class and payload phases
 void
-BxoLoader::create_objects(void)
+BxoLoader::read_objects(void)
 {
-  QSqlQuery query(*_ld_sqldb);
-  enum { ResixId, Resix_LAST };
-  if (!query.exec("SELECT ob_id FROM t_objects"))
+  BxoSqlStatement query(_ld_sqldb,
+                        "SELECT ob_id, ob_mtime, ob_jsoncont, ob_classid, ob_paylkid, ob_paylcont FROM t_objects");
+  enum { ResixId, ResixMtime, ResixJsoncont, ResixClassid, ResixPaylkid, ResixPaylcont, Resix_LAST };
+  if (!query.ok())
     {
-      BXO_BACKTRACELOG("create_objects Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoLoader::create_objects query failure");
+      BXO_BACKTRACELOG("read_objects Sql query failure: " <<  query.error());
+      throw std::runtime_error("BxoLoader::read_objects query failure");
     }
+  StagedBatch* cursb = nullptr;
   while (query.next())
     {
-      std::string idstr = query.value(ResixId).toString().toStdString();
-      (void) BxoObject::load_objref(*this,idstr);
+      if (!cursb || cursb->sb_rows.size() >= _batch_rows_)
+        {
+          _ld_batches.emplace_back(new StagedBatch());
+          cursb = _ld_batches.back().get();
+          cursb->sb_rows.reserve(_batch_rows_);
+        }
+      StagedRow row;
+      memset(&row, 0, sizeof(row));
+      const char* colptr = nullptr;
+      size_t collen = 0;
+      colptr = query.bytes(ResixId, collen);
+      Bxo_hid_t hid=0;
+      Bxo_loid_t loid=0;
+      if (collen != BXO_CSTRIDLEN || !BxoObject::cstr_to_hid_loid(colptr,&hid,&loid))
+        {
+          BXO_BACKTRACELOG("read_objects bad id:" << std::string(colptr, collen));
+          throw std::runtime_error("BxoLoader::read_objects bad id");
+        }
+      row.sr_obj = BxoObject::load_objref(*this,hid,loid).get();
+      row.sr_mtime = query.real(ResixMtime);
+      colptr = query.bytes(ResixJsoncont, collen);
+      row.sr_jsoncont = stage_bytes(*cursb, colptr, collen, row.sr_jsoncontlen);
+      colptr = query.bytes(ResixClassid, collen);
+      row.sr_classid = stage_bytes(*cursb, colptr, collen, row.sr_classidlen);
+      colptr = query.bytes(ResixPaylkid, collen);
+      row.sr_paylkid = stage_bytes(*cursb, colptr, collen, row.sr_paylkidlen);
+      colptr = query.bytes(ResixPaylcont, collen);
+      row.sr_paylcont = stage_bytes(*cursb, colptr, collen, row.sr_paylcontlen);
+      cursb->sb_rows.push_back(row);
+    }
+  if (query.failed())
+    {
+      BXO_BACKTRACELOG("read_objects Sql step failure: " <<  query.error());
+      throw std::runtime_error("BxoLoader::read_objects query failure");
     }
-} // end BxoLoader::create_objects
+  BXO_VERBOSELOG("read_objects staged " << _ld_batches.size() << " batches");
+} // end BxoLoader::read_objects
 
 
 void
@@ -213,17 +398,17 @@ BxoLoader::set_globals(void)
 void
 BxoLoader::name_objects(void)
 {
-  QSqlQuery query(*_ld_sqldb);
+  BxoSqlStatement query(_ld_sqldb, "SELECT nam_oid, nam_str FROM t_names");
   enum { ResixId, ResixName, Resix_LAST };
-  if (!query.exec("SELECT nam_oid, nam_str FROM t_names"))
+  if (!query.ok())
     {
-      BXO_BACKTRACELOG("name_objects Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
+      BXO_BACKTRACELOG("name_objects Sql query failure: " <<  query.error());
       throw std::runtime_error("BxoLoader::name_objects query failure");
     }
   while (query.next())
     {
-      std::string idstr = query.value(ResixId).toString().toStdString();
-      std::string namstr = query.value(ResixName).toString().toStdString();
+      std::string idstr = query.text(ResixId);
+      std::string namstr = query.text(ResixName);
       auto pob = find_loadedobj(idstr);
       if (!pob)
         {
@@ -237,52 +422,30 @@ BxoLoader::name_objects(void)
           throw std::runtime_error("BxoLoader::name_objects cant register named");
         }
     }
-} // end of BxoLoader::name_objects
-
-std::shared_ptr<BxoObject>
-BxoLoader::name_the_predefined(const std::string&nam, const std::string&idstr)
-{
-  auto pob = find_loadedobj(idstr);
-  if (!pob)
+  if (query.failed())
     {
-      BXO_BACKTRACELOG("name_the_predefined dont find idstr=" << idstr);
-      throw  std::runtime_error("BxoLoader::name_the_predefined missing");
-    }
-  if (pob->name() == nam) // already named
-    return pob;
-  if (!pob->register_named(nam))
-    {
-      BXO_BACKTRACELOG("name_the_predefined for idstr=" << idstr
-                       << " failed to name " << nam);
-      throw  std::runtime_error("BxoLoader::name_the_predefined failed naming");
+      BXO_BACKTRACELOG("name_objects Sql step failure: " <<  query.error());
+      throw std::runtime_error("BxoLoader::name_objects query failure");
     }
-  return pob;
-}
+} // end of BxoLoader::name_objects
 
 void
 BxoLoader::name_predefined(void)
 {
-#define BXO_HAS_PREDEFINED(Nam,Idstr,Hid,Loid,Hash)  do {       \
-    auto pob = name_the_predefined(#Nam,#Idstr);                \
-    BXO_ASSERT (pob, "no pob for idstr=" << #Idstr);            \
-    BXO_ASSERT (pob->hash() == Hash, "bad hash");               \
-    BXO_ASSERT (pob->strid() == #Idstr, "bad idstr");           \
-    BXO_ASSERT (pob->hid() == Hid, "bad hid");                  \
-    BXO_ASSERT (pob->loid() == Loid, "bad hid");                \
-  } while(0);
-#include "_bxo_predef.h"
-  fflush(nullptr);
+  int badix = BxoObject::register_predefined_names();
+  if (badix >= 0)
+    {
+      BXO_BACKTRACELOG("name_predefined failed to name " << bxo_predef_namekeys[badix].pk_str
+                       << " the predefined " << bxo_predef_idkeys[badix].pk_str);
+      throw  std::runtime_error("BxoLoader::name_predefined failed naming");
+    }
 } // end of BxoLoader::name_predefined
 
 void
-BxoLoader::register_objref(const std::string&idstr,std::shared_ptr<BxoObject> obp)
+BxoLoader::register_objref(std::shared_ptr<BxoObject> obp)
 {
-  Bxo_hid_t hid=0;
-  Bxo_loid_t loid=0;
-  BXO_ASSERT(BxoObject::str_to_hid_loid(idstr,&hid,&loid),
-             "register_objref bad idstr:" << idstr);
   BXO_ASSERT(obp, "register_objref empty obp");
-  _ld_idtoobjmap[idstr] = obp;
+  _ld_idtoobjmap[IdKey {obp->hid(),obp->loid()}] = obp;
 } // end BxoLoader::register_objref
 
 
@@ -292,16 +455,16 @@ BxoLoader::link_modules(void)
   typedef std::pair<std::shared_ptr<BxoObject>,void*> Pobjdlh_t;
   std::vector<Pobjdlh_t> vecmod;
   {
-    QSqlQuery query(*_ld_sqldb);
+    BxoSqlStatement query(_ld_sqldb, "SELECT mod_oid FROM t_modules");
     enum { ResixId, Resix_LAST };
-    if (!query.exec("SELECT mod_oid FROM t_modules"))
+    if (!query.ok())
       {
-        BXO_BACKTRACELOG("link_modules Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
+        BXO_BACKTRACELOG("link_modules Sql query failure: " <<  query.error());
         throw std::runtime_error("BxoLoader::link_modules query failure");
       }
     while (query.next())
       {
-        std::string idstr = query.value(ResixId).toString().toStdString();
+        std::string idstr = query.text(ResixId);
         auto pob = find_loadedobj(idstr);
         if (!pob)
           {
@@ -330,6 +493,11 @@ BxoLoader::link_modules(void)
         }
         vecmod.push_back(Pobjdlh_t {pob,nullptr});
       }
+    if (query.failed())
+      {
+        BXO_BACKTRACELOG("link_modules Sql step failure: " <<  query.error());
+        throw std::runtime_error("BxoLoader::link_modules query failure");
+      }
   }
   for (Pobjdlh_t po : vecmod)
     {
@@ -348,40 +516,114 @@ BxoLoader::link_modules(void)
 } // end of BxoLoader::link_modules
 
 
-void
-BxoLoader::fill_objects_contents(void)
+bool
+BxoLoader::read_attribute(BxoJsonReader&jr, std::shared_ptr<BxoObject>&pobat, BxoVal&val)
 {
-  QSqlQuery query(*_ld_sqldb);
-  enum { ResixId, ResixMtime, ResixJsoncont, Resix_LAST };
-  if (!query.exec("SELECT ob_id, ob_mtime, ob_jsoncont FROM t_objects"))
+  const char* mk = jr.mark();
+  if (jr.peek() == '{')
     {
-      BXO_BACKTRACELOG("fill_objects_contents Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoLoader::fill_objects_contents query failure");
+      jr.begin_object();
+      Bxo_hid_t hid=0;
+      Bxo_loid_t loid=0;
+      if (jr.next_key() && jr.key_is("at") && jr.peek() == '"')
+        {
+          bool isid = jr.get_id(hid,loid);
+          if (jr.next_key() && jr.key_is("va"))
+            {
+              pobat = isid ? find_loadedobj(hid,loid) : nullptr;
+              if (pobat)
+                val = BxoVal::read_json(jr);
+              else
+                jr.skip_value();
+              if (!jr.next_key())
+                return pobat != nullptr;
+            }
+        }
+      jr.reset(mk);
     }
-  while (query.next())
+  // other shapes are taken as load_content does
+  const BxoJson jpair = jr.get_json();
+  pobat = nullptr;
+  if (!jpair.isObject()) return false;
+  const BxoJson& jat = jpair["at"];
+  if (!jat.isString()) return false;
+  pobat = find_loadedobj(jat.asString());
+  if (!pobat) return false;
+  val = BxoVal::from_json(*this,jpair["va"]);
+  return true;
+} // end BxoLoader::read_attribute
+
+
+/// fill the contents of the objects of a batch, from their JSON text
+/// or their binary encoding; it only changes the objects of its batch
+void
+BxoLoader::fill_batch_contents(StagedBatch&sb)
+{
+  for (const StagedRow& row : sb.sb_rows)
     {
-      std::string idstr = query.value(ResixId).toString().toStdString();
-      double mtimdb = query.value(ResixMtime).toDouble();
-      auto pob = find_loadedobj(idstr);
-      if (!pob)
+      BxoObject* pob = row.sr_obj;
+      // the content is JSON text or a binary blob, told by its first byte
+      const char* contptr = sb.staged_ptr(row.sr_jsoncont);
+      pob->touch_load((time_t)row.sr_mtime,*this);
+      try
         {
-          BXO_BACKTRACELOG("fill_objects_contents cant find " << idstr);
-          throw std::runtime_error("BxoLoader::fill_objects_contents missing object");
+          if (BxoBinaryDecoder::is_binary(contptr, row.sr_jsoncontlen))
+            {
+              BxoBinaryDecoder dec(*this, contptr, row.sr_jsoncontlen);
+              pob->load_content_binary(dec,*this);
+            }
+          else
+            {
+              BxoJsonReader jr(*this, contptr, row.sr_jsoncontlen);
+              pob->read_content(jr,*this);
+              if (!jr.at_end())
+                jr.fail("trailing bytes after object content");
+            }
         }
-      std::string jsonstr = query.value(ResixJsoncont).toString().toStdString();
-      Json::Reader jrd(Json::Features::strictMode());
-      BxoJson jv;
-      if (!jrd.parse(jsonstr,jv,false))
+      catch (...)
         {
-          BXO_BACKTRACELOG("fill_objects_contents parse failure for " << idstr
-                           << ": " << jrd.getFormattedErrorMessages()
-                           << std::endl << "jsonstr=" << jsonstr
-                           << std::endl);
-          throw std::runtime_error("BxoLoader::fill_objects_contents Json parse failure");
+          BXO_BACKTRACELOG("fill_batch_contents failed for " << pob->strid()
+                           << " jsonstr=" << sb.staged_string(row.sr_jsoncont, row.sr_jsoncontlen));
+          throw;
         }
-      pob->touch_load((time_t)mtimdb,*this);
-      pob->load_content(jv,*this);
     }
+} // end of BxoLoader::fill_batch_contents
+
+/// every object exists now, so with several load jobs the batches
+/// are filled by as many threads, the caller being the first one
+void
+BxoLoader::fill_objects_contents(void)
+{
+  std::atomic<size_t> nextbatch {0};
+  std::atomic<bool> failing {false};
+  std::mutex failmtx;
+  std::exception_ptr failure;
+  auto run_worker = [&]()
+  {
+    try
+      {
+        size_t bix = 0;
+        while (!failing.load() && (bix = nextbatch++) < _ld_batches.size())
+          fill_batch_contents(*_ld_batches[bix]);
+      }
+    catch (...)
+      {
+        failing.store(true);
+        std::lock_guard<std::mutex> gu(failmtx);
+        if (!failure)
+          failure = std::current_exception();
+      }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned ix=1; ix<_loadjobs_ && ix<_ld_batches.size(); ix++)
+    threads.emplace_back(run_worker);
+  run_worker();
+  for (auto& th : threads)
+    th.join();
+  if (failure)
+    std::rethrow_exception(failure);
+  BXO_VERBOSELOG("fill_objects_contents filled " << _ld_batches.size() << " batches with "
+                 << _loadjobs_ << " load jobs");
 } // end of BxoLoader::fill_objects_contents
 
 
@@ -389,32 +631,21 @@ BxoLoader::fill_objects_contents(void)
 void
 BxoLoader::load_objects_class(void)
 {
-  QSqlQuery query(*_ld_sqldb);
-  constexpr const char*sqlsel = "SELECT ob_id, ob_classid FROM t_objects WHERE ob_classid IS NOT \"\" ";
-  enum { ResixId, ResixClassid, Resix_LAST };
-  if (!query.exec(sqlsel))
-    {
-      BXO_BACKTRACELOG("load_objects_class Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoLoader::load_objects_class query failure");
-    }
-  while (query.next())
-    {
-      std::string idstr = query.value(ResixId).toString().toStdString();
-      std::string classidstr = query.value(ResixClassid).toString().toStdString();
-      auto pob = find_loadedobj(idstr);
-      if (!pob)
-        {
-          BXO_BACKTRACELOG("load_objects_class cant find object " << idstr);
-          throw std::runtime_error("BxoLoader::load_objects_class missing object");
-        }
-      auto pclassob = find_loadedobj(classidstr);
-      if (!pclassob)
-        {
-          BXO_BACKTRACELOG("load_objects_class cant find class " << classidstr << " for object " << idstr);
-          throw std::runtime_error("BxoLoader::load_objects_class missing class");
-        }
-      pob->load_set_class(pclassob,*this);
-    }
+  for (auto& sbp : _ld_batches)
+    for (const StagedRow& row : sbp->sb_rows)
+      {
+        if (row.sr_classidlen == 0)
+          continue;
+        BxoObject* pob = row.sr_obj;
+        std::string classidstr = sbp->staged_string(row.sr_classid, row.sr_classidlen);
+        auto pclassob = find_loaded_predefobj(classidstr);
+        if (!pclassob)
+          {
+            BXO_BACKTRACELOG("load_objects_class cant find class " << classidstr << " for object " << pob->strid());
+            throw std::runtime_error("BxoLoader::load_objects_class missing class");
+          }
+        pob->load_set_class(pclassob,*this);
+      }
 } // end of BxoLoader::load_objects_class
 
 
@@ -422,42 +653,31 @@ BxoLoader::load_objects_class(void)
 void
 BxoLoader::load_objects_create_payload(void)
 {
-  QSqlQuery query(*_ld_sqldb);
-  constexpr const char*sqlsel = "SELECT ob_id, ob_paylkid FROM t_objects WHERE ob_paylkid IS NOT \"\" ";
-  enum { ResixId, ResixPaylkId, Resix_LAST };
-  if (!query.exec(sqlsel))
-    {
-      BXO_BACKTRACELOG("load_objects_create_payload Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoLoader::load_objects_create_payload query failure");
-    }
-  while (query.next())
-    {
-      std::string idstr = query.value(ResixId).toString().toStdString();
-      std::string pykidstr = query.value(ResixPaylkId).toString().toStdString();
-      auto pob = find_loadedobj(idstr);
-      if (!pob)
-        {
-          BXO_BACKTRACELOG("load_objects_create_payload cant find object " << idstr);
-          throw std::runtime_error("BxoLoader::load_objects_create_payload missing object");
-        }
-      auto pykindob = find_loadedobj(pykidstr);
-      if (!pykindob)
-        {
-          BXO_BACKTRACELOG("load_objects_create_payload cant find payload kind " << pykidstr << " for object " << idstr);
-          throw std::runtime_error("BxoLoader::load_objects_create_payload missing payload kind");
-        }
-      std::string loadername = std::string {BxoPayload::loader_prefix} + pykidstr;
-      void* ldfunad = dlsym(bxo_dlh, loadername.c_str());
-      if (ldfunad == nullptr)
-        {
-          BXO_BACKTRACELOG("load_objects_create_payload for object " << pob << " of payload kind " << pykindob
-                           << " failed to dlsym " << loadername << " : " << dlerror());
-          throw std::runtime_error("BxoLoader::load_objects_create_payload missing loader fun");
-        }
-      auto ldfun = reinterpret_cast<BxoPayload::loader_create_sigt*>(ldfunad);
-      BxoPayload* payl= (*ldfun)(pob.get(),this);
-      pob->load_set_payload(payl,*this);
-    }
+  for (auto& sbp : _ld_batches)
+    for (const StagedRow& row : sbp->sb_rows)
+      {
+        if (row.sr_paylkidlen == 0)
+          continue;
+        BxoObject* pob = row.sr_obj;
+        std::string pykidstr = sbp->staged_string(row.sr_paylkid, row.sr_paylkidlen);
+        auto pykindob = find_loaded_predefobj(pykidstr);
+        if (!pykindob)
+          {
+            BXO_BACKTRACELOG("load_objects_create_payload cant find payload kind " << pykidstr << " for object " << pob->strid());
+            throw std::runtime_error("BxoLoader::load_objects_create_payload missing payload kind");
+          }
+        std::string loadername = std::string {BxoPayload::loader_prefix} + pykidstr;
+        void* ldfunad = dlsym(bxo_dlh, loadername.c_str());
+        if (ldfunad == nullptr)
+          {
+            BXO_BACKTRACELOG("load_objects_create_payload for object " << pob << " of payload kind " << pykindob
+                             << " failed to dlsym " << loadername << " : " << dlerror());
+            throw std::runtime_error("BxoLoader::load_objects_create_payload missing loader fun");
+          }
+        auto ldfun = reinterpret_cast<BxoPayload::loader_create_sigt*>(ldfunad);
+        BxoPayload* payl= (*ldfun)(pob,this);
+        pob->load_set_payload(payl,*this);
+      }
 } // end of BxoLoader::load_objects_create_payload
 
 
@@ -465,40 +685,49 @@ BxoLoader::load_objects_create_payload(void)
 void
 BxoLoader::load_objects_fill_payload(void)
 {
-  QSqlQuery query(*_ld_sqldb);
-  constexpr const char*sqlsel = "SELECT ob_id, ob_paylcont FROM t_objects WHERE ob_paylcont IS NOT \"\" ";
-  enum { ResixId, ResixPaylcont, Resix_LAST };
-  if (!query.exec(sqlsel))
-    {
-      BXO_BACKTRACELOG("load_objects_fill_payload Sql query failure: " <<  _ld_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoLoader::load_objects_fill_payload query failure");
-    }
-  while (query.next())
+  for (auto& sbp : _ld_batches)
     {
-      std::string idstr = query.value(ResixId).toString().toStdString();
-      auto pob = find_loadedobj(idstr);
-      if (!pob)
-        {
-          BXO_BACKTRACELOG("load_objects_fill_payload cant find object " << idstr);
-          throw std::runtime_error("BxoLoader::load_objects_fill_payload missing object");
-        }
-      if (!pob->payload())
+      StagedBatch& sb = *sbp;
+      for (size_t ix=0; ix<sb.sb_rows.size(); ix++)
         {
-          BXO_BACKTRACELOG("load_objects_fill_payload object " << pob << " without payload");;
-          throw std::runtime_error("BxoLoader::load_objects_fill_payload object without payload");
-        }
-      std::string jsonstr = query.value(ResixPaylcont).toString().toStdString();
-      Json::Reader jrd(Json::Features::strictMode());
-      BxoJson jv;
-      if (!jrd.parse(jsonstr,jv,false))
-        {
-          BXO_BACKTRACELOG("load_objects_fill_payload Json parse failure for " << idstr
-                           << ": " << jrd.getFormattedErrorMessages()
-                           << std::endl << "jsonstr=" << jsonstr
-                           << std::endl);
-          throw std::runtime_error("BxoLoader::load_objects_fill_payload Json parse failure");
+          const StagedRow& row = sb.sb_rows[ix];
+          if (row.sr_paylcontlen == 0)
+            continue;
+          BxoObject* pob = row.sr_obj;
+          if (!pob->payload())
+            {
+              BXO_BACKTRACELOG("load_objects_fill_payload object " << pob << " without payload");;
+              throw std::runtime_error("BxoLoader::load_objects_fill_payload object without payload");
+            }
+          const char* contptr = sb.staged_ptr(row.sr_paylcont);
+          BxoJson jv;
+          if (BxoBinaryDecoder::is_binary(contptr, row.sr_paylcontlen))
+            {
+              BxoBinaryDecoder dec(*this, contptr, row.sr_paylcontlen);
+              jv = dec.get_json();
+            }
+          else
+            {
+              // a payload reading its content itself is done with it
+              BxoJsonReader jr(*this, contptr, row.sr_paylcontlen);
+              if (pob->payload()->read_payload_content(jr,*this))
+                {
+                  if (!jr.at_end())
+                    jr.fail("trailing bytes after payload content");
+                  continue;
+                }
+              Json::Reader jrd(Json::Features::strictMode());
+              if (!jrd.parse(contptr, contptr + row.sr_paylcontlen, jv, false))
+                {
+                  BXO_BACKTRACELOG("load_objects_fill_payload Json parse failure for " << pob->strid()
+                                   << ": " << jrd.getFormattedErrorMessages()
+                                   << std::endl << "jsonstr=" << sb.staged_string(row.sr_paylcont, row.sr_paylcontlen)
+                                   << std::endl);
+                  throw std::runtime_error("BxoLoader::load_objects_fill_payload Json parse failure");
+                }
+            }
+          pob->payload()->load_payload_content(jv,*this);
         }
-      pob->payload()->load_payload_content(jv,*this);
     }
 } // end of BxoLoader::load_objects_fill_payload
 
@@ -506,6 +735,29 @@ BxoLoader::load_objects_fill_payload(void)
 
 
 std::string BxoDumper::_defaultdumpdir_;
+bool BxoDumper::_binarycontent_;
+unsigned BxoDumper::_commitrows_ = 65536;
+unsigned BxoDumper::_dumpjobs_ = 1;
+bool BxoDumper::_compactjson_ = false;
+thread_local BxoDumper::ScanWorker* BxoDumper::_curscanworker_;
+std::atomic<uint32_t> BxoDumper::_lastdumpepoch_;
+
+/// the dump always builds a fresh temporary database, renamed only
+/// once complete, so it needs no rollback journal nor syncing; these
+/// fixed settings are recorded in t_params, but not the run-time
+/// commit_rows, so that a state always dumps to the same content
+static const struct
+{
+  const char* dp_name;
+  const char* dp_value;
+} bxo_dump_pragmas[] =
+{
+  {"page_size", "8192"},
+  {"journal_mode", "OFF"},
+  {"synchronous", "OFF"},
+  {"cache_size", "-65536"},
+  {"temp_store", "MEMORY"},
+};
 
 std::string
 BxoDumper::generate_temporary_suffix(void)
@@ -528,8 +780,12 @@ BxoDumper::BxoDumper(const std::string&dirn)
     _du_startprocesstime(bxo_process_cpu_time ()),
     _du_dirname(dirn),
     _du_tempsuffix(generate_temporary_suffix()),
-    _du_objset(),
-    _du_scanque()
+    _du_epoch(0),
+    _du_objvec(),
+    _du_scanworkers(),
+    _du_scanpending(0),
+    _du_scanidle(0),
+    _du_scanpushes(0)
 {
 } // end of BxoDumper::BxoDumper
 
@@ -537,11 +793,11 @@ BxoDumper::~BxoDumper()
 {
   delete _du_queryinsobj;
   _du_queryinsobj = nullptr;
-  delete _du_sqldb;
+  sqlite3_close(_du_sqldb);
   _du_sqldb = nullptr;
   _du_state = DuStop;
-  _du_objset.clear();
-  _du_scanque.clear();
+  _du_objvec.clear();
+  _du_scanworkers.clear();
 } // end of BxoDumper::~BxoDumper
 
 
@@ -550,36 +806,208 @@ BxoDumper::scan_dumpable(BxoObject*pob)
 {
   BXO_ASSERT(_du_state == DuScan, "non-scan state #" << (int)_du_state);
   if (!pob) return false;
-  if (is_dumpable(pob)) return true;
   if (pob->space() == BxoSpace::TransientSp) return false;
-  _du_objset.insert(pob);
-  _du_scanque.push_back(pob->shared_from_this());
+  if (pob->_dumpepoch.load(std::memory_order_relaxed) == _du_epoch
+      || pob->_dumpepoch.exchange(_du_epoch) == _du_epoch)
+    return true;
+  ScanWorker* sw = _curscanworker_;
+  BXO_ASSERT(sw != nullptr, "scan_dumpable outside of a scanning thread");
+  sw->sw_marked.push_back(pob);
+  _du_scanpending++;
+  {
+    std::lock_guard<std::mutex> gu(sw->sw_mtx);
+    sw->sw_deque.push_back(pob);
+  }
+  scan_wake_idle();
   return true;
 } // end BxoDumper::scan_dumpable
 
+
+/// some objects were pushed in a deque, so wake a parked worker to
+/// steal them; the idle count is read after the push count is bumped,
+/// so a worker going idle sees either
+void
+BxoDumper::scan_wake_idle(void)
+{
+  _du_scanpushes++;
+  if (_du_scanidle.load() > 0)
+    {
+      std::lock_guard<std::mutex> gu(_du_scanidlemtx);
+      _du_scanidlecond.notify_one();
+    }
+} // end BxoDumper::scan_wake_idle
+
+
+/// an object is scanned, or dropped by a failing worker; the last one
+/// releases the parked workers
+void
+BxoDumper::scan_done_one(void)
+{
+  if (--_du_scanpending == 0)
+    {
+      std::lock_guard<std::mutex> gu(_du_scanidlemtx);
+      _du_scanidlecond.notify_all();
+    }
+} // end BxoDumper::scan_done_one
+
+
+/// steal half of the pending objects of the first other worker having
+/// some; return one of them, or nullptr
+BxoObject*
+BxoDumper::steal_scan(ScanWorker*sw)
+{
+  unsigned nbworkers = _du_scanworkers.size();
+  unsigned swix = sw->sw_index;
+  for (unsigned off = 1; off < nbworkers; off++)
+    {
+      ScanWorker* victim = _du_scanworkers[(swix+off) % nbworkers].get();
+      std::vector<BxoObject*> stolenvec;
+      {
+        std::lock_guard<std::mutex> gu(victim->sw_mtx);
+        size_t nbstolen = (victim->sw_deque.size()+1)/2;
+        if (nbstolen == 0)
+          continue;
+        stolenvec.assign(victim->sw_deque.begin(), victim->sw_deque.begin()+nbstolen);
+        victim->sw_deque.erase(victim->sw_deque.begin(), victim->sw_deque.begin()+nbstolen);
+      }
+      BxoObject* pob = stolenvec.back();
+      stolenvec.pop_back();
+      if (!stolenvec.empty())
+        {
+          {
+            std::lock_guard<std::mutex> gu(sw->sw_mtx);
+            sw->sw_deque.insert(sw->sw_deque.end(), stolenvec.begin(), stolenvec.end());
+          }
+          scan_wake_idle();
+        }
+      return pob;
+    }
+  return nullptr;
+} // end BxoDumper::steal_scan
+
+
+/// scan objects until none is left pending in any worker; with nothing
+/// to take nor steal, park until some object is pushed
+void
+BxoDumper::scan_worker_loop(ScanWorker*sw)
+{
+  _curscanworker_ = sw;
+  for (;;)
+    {
+      unsigned long nbpushes = _du_scanpushes.load();
+      BxoObject* pob = nullptr;
+      {
+        std::lock_guard<std::mutex> gu(sw->sw_mtx);
+        if (!sw->sw_deque.empty())
+          {
+            pob = sw->sw_deque.back();
+            sw->sw_deque.pop_back();
+          }
+      }
+      if (!pob)
+        pob = steal_scan(sw);
+      if (!pob)
+        {
+          if (_du_scanpending.load() == 0)
+            break;
+          std::unique_lock<std::mutex> lk(_du_scanidlemtx);
+          _du_scanidle++;
+          _du_scanidlecond.wait(lk, [&]()
+          {
+            return _du_scanpushes.load() != nbpushes || _du_scanpending.load() == 0;
+          });
+          _du_scanidle--;
+          continue;
+        }
+      sw->sw_nbscan++;
+      BXO_VERBOSELOG("nbscan#" << sw->sw_nbscan << " pob=" << pob << ":" << pob->strid());
+      pob->scan_content_dump(*this);
+      scan_done_one();
+    }
+  _curscanworker_ = nullptr;
+} // end BxoDumper::scan_worker_loop
+
+
+/// the reachable objects are marked in parallel by the dump jobs; the
+/// calling thread is the first worker and scans the predefined objects
 void
 BxoDumper::scan_all(void)
 {
   BXO_ASSERT(_du_state == DuStop, "non stop state for scan");
-  _du_objset.clear();
+  double startime = bxo_elapsed_real_time();
+  _du_objvec.clear();
+  // a fresh epoch, never 0, so the stamps of previous dumps are stale
+  do
+    _du_epoch = ++_lastdumpepoch_;
+  while (_du_epoch == 0);
   _du_state = DuScan;
+  _du_scanworkers.clear();
+  for (unsigned ix=0; ix<_dumpjobs_; ix++)
+    {
+      _du_scanworkers.emplace_back(new ScanWorker());
+      _du_scanworkers.back()->sw_index = ix;
+      _du_scanworkers.back()->sw_nbscan = 0;
+    }
+  _du_scanpending.store(0);
+  _du_scanidle.store(0);
+  _du_scanpushes.store(0);
+  ScanWorker* mainsw = _du_scanworkers[0].get();
+  _curscanworker_ = mainsw;
   BxoVal proset = BxoObject::set_of_predefined_objects();
   BXO_BACKTRACELOG("scan_all proset=" << proset);
   proset.scan_dump(*this);
-  int nbscan = 0;
-  while (!_du_scanque.empty())
+  // a failing scanning thread stops, leaving its deque to the other
+  // ones; the first failure is rethrown after the join
+  std::mutex failmtx;
+  std::exception_ptr failure;
+  auto run_worker = [&](ScanWorker*sw)
+  {
+    try
+      {
+        scan_worker_loop(sw);
+      }
+    catch (...)
+      {
+        scan_done_one();
+        _curscanworker_ = nullptr;
+        std::lock_guard<std::mutex> gu(failmtx);
+        if (!failure)
+          failure = std::current_exception();
+      }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned ix=1; ix<_dumpjobs_; ix++)
+    threads.emplace_back(run_worker, _du_scanworkers[ix].get());
+  run_worker(mainsw);
+  for (auto& th : threads)
+    th.join();
+  threads.clear();
+  // collect the reached objects, which stay stamped
+  unsigned long nbscan = 0;
+  size_t nbmarked = 0;
+  for (auto& sw : _du_scanworkers)
     {
-      auto scf = _du_scanque.front();
-      nbscan++;
-      BXO_ASSERT(scf, "empty object to scan nbscan=" << nbscan);
-      BXO_VERBOSELOG("nbscan#" << nbscan << " scf=" << scf << ":" << scf->strid());
-      _du_scanque.pop_front();
-      scf->scan_content_dump(*this);
+      nbscan += sw->sw_nbscan;
+      nbmarked += sw->sw_marked.size();
     }
-  while (!_du_todoafterscan.empty())
+  _du_objvec.reserve(nbmarked);
+  for (auto& sw : _du_scanworkers)
+    _du_objvec.insert(_du_objvec.end(), sw->sw_marked.begin(), sw->sw_marked.end());
+  _du_scanworkers.clear();
+  if (failure)
+    std::rethrow_exception(failure);
+  BXO_VERBOSELOG("scan_all scanned " << nbscan << " objects with "
+                 << _dumpjobs_ << " dump jobs in "
+                 << (bxo_elapsed_real_time() - startime) << " s");
+  std::deque<std::pair<std::function<void(BxoDumper&,BxoVal)>,BxoVal>> todoque;
+  {
+    std::lock_guard<std::mutex> gu(_du_todomtx);
+    todoque.swap(_du_todoafterscan);
+  }
+  while (!todoque.empty())
     {
-      auto tdf = _du_todoafterscan.front();
-      _du_todoafterscan.pop_front();
+      auto tdf = todoque.front();
+      todoque.pop_front();
       tdf.first(*this,tdf.second);
     }
   BXO_ASSERT(nbscan>0, "BxoDumper::scan_all bad nbscan:" << nbscan);
@@ -588,52 +1016,230 @@ BxoDumper::scan_all(void)
 
 
 
+bool
+BxoDumper::exec_sql(const char*sql)
+{
+  return sqlite3_exec(_du_sqldb, sql, nullptr, nullptr, nullptr) == SQLITE_OK;
+} // end BxoDumper::exec_sql
+
+void
+BxoDumper::tune_database(void)
+{
+  BXO_ASSERT(_du_sqldb != nullptr, "no _du_sqldb");
+  for (auto& dp : bxo_dump_pragmas)
+    {
+      std::string pragmasql = std::string("PRAGMA ") + dp.dp_name + "=" + dp.dp_value;
+      if (!exec_sql(pragmasql.c_str()))
+        {
+          BXO_BACKTRACELOG("tune_database Sql failure for " << pragmasql << ": " <<  sqlite3_errmsg(_du_sqldb));
+          throw std::runtime_error("BxoDumper::tune_database pragma failure");
+        }
+    }
+} // end BxoDumper::tune_database
+
 void
 BxoDumper::initialize_data_schema()
 {
   BXO_ASSERT(_du_sqldb != nullptr, "no _du_sqldb");
-  QSqlQuery query(*_du_sqldb);
-  if (!query.exec("CREATE TABLE IF NOT EXISTS t_params "
-                  "(par_name VARCHAR(35) PRIMARY KEY ASC NOT NULL UNIQUE,"
-                  "  par_value TEXT NOT NULL)"))
+  if (!exec_sql("CREATE TABLE IF NOT EXISTS t_params "
+                "(par_name VARCHAR(35) PRIMARY KEY ASC NOT NULL UNIQUE,"
+                "  par_value TEXT NOT NULL)"))
     {
-      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_params: " <<  _du_sqldb->lastError().text().toStdString());
+      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_params: " <<  sqlite3_errmsg(_du_sqldb));
       throw std::runtime_error("BxoLoader::initialize_data_schema query failure t_params");
     }
-  if (!query.exec("CREATE TABLE IF NOT EXISTS t_objects "
-                  "(ob_id VARCHAR(20) PRIMARY KEY ASC NOT NULL UNIQUE,"
-                  " ob_mtime DATETIME,"
-                  " ob_jsoncont TEXT NOT NULL,"
-                  " ob_classid VARCHAR(20) NOT NULL,"
-                  " ob_paylkid VARCHAR(20) NOT NULL,"
-                  " ob_paylcont TEXT NOT NULL,"
-                  " ob_paylmod VARCHAR(20) NOT NULL)"))
+  if (!exec_sql("CREATE TABLE IF NOT EXISTS t_objects "
+                "(ob_id VARCHAR(20) PRIMARY KEY ASC NOT NULL UNIQUE,"
+                " ob_mtime DATETIME,"
+                " ob_jsoncont TEXT NOT NULL,"
+                " ob_classid VARCHAR(20) NOT NULL,"
+                " ob_paylkid VARCHAR(20) NOT NULL,"
+                " ob_paylcont TEXT NOT NULL,"
+                " ob_paylmod VARCHAR(20) NOT NULL)"))
     {
-      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_objects: " <<  _du_sqldb->lastError().text().toStdString());
+      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_objects: " <<  sqlite3_errmsg(_du_sqldb));
       throw std::runtime_error("BxoLoader::initialize_data_schema query failure t_objects");
     }
-  if (!query.exec("CREATE TABLE IF NOT EXISTS t_names "
-                  "(nam_str PRIMARY KEY ASC NOT NULL UNIQUE,"
-                  " nam_oid  VARCHAR(20) NOT NULL UNIQUE)"))
+  if (!exec_sql("CREATE TABLE IF NOT EXISTS t_names "
+                "(nam_str PRIMARY KEY ASC NOT NULL UNIQUE,"
+                " nam_oid  VARCHAR(20) NOT NULL UNIQUE)"))
     {
-      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_names: " <<  _du_sqldb->lastError().text().toStdString());
+      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_names: " <<  sqlite3_errmsg(_du_sqldb));
       throw std::runtime_error("BxoLoader::initialize_data_schema query failure t_names");
     }
-  if (!query.exec("CREATE TABLE IF NOT EXISTS t_modules "
-                  "(mod_oid VARCHAR(20) PRIMARY KEY ASC NOT NULL UNIQUE)"))
+  if (!exec_sql("CREATE TABLE IF NOT EXISTS t_modules "
+                "(mod_oid VARCHAR(20) PRIMARY KEY ASC NOT NULL UNIQUE)"))
     {
-      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_modules: " <<  _du_sqldb->lastError().text().toStdString());
+      BXO_BACKTRACELOG("initialize_data_schema Sql query failure t_modules: " <<  sqlite3_errmsg(_du_sqldb));
       throw std::runtime_error("BxoLoader::initialize_data_schema query failure t_modules");
     }
-  if (!query.exec("CREATE UNIQUE INDEX IF NOT EXISTS "
-                  " x_namedid ON t_names (nam_oid)"))
+} // end BxoDumper::initialize_data_schema
+
+
+/// the secondary indexes are built once the rows are inserted, which
+/// is faster than maintaining them during the bulk insert
+void
+BxoDumper::finalize_data_schema()
+{
+  BXO_ASSERT(_du_sqldb != nullptr, "no _du_sqldb");
+  if (!exec_sql("CREATE UNIQUE INDEX IF NOT EXISTS "
+                " x_namedid ON t_names (nam_oid)"))
     {
-      BXO_BACKTRACELOG("initialize_data_schema Sql query failure x_namedid: " <<  _du_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoLoader::initialize_data_schema query failure x_namedid");
+      BXO_BACKTRACELOG("finalize_data_schema Sql query failure x_namedid: " <<  sqlite3_errmsg(_du_sqldb));
+      throw std::runtime_error("BxoDumper::finalize_data_schema query failure x_namedid");
     }
-} // end BxoDumper::initialize_data_schema
+} // end BxoDumper::finalize_data_schema
+
+
+
+/// sort objects by their id_order_key with an LSD radix sort, one
+/// pass per key byte, skipping the bytes shared by all keys; so
+/// t_objects rows are appended in their primary key order
+static void
+bxo_radix_sort_by_id(std::vector<std::pair<Bxo_uint128_t,BxoObject*>>& vec)
+{
+  typedef std::pair<Bxo_uint128_t,BxoObject*> keyedob_t;
+  size_t nbob = vec.size();
+  if (nbob < 2)
+    return;
+  Bxo_uint128_t keyand = ~(Bxo_uint128_t)0, keyor = 0;
+  for (auto& ko : vec)
+    {
+      keyand &= ko.first;
+      keyor |= ko.first;
+    }
+  Bxo_uint128_t keydiff = keyand ^ keyor;
+  std::vector<keyedob_t> tmpvec(nbob);
+  for (unsigned shift = 0; shift < 128; shift += 8)
+    {
+      if (((keydiff >> shift) & 0xff) == 0)
+        continue;
+      size_t count[256] = {0};
+      for (auto& ko : vec)
+        count[(unsigned)(ko.first >> shift) & 0xff]++;
+      size_t pos = 0;
+      for (unsigned ix = 0; ix < 256; ix++)
+        {
+          size_t cnt = count[ix];
+          count[ix] = pos;
+          pos += cnt;
+        }
+      for (auto& ko : vec)
+        tmpvec[count[(unsigned)(ko.first >> shift) & 0xff]++] = ko;
+      vec.swap(tmpvec);
+    }
+} // end bxo_radix_sort_by_id
 
 
+/// serialize the rows in dump_jobs() worker threads, by chunks of
+/// consecutive objects; the calling thread inserts the chunks in
+/// order, so the database is the same as with a single job
+void
+BxoDumper::emit_rows_parallel(const sorted_objects_t&sortedobvec,
+                              const std::function<void(const ObjectRow&)>&insertfun)
+{
+  struct RowChunk
+  {
+    std::vector<ObjectRow> rc_rows;
+    std::exception_ptr rc_failure;
+    bool rc_ready;
+  };
+  size_t nbobj = sortedobvec.size();
+  size_t nbchunks = (nbobj + _emit_chunk_rows_ - 1) / _emit_chunk_rows_;
+  // the workers build at most that many chunks ahead of the inserted ones
+  size_t window = 4 * _dumpjobs_;
+  std::vector<std::unique_ptr<RowChunk>> chunks(nbchunks);
+  std::mutex emitmtx;
+  std::condition_variable builtcond, insertedcond;
+  size_t nextchunk = 0, nbinserted = 0;
+  bool stopping = false;
+  std::vector<std::thread> workers;
+  auto stop_workers = [&]()
+  {
+    {
+      std::lock_guard<std::mutex> gu(emitmtx);
+      stopping = true;
+    }
+    insertedcond.notify_all();
+    for (auto& th : workers)
+      th.join();
+    workers.clear();
+  };
+  for (unsigned ix=0; ix<_dumpjobs_; ix++)
+    workers.emplace_back([&]()
+    {
+      for (;;)
+        {
+          RowChunk* rc = nullptr;
+          size_t chix = 0;
+          {
+            std::unique_lock<std::mutex> lk(emitmtx);
+            insertedcond.wait(lk, [&]()
+            {
+              return stopping || nextchunk >= nbchunks || nextchunk < nbinserted + window;
+            });
+            if (stopping || nextchunk >= nbchunks)
+              return;
+            chix = nextchunk++;
+            chunks[chix].reset(new RowChunk());
+            rc = chunks[chix].get();
+            rc->rc_ready = false;
+          }
+          size_t startix = chix * _emit_chunk_rows_;
+          size_t endix = std::min(nbobj, startix + _emit_chunk_rows_);
+          rc->rc_rows.resize(endix - startix);
+          try
+            {
+              BxoJsonWriter jw(json_writer_mode(), this);
+              for (size_t ix = startix; ix < endix; ix++)
+                build_object_row(sortedobvec[ix].second, rc->rc_rows[ix - startix], jw);
+            }
+          catch (...)
+            {
+              rc->rc_failure = std::current_exception();
+            }
+          {
+            std::lock_guard<std::mutex> gu(emitmtx);
+            rc->rc_ready = true;
+          }
+          builtcond.notify_all();
+        }
+    });
+  try
+    {
+      for (size_t chix = 0; chix < nbchunks; chix++)
+        {
+          RowChunk* rc = nullptr;
+          {
+            std::unique_lock<std::mutex> lk(emitmtx);
+            builtcond.wait(lk, [&]()
+            {
+              return chunks[chix] && chunks[chix]->rc_ready;
+            });
+            rc = chunks[chix].get();
+          }
+          if (rc->rc_failure)
+            std::rethrow_exception(rc->rc_failure);
+          for (const ObjectRow& row : rc->rc_rows)
+            insertfun(row);
+          {
+            std::lock_guard<std::mutex> gu(emitmtx);
+            chunks[chix].reset();
+            nbinserted = chix + 1;
+          }
+          insertedcond.notify_all();
+        }
+    }
+  catch (...)
+    {
+      stop_workers();
+      throw;
+    }
+  stop_workers();
+  BXO_VERBOSELOG("emit_rows_parallel inserted " << nbobj << " rows in "
+                 << nbchunks << " chunks built by " << _dumpjobs_ << " dump jobs");
+} // end BxoDumper::emit_rows_parallel
+
 
 void
 BxoDumper::emit_all()
@@ -642,58 +1248,121 @@ BxoDumper::emit_all()
   BXO_ASSERT(_du_sqldb != nullptr, "no dump sqldb");
   std::map<std::string, BxoObject*> mapname;
   std::set<std::shared_ptr<BxoObject>,BxoLessObjSharedPtr> moduset;
-  _du_queryinsobj = new QSqlQuery(*_du_sqldb);
-  _du_queryinsobj->prepare(insert_object_sql);
-  // emit all dumpable objects
-  BXO_ASSERT(!_du_objset.empty(), "empty _du_objset");
-  for (BxoObject*pob : _du_objset)
+  _du_queryinsobj = new BxoSqlStatement(_du_sqldb, insert_object_sql);
+  if (!_du_queryinsobj->ok())
+    {
+      BXO_BACKTRACELOG("emit_all: SQL failure for object insertion: " << _du_queryinsobj->error());
+      throw std::runtime_error("BxoDumper::emit_all SQL failure for object insertion");
+    }
+  auto transact = [=](const char*sql)
+  {
+    if (!exec_sql(sql))
+      {
+        BXO_BACKTRACELOG("emit_all: SQL failure for " << sql << ": " << sqlite3_errmsg(_du_sqldb));
+        throw std::runtime_error("BxoDumper::emit_all SQL transaction failure");
+      }
+  };
+  transact("BEGIN TRANSACTION");
+  // emit all dumpable objects, in id order
+  BXO_ASSERT(!_du_objvec.empty(), "empty _du_objvec");
+  sorted_objects_t sortedobvec;
+  sortedobvec.reserve(_du_objvec.size());
+  for (BxoObject*pob : _du_objvec)
     {
       BXO_ASSERT(pob != nullptr, "null pob");
-      BXO_VERBOSELOG("BxoDumper::emit_all pob:" << pob << " of id " << pob->strid());
-      auto modob = emit_object_row_module(pob);
-      auto obnam = pob->name();
-      if (!obnam.empty())
-        mapname.insert({obnam,pob});
-      if (modob)
-        moduset.insert(modob);
+      sortedobvec.push_back({pob->id_order_key(),pob});
+    }
+  bxo_radix_sort_by_id(sortedobvec);
+  unsigned nbrows = 0;
+  auto insert_row = [&](const ObjectRow&row)
+  {
+    BxoObject*pob = row.or_obj;
+    BXO_VERBOSELOG("BxoDumper::emit_all pob:" << pob << " of id " << row.or_idstr);
+    insert_object_row(row);
+    auto obnam = pob->name();
+    if (!obnam.empty())
+      mapname.insert({obnam,pob});
+    if (row.or_modob)
+      moduset.insert(row.or_modob);
+    if (_commitrows_ > 0 && ++nbrows % _commitrows_ == 0)
+      {
+        transact("COMMIT TRANSACTION");
+        transact("BEGIN TRANSACTION");
+      }
+  };
+  if (_dumpjobs_ > 1)
+    emit_rows_parallel(sortedobvec, insert_row);
+  else
+    {
+      ObjectRow row;
+      BxoJsonWriter jw(json_writer_mode(), this);
+      for (auto& ko : sortedobvec)
+        {
+          build_object_row(ko.second, row, jw);
+          insert_row(row);
+        }
     }
   delete _du_queryinsobj;
   _du_queryinsobj = nullptr;
   // emit the names
   {
-    QSqlQuery insnamquery(*_du_sqldb);
-    insnamquery.prepare("INSERT INTO t_names (nam_str, nam_oid) VALUES(?, ?)");
+    BxoSqlStatement insnamquery(_du_sqldb, "INSERT INTO t_names (nam_str, nam_oid) VALUES(?, ?)");
     enum { InsnamStrIx, InsnamIdIx, Insnam_Last };
-    for (auto p: mapname)
+    for (auto& p: mapname)
       {
-        insnamquery.bindValue((int)InsnamStrIx, p.first.c_str());
-        insnamquery.bindValue((int)InsnamIdIx, p.second->strid().c_str());
+        std::string idstr = p.second->strid();
+        insnamquery.bind_text((int)InsnamStrIx, p.first);
+        insnamquery.bind_text((int)InsnamIdIx, idstr);
         if (!insnamquery.exec())
           {
             BXO_BACKTRACELOG("emit_all: SQL failure for name insertion name="
-                             << p.first << " id=" << p.second->strid()
-                             << " : " << _du_sqldb->lastError().text().toStdString());
+                             << p.first << " id=" << idstr
+                             << " : " << insnamquery.error());
             throw std::runtime_error("BxoDumper::emit_all SQL failure for name insertion");
           }
       }
   }
+  // emit the parameters
+  {
+    BxoSqlStatement insparquery(_du_sqldb, "INSERT INTO t_params (par_name, par_value) VALUES(?, ?)");
+    enum { InsparNameIx, InsparValueIx, Inspar_Last };
+    std::vector<std::pair<std::string,std::string>> params;
+    if (BxoString::dump_hash_version() != BxoString::hash_version())
+      BXO_VERBOSELOG("emit_all: string hash version " << BxoString::hash_version()
+                     << " of the loaded state becomes " << BxoString::dump_hash_version());
+    params.push_back({"string_hash_version", std::to_string(BxoString::dump_hash_version())});
+    for (auto& dp : bxo_dump_pragmas)
+      params.push_back({std::string("sqlite_") + dp.dp_name, dp.dp_value});
+    for (auto& p : params)
+      {
+        insparquery.bind_text((int)InsparNameIx, p.first);
+        insparquery.bind_text((int)InsparValueIx, p.second);
+        if (!insparquery.exec())
+          {
+            BXO_BACKTRACELOG("emit_all: SQL failure for " << p.first << " parameter"
+                             <<  " : " << insparquery.error());
+            throw std::runtime_error("BxoDumper::emit_all SQL failure for parameter insertion");
+          }
+      }
+  }
   // emit the modules
   {
-    QSqlQuery insmodquery(*_du_sqldb);
-    insmodquery.prepare("INSERT INTO t_modules (mod_oid) VALUES(?)");
+    BxoSqlStatement insmodquery(_du_sqldb, "INSERT INTO t_modules (mod_oid) VALUES(?)");
     enum { InsmodIdIx, Insmod_Last };
     for (auto modob : moduset)
       {
         BXO_ASSERT(modob != nullptr, "null modob");
-        insmodquery.bindValue((int)InsmodIdIx, modob->strid().c_str());
+        std::string idstr = modob->strid();
+        insmodquery.bind_text((int)InsmodIdIx, idstr);
         if (!insmodquery.exec())
           {
-            BXO_BACKTRACELOG("emit_all: SQL failure for module insertion id=" << modob->strid()
-                             <<  " : " << _du_sqldb->lastError().text().toStdString());
+            BXO_BACKTRACELOG("emit_all: SQL failure for module insertion id=" << idstr
+                             <<  " : " << insmodquery.error());
             throw std::runtime_error("BxoDumper::emit_all SQL failure for module insertion");
           }
       }
   }
+  transact("COMMIT TRANSACTION");
 } // end BxoDumper::emit_all
 
 
@@ -762,24 +1431,26 @@ BxoDumper::full_dump(void)
   }
   BXO_ASSERT(_du_sqldb == nullptr, "got an sqldb");
   auto sqlitepath = output_path(std::string(basixmo_statebase)+".sqlite");
-  _du_sqldb = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", "bxodumper"));
-  _du_sqldb->setDatabaseName(QString(sqlitepath.c_str()));
-  if (!_du_sqldb->open())
+  if (sqlite3_open_v2(sqlitepath.c_str(), &_du_sqldb, SQLITE_OPEN_READWRITE|SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK)
     {
       BXO_BACKTRACELOG("full_dump " << sqlitepath
-                       << " failed to open: " << _du_sqldb->lastError().text().toStdString());
+                       << " failed to open: " << (_du_sqldb?sqlite3_errmsg(_du_sqldb):"no memory"));
       throw std::runtime_error("BxoDumper::full_dump open failutr");
     }
+  tune_database();
   scan_all();
-  BXO_ASSERT(!_du_objset.empty(), "empty _du_objset");
+  BXO_ASSERT(!_du_objvec.empty(), "empty _du_objvec");
   initialize_data_schema();
   emit_all();
-  long nbobj = _du_objset.size();
+  finalize_data_schema();
+  long nbobj = _du_objvec.size();
   int nbfil = 0;
-  _du_objset.clear();
+  _du_objvec.clear();
+  _du_blobmap.clear();
   delete _du_queryinsobj;
   _du_queryinsobj = nullptr;
-  _du_sqldb->close();
+  sqlite3_close(_du_sqldb);
+  _du_sqldb = nullptr;
   while (!_du_outfilset.empty())
     {
       std::string outpath;
@@ -790,8 +1461,6 @@ BxoDumper::full_dump(void)
       nbfil++;
       rename_temporary(outpath);
     }
-  delete _du_sqldb;
-  _du_sqldb = nullptr;
   {
     QProcess dumpproc;
     QStringList dumpargs;
@@ -880,29 +1549,90 @@ BxoDumper::rename_temporary(const std::string&filpath)
 
 
 
-std::shared_ptr<BxoObject>
-BxoDumper::emit_object_row_module(BxoObject*pob)
+std::string
+BxoDumper::emit_blob(const BxoBlob&blob)
+{
+  BXO_ASSERT(_du_state == DuEmit, "non-emit state #" << (int)_du_state);
+  std::lock_guard<std::mutex> gu(_du_blobmtx);
+  for (unsigned variant=0; ; variant++)
+    {
+      std::string filnam = blob.file_name(variant);
+      auto it = _du_blobmap.find(filnam);
+      if (it != _du_blobmap.end())
+        {
+          // same bytes already emitted, or an unlikely clash of size and hash
+          if (it->second->same_blob(blob))
+            return filnam;
+          continue;
+        }
+      _du_blobmap.insert({filnam, blob.shared_from_this()});
+      // a blob loaded from that very file, e.g. when dumping back
+      // into the load directory, is not copied at all
+      if (!blob.path().empty())
+        {
+          std::string fullpath = _du_dirname + "/" + filnam;
+          struct ::stat srcstat;
+          struct ::stat dststat;
+          memset (&srcstat, 0, sizeof(srcstat));
+          memset (&dststat, 0, sizeof(dststat));
+          if (!stat(blob.path().c_str(), &srcstat) && !stat(fullpath.c_str(), &dststat)
+              && srcstat.st_dev == dststat.st_dev && srcstat.st_ino == dststat.st_ino)
+            return filnam;
+        }
+      auto outpath = output_path(filnam);
+      FILE* fblob = fopen(outpath.c_str(), "w");
+      if (!fblob)
+        {
+          BXO_BACKTRACELOG("emit_blob failed to fopen " << outpath << " : " << strerror(errno));
+          throw std::runtime_error("BxoDumper::emit_blob fopen failed");
+        }
+      size_t nbwritten = fwrite(blob.data(), 1, blob.size(), fblob);
+      if (fclose(fblob) || nbwritten != blob.size())
+        {
+          BXO_BACKTRACELOG("emit_blob failed to write " << blob.size()
+                           << " bytes to " << outpath << " : " << strerror(errno));
+          throw std::runtime_error("BxoDumper::emit_blob write failed");
+        }
+      BXO_VERBOSELOG("emit_blob wrote " << outpath << " of " << blob.size() << " bytes");
+      return filnam;
+    }
+} // end BxoDumper::emit_blob
+
+
+/// serialize the row of a dumpable object; with several dump jobs
+/// this runs in worker threads, so it only reads the object
+void
+BxoDumper::build_object_row(BxoObject*pob, ObjectRow&row, BxoJsonWriter&jw)
 {
-  std::shared_ptr<BxoObject> modob;
   BXO_ASSERT(pob != nullptr && is_dumpable(pob), "non dumpable object");
-  BXO_ASSERT(_du_queryinsobj != nullptr, "missing queryinsobj");
-  _du_queryinsobj->bindValue((int)InsobIdIx, pob->strid().c_str());
-  _du_queryinsobj->bindValue((int)InsobMtimIx, (qlonglong) pob->mtime());
-  {
-    const BxoJson& jcont= pob->json_for_content(*this);
-    Json::StyledWriter jwr;
-    _du_queryinsobj->bindValue((int)InsobJsoncontIx, jwr.write(jcont).c_str());
-  }
+  row.or_obj = pob;
+  row.or_mtime = (int64_t) pob->mtime();
+  row.or_paylbinary = false;
+  row.or_idstr = pob->strid();
+  row.or_classidstr.clear();
+  row.or_paylkidstr.clear();
+  row.or_paylcontstr.clear();
+  row.or_paylmodstr.clear();
+  row.or_modob.reset();
+  if (_binarycontent_)
+    {
+      BxoBinaryEncoder enc(this);
+      pob->binary_for_content(enc);
+      row.or_contstr = enc.finish();
+    }
+  else
+    {
+      pob->write_content(jw);
+      jw.finish_into(row.or_contstr);
+    }
   auto pcla = pob->class_obj();
   if (pcla && is_dumpable(pcla))
-    _du_queryinsobj->bindValue((int)InsobClassidIx, pcla->strid().c_str());
-  else
-    _du_queryinsobj->bindValue((int)InsobClassidIx, "");
+    row.or_classidstr = pcla->strid();
   auto payl = pob->payload();
   bool pydumpable = false;
   if (payl)
     {
-      auto pykindob = payl->kind_ob();
+      BxoObject* pykindob = payl->kind_obptr();
       if (pykindob && is_dumpable(pykindob))
         {
           std::string loadername = std::string {BxoPayload::loader_prefix} + pykindob->strid();
@@ -910,11 +1640,11 @@ BxoDumper::emit_object_row_module(BxoObject*pob)
           if (ldfun != nullptr)
             {
               pydumpable = true;
-              _du_queryinsobj->bindValue((int)InsobPaylkindIx, pykindob->strid().c_str());
+              row.or_paylkidstr = pykindob->strid();
             }
           else // unlikely, is probably symptom of something wrong
             {
-              BXO_BACKTRACELOG("emit_object_row: cannot dlsym " << loadername << " : " << dlerror()
+              BXO_BACKTRACELOG("build_object_row: cannot dlsym " << loadername << " : " << dlerror()
                                << " for payload of " << pob << " of kind " << pykindob);
               // we dont throw any runtime exception
               pydumpable = false;
@@ -923,29 +1653,54 @@ BxoDumper::emit_object_row_module(BxoObject*pob)
     };
   if (pydumpable)
     {
-      const BxoJson&jpy = payl->emit_payload_content(*this);
-      Json::StyledWriter jwr;
-      _du_queryinsobj->bindValue((int)InsobPaylcontIx, jwr.write(jpy).c_str());
-      modob = payl->module_ob();
-      if (modob && is_dumpable(modob))
-        _du_queryinsobj->bindValue((int)InsobPaylmodIx, modob->strid().c_str());
+      if (_binarycontent_)
+        {
+          BxoBinaryEncoder enc(this);
+          enc.put_json(payl->emit_payload_content(*this));
+          row.or_paylcontstr = enc.finish();
+          row.or_paylbinary = true;
+        }
       else
-        _du_queryinsobj->bindValue((int)InsobPaylmodIx, "");
+        {
+          if (!payl->write_payload_content(*this, jw))
+            jw.put_json(payl->emit_payload_content(*this));
+          jw.finish_into(row.or_paylcontstr);
+        }
+      auto modob = payl->module_ob();
+      if (modob && is_dumpable(modob))
+        {
+          row.or_paylmodstr = modob->strid();
+          row.or_modob = modob;
+        }
     }
+} // end of BxoDumper::build_object_row
+
+
+void
+BxoDumper::insert_object_row(const ObjectRow&row)
+{
+  BXO_ASSERT(_du_queryinsobj != nullptr, "missing queryinsobj");
+  // the statement binds the row strings without copying them
+  _du_queryinsobj->bind_text((int)InsobIdIx, row.or_idstr);
+  _du_queryinsobj->bind_int64((int)InsobMtimIx, row.or_mtime);
+  if (_binarycontent_)
+    _du_queryinsobj->bind_blob((int)InsobJsoncontIx, row.or_contstr);
   else
-    {
-      _du_queryinsobj->bindValue((int)InsobPaylcontIx, "");
-      _du_queryinsobj->bindValue((int)InsobPaylmodIx, "");
-      _du_queryinsobj->bindValue((int)InsobPaylkindIx, "");
-    }
+    _du_queryinsobj->bind_text((int)InsobJsoncontIx, row.or_contstr);
+  _du_queryinsobj->bind_text((int)InsobClassidIx, row.or_classidstr);
+  _du_queryinsobj->bind_text((int)InsobPaylkindIx, row.or_paylkidstr);
+  if (row.or_paylbinary)
+    _du_queryinsobj->bind_blob((int)InsobPaylcontIx, row.or_paylcontstr);
+  else
+    _du_queryinsobj->bind_text((int)InsobPaylcontIx, row.or_paylcontstr);
+  _du_queryinsobj->bind_text((int)InsobPaylmodIx, row.or_paylmodstr);
   if (!_du_queryinsobj->exec())
     {
-      BXO_BACKTRACELOG("emit_object_row: SQL failure for " <<  pob->strid()
-                       << " :" <<  _du_sqldb->lastError().text().toStdString());
-      throw std::runtime_error("BxoDumper::emit_object_row SQL failure");
+      BXO_BACKTRACELOG("insert_object_row: SQL failure for " <<  row.or_idstr
+                       << " :" <<  _du_queryinsobj->error());
+      throw std::runtime_error("BxoDumper::insert_object_row SQL failure");
     }
-  return modob;
-} // end of BxoDumper::emit_object_row_module
+} // end of BxoDumper::insert_object_row
 
 void
 BxoObject::scan_content_dump(BxoDumper&du) const
@@ -966,8 +1721,8 @@ BxoObject::scan_content_dump(BxoDumper&du) const
   if (_payl)
     {
       BXO_ASSERT(_payl->owner() == this, "bad payload owner");
-      auto kob = _payl->kind_ob();
-      if (kob && du.scan_dumpable(kob.get()))
+      BxoObject* kobp = _payl->kind_obptr();
+      if (kobp && du.scan_dumpable(kobp))
         {
           _payl->scan_payload_content(du);
         }
@@ -1014,6 +1769,50 @@ BxoObject::json_for_content(BxoDumper&du) const
   return job;
 } //end BxoObject::json_for_content
 
+void
+BxoObject::write_content(BxoJsonWriter&jw) const
+{
+  jw.begin_object();
+  auto nm = name();
+  if (!nm.empty())
+    {
+      jw.key("@name");
+      jw.put_string(nm);
+    }
+  // the dumpable attributes, in the order of json_for_content
+  std::vector<std::pair<BxoObject*,const BxoVal*>> atvec;
+  atvec.reserve(_attrh.size());
+  for (const auto& p: _attrh)
+    {
+      if (!jw.is_dumpable(p.first)) continue;
+      atvec.push_back({p.first.get(), &p.second});
+    }
+  std::sort(atvec.begin(), atvec.end(),
+            [](const std::pair<BxoObject*,const BxoVal*>&l,
+               const std::pair<BxoObject*,const BxoVal*>&r)
+  {
+    return BxoLessObjPtr()(l.first, r.first);
+  });
+  jw.key("attrs");
+  jw.begin_array();
+  for (auto& p: atvec)
+    {
+      jw.begin_object();
+      jw.key("at");
+      jw.put_objid(p.first);
+      jw.key("va");
+      p.second->write_json(jw);
+      jw.end_object();
+    }
+  jw.end_array();
+  jw.key("comps");
+  jw.begin_array();
+  for (const BxoVal& vcomp : _compv)
+    vcomp.write_json(jw);
+  jw.end_array();
+  jw.end_object();
+} // end BxoObject::write_content
+
 
 void
 BxoObject::load_content(const BxoJson&jv, BxoLoader&ld)
@@ -1056,6 +1855,82 @@ BxoObject::load_content(const BxoJson&jv, BxoLoader&ld)
     }
 } // end BxoObject::load_content
 
+void
+BxoObject::read_content(BxoJsonReader&jr, BxoLoader&ld)
+{
+  jr.begin_object();
+  while (jr.next_key())
+    {
+      if (jr.key_is("attrs") && jr.peek() == '[')
+        {
+          jr.begin_array();
+          while (jr.next_element())
+            {
+              std::shared_ptr<BxoObject> pobat;
+              BxoVal aval;
+              if (ld.read_attribute(jr,pobat,aval))
+                _attrh.insert({pobat,aval});
+            }
+        }
+      else if (jr.key_is("comps") && jr.peek() == '[')
+        {
+          jr.begin_array();
+          while (jr.next_element())
+            _compv.push_back(BxoVal::read_json(jr));
+        }
+      else
+        jr.skip_value();
+    }
+} // end BxoObject::read_content
+
+
+void
+BxoObject::binary_for_content(BxoBinaryEncoder&enc) const
+{
+  // the same content as json_for_content, in the same order
+  enc.put_bytes(name());
+  std::set<std::shared_ptr<BxoObject>,BxoLessObjSharedPtr> atset;
+  for (const auto& p: _attrh)
+    {
+      if (enc.is_dumpable(p.first))
+        atset.insert(p.first);
+    }
+  enc.put_varint(atset.size());
+  for (const auto& pob: atset)
+    {
+      auto pv = _attrh.find(pob);
+      BXO_ASSERT(pv != _attrh.end(), "missing attribute " << pob);
+      enc.put_objref(pob.get());
+      pv->second.to_binary(enc);
+    }
+  enc.put_varint(_compv.size());
+  for (const auto& vcomp : _compv)
+    vcomp.to_binary(enc);
+} // end BxoObject::binary_for_content
+
+
+void
+BxoObject::load_content_binary(BxoBinaryDecoder&dec, BxoLoader&)
+{
+  size_t namlen = 0;
+  dec.get_bytes(namlen);	// the names are loaded from t_names
+  size_t nbat = dec.get_count();
+  _attrh.reserve(5*nbat/4+1);
+  for (size_t ix=0; ix<nbat; ix++)
+    {
+      BxoObject*pobat = dec.get_objref();
+      BxoVal aval = BxoVal::from_binary(dec);
+      if (!pobat) continue;
+      _attrh.insert({pobat->shared_from_this(),aval});
+    }
+  size_t nbcomp = dec.get_count();
+  _compv.reserve(5*nbcomp/4+1);
+  for (size_t ix=0; ix<nbcomp; ix++)
+    _compv.push_back(BxoVal::from_binary(dec));
+  if (!dec.at_end())
+    dec.fail("trailing bytes after object content");
+} // end BxoObject::load_content_binary
+
 void
 BxoObject::touch_load(time_t mtim, BxoLoader&)
 {
@@ -16,6 +16,16 @@
       <http://www.gnu.org/licenses/>.
 **/
 #include "basixmo.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif /*x86*/
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /*__SSE2__*/
 
 
 bool BxoVal::less(const BxoVal&r) const
@@ -36,6 +46,16 @@ bool BxoVal::less(const BxoVal&r) const
       return _set->less_than_set(*(r._set));
     case BxoVKind::TupleK:
       return _tup->less_than_tuple(*(r._tup));
+    case BxoVKind::IntVecK:
+      return _ivec->less_than_packed(*(r._ivec));
+    case BxoVKind::DoubleVecK:
+      return _dvec->less_than_packed(*(r._dvec));
+    case BxoVKind::BlobK:
+      return _blob->less_than_blob(*(r._blob));
+    case BxoVKind::RopeK:
+      return _rope->less_than_rope(*(r._rope));
+    case BxoVKind::MapK:
+      return _omap->less_than_map(*(r._omap));
     }
   return false;
 } // end BxoVal::less
@@ -59,10 +79,130 @@ bool BxoVal::less_equal(const BxoVal&r) const
       break;
     case BxoVKind::TupleK:
       return _tup->less_equal_tuple(*r._tup);
+    case BxoVKind::IntVecK:
+      return _ivec->less_equal_packed(*r._ivec);
+    case BxoVKind::DoubleVecK:
+      return _dvec->less_equal_packed(*r._dvec);
+    case BxoVKind::BlobK:
+      return _blob->less_equal_blob(*r._blob);
+    case BxoVKind::RopeK:
+      return _rope->less_equal_rope(*r._rope);
+    case BxoVKind::MapK:
+      return _omap->less_equal_map(*r._omap);
     }
   return false;
 } // end BxoVal::less_equal
 
+
+/// the big endian bytes of u, so that memcmp orders like integers
+static inline void
+bxo_append_be64(std::string&key, uint64_t u)
+{
+  uint64_t be = htobe64(u);
+  key.append((const char*)&be, sizeof(be));
+} // end bxo_append_be64
+
+bool
+BxoVal::sort_key(std::string&key, size_t maxlen) const
+{
+  key.clear();
+  key.reserve(maxlen);
+  key.push_back((char)_kind);
+  bool cut = false;
+  // append the next part of the key, cutting it at maxlen
+  auto append = [&](const void*ptr, size_t ln)
+  {
+    if (cut) return;
+    if (key.size() + ln > maxlen)
+      {
+        ln = (key.size() < maxlen)?(maxlen - key.size()):0;
+        cut = true;
+      }
+    key.append((const char*)ptr, ln);
+  };
+  constexpr uint64_t signbit = (uint64_t)1 << 63;
+  switch (_kind)
+    {
+    case BxoVKind::NoneK:
+      break;
+    case BxoVKind::IntK:
+      bxo_append_be64(key, (uint64_t)_int ^ signbit);
+      break;
+    case BxoVKind::StringK:
+      append(_str->string().data(), _str->string().size());
+      break;
+    case BxoVKind::ObjectK:
+    {
+      unsigned char obkey[BXO_OBJKEY_SIZE];
+      _obj->pack_key(obkey);
+      append(obkey, sizeof(obkey));
+      break;
+    }
+    case BxoVKind::SetK:
+      append(_set->keys(), _set->length()*BXO_OBJKEY_SIZE);
+      break;
+    case BxoVKind::TupleK:
+      append(_tup->keys(), _tup->length()*BXO_OBJKEY_SIZE);
+      break;
+    case BxoVKind::IntVecK:
+      for (int64_t i : *_ivec)
+        {
+          if (key.size() + sizeof(i) > maxlen)
+            {
+              cut = true;
+              break;
+            }
+          bxo_append_be64(key, (uint64_t)i ^ signbit);
+        }
+      break;
+    case BxoVKind::DoubleVecK:
+      for (double d : *_dvec)
+        {
+          if (key.size() + sizeof(d) > maxlen)
+            {
+              cut = true;
+              break;
+            }
+          // -0.0 equals 0.0 for less, so they share their key
+          if (d == 0.0) d = 0.0;
+          uint64_t u = 0;
+          memcpy(&u, &d, sizeof(u));
+          bxo_append_be64(key, (u & signbit)?~u:(u | signbit));
+        }
+      break;
+    case BxoVKind::BlobK:
+    {
+      bxo_append_be64(key, _blob->size());
+      uint32_t behash = htobe32(_blob->hash());
+      key.append((const char*)&behash, sizeof(behash));
+      append(_blob->data(), _blob->size());
+      break;
+    }
+    case BxoVKind::RopeK:
+      _rope->each_chunk([&](const char*s, size_t ln)
+      {
+        append(s, ln);
+      });
+      break;
+    case BxoVKind::MapK:
+    {
+      // maps of same size and hash are only ordered by less
+      bxo_append_be64(key, _omap->size());
+      uint32_t behash = htobe32(_omap->hash());
+      key.append((const char*)&behash, sizeof(behash));
+      if (_omap->size() > 0)
+        cut = true;
+      break;
+    }
+    }
+  if (key.size() > maxlen)
+    {
+      key.resize(maxlen);
+      cut = true;
+    }
+  return !cut;
+} // end BxoVal::sort_key
+
 BxoJson
 BxoSequence::sequence_to_json(BxoDumper&du) const
 {
@@ -81,6 +221,35 @@ BxoSequence::sequence_to_json(BxoDumper&du) const
   return js;
 } // end BxoSequence::sequence_to_json
 
+void
+BxoSequence::sequence_write_json(BxoJsonWriter&jw) const
+{
+  jw.begin_array();
+  int l = length();
+  for (int ix=0; ix<l; ix++)
+    {
+      if (_seq[ix] && jw.is_dumpable(_seq[ix]))
+        jw.put_objid(_seq[ix].get());
+    }
+  jw.end_array();
+} // end BxoSequence::sequence_write_json
+
+unsigned BxoString::_hash_version_ = BXO_STRING_HASH_VERSION_LATEST;
+bool BxoString::_hash_version_forced_ = false;
+
+void
+BxoString::set_hash_version(unsigned v)
+{
+  if (v < BXO_STRING_HASH_VERSION_LEGACY || v > BXO_STRING_HASH_VERSION_LATEST)
+    {
+      BXO_BACKTRACELOG("set_hash_version: invalid version " << v);
+      throw std::runtime_error("BxoString::set_hash_version invalid version");
+    }
+  if (v != _hash_version_)
+    BXO_VERBOSELOG("string hash version " << _hash_version_ << " -> " << v);
+  _hash_version_ = v;
+} // end BxoString::set_hash_version
+
 BxoHash_t BxoString::hash_cstring(const char*s, int ln)
 {
   if (!s)
@@ -101,6 +270,13 @@ BxoHash_t BxoString::hash_cstring(const char*s, int ln)
       BXO_BACKTRACELOG("hash_cstring: too long string of " << ln << " bytes: " << buf);
       throw std::runtime_error("too long string to hash");
     }
+  if (BXO_UNLIKELY(_hash_version_ == BXO_STRING_HASH_VERSION_LEGACY))
+    return hash_bytes_v1(s, ln);
+  return hash_bytes_v2(s, ln);
+} // end  BxoString::hash_cstring
+
+BxoHash_t BxoString::hash_bytes_v1(const char*s, unsigned ln)
+{
   int l = ln;
   BxoHash_t h1 = 0, h2 = ln, h = 0;
   const char*str = s;
@@ -141,45 +317,298 @@ BxoHash_t BxoString::hash_cstring(const char*s, int ln)
         h = (ln & 0xffffff) + 11;
     }
   return h;
-} // end  BxoString::hash_cstring
+} // end  BxoString::hash_bytes_v1
 
 
-BxoJson
-BxoVal::to_json(BxoJsonEmitter&bje) const
+/// the version 2 string hash is built like xxHash32, but with eight
+/// 32-bit lanes eating 32-byte stripes; the SSE4.1 and AVX2 variants
+/// compute exactly the same lanes as the portable one
+#define BXO_SHPRIME1 UINT32_C(2654435761)
+#define BXO_SHPRIME2 UINT32_C(2246822519)
+#define BXO_SHPRIME3 UINT32_C(3266489917)
+#define BXO_SHPRIME4 UINT32_C(668265263)
+#define BXO_SHPRIME5 UINT32_C(374761393)
+#define BXO_SHSTRIPE 32
+
+static inline uint32_t
+bxo_rotl32(uint32_t x, int r)
 {
-  switch (_kind)
+  return (x << r) | (x >> (32 - r));
+}
+
+static inline uint32_t
+bxo_read_le32(const unsigned char*p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/// initialize the eight lanes, then mix nbstripes stripes into them;
+/// the lanes start in registers, not loaded from acc
+typedef void bxo_strhash_stripes_sig_t(uint32_t*acc, const unsigned char*p, size_t nbstripes);
+
+static void BXO_OPTIMIZEDFUN
+bxo_strhash_stripes_portable(uint32_t*acc, const unsigned char*p, size_t nbstripes)
+{
+  for (int lx = 0; lx < 8; lx++)
+    acc[lx] = BXO_SHPRIME1 * (2*lx + 1) + BXO_SHPRIME2;
+  for (size_t sx = 0; sx < nbstripes; sx++, p += BXO_SHSTRIPE)
+    for (int lx = 0; lx < 8; lx++)
+      acc[lx] = bxo_rotl32(acc[lx] + bxo_read_le32(p + 4*lx) * BXO_SHPRIME2, 13)
+                * BXO_SHPRIME1;
+} // end bxo_strhash_stripes_portable
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse4.1"))) static void
+bxo_strhash_stripes_sse41(uint32_t*acc, const unsigned char*p, size_t nbstripes)
+{
+  const __m128i pr1 = _mm_set1_epi32((int)BXO_SHPRIME1);
+  const __m128i pr2 = _mm_set1_epi32((int)BXO_SHPRIME2);
+  __m128i alo = _mm_add_epi32(_mm_mullo_epi32(_mm_setr_epi32(1,3,5,7), pr1), pr2);
+  __m128i ahi = _mm_add_epi32(_mm_mullo_epi32(_mm_setr_epi32(9,11,13,15), pr1), pr2);
+  for (size_t sx = 0; sx < nbstripes; sx++, p += BXO_SHSTRIPE)
     {
-    case BxoVKind::NoneK:
-      return BxoJson::nullSingleton();
-    case BxoVKind::IntK:
-      return BxoJson((long long)_int);
-    case BxoVKind::StringK:
-      return BxoJson(_str->string());
-    case BxoVKind::ObjectK:
-      if (bje.is_dumpable(_obj))
-        {
-          BxoJson job(Json::objectValue);
-          job["oid"] = _obj->id_to_json();
-          return job;
-        }
-      else return BxoJson::nullSingleton();
-    case BxoVKind::SetK:
+      __m128i wlo = _mm_loadu_si128((const __m128i*)p);
+      __m128i whi = _mm_loadu_si128((const __m128i*)(p+16));
+      alo = _mm_add_epi32(alo, _mm_mullo_epi32(wlo, pr2));
+      ahi = _mm_add_epi32(ahi, _mm_mullo_epi32(whi, pr2));
+      alo = _mm_or_si128(_mm_slli_epi32(alo, 13), _mm_srli_epi32(alo, 19));
+      ahi = _mm_or_si128(_mm_slli_epi32(ahi, 13), _mm_srli_epi32(ahi, 19));
+      alo = _mm_mullo_epi32(alo, pr1);
+      ahi = _mm_mullo_epi32(ahi, pr1);
+    }
+  _mm_storeu_si128((__m128i*)acc, alo);
+  _mm_storeu_si128((__m128i*)(acc+4), ahi);
+} // end bxo_strhash_stripes_sse41
+
+__attribute__((target("avx2"))) static void
+bxo_strhash_stripes_avx2(uint32_t*acc, const unsigned char*p, size_t nbstripes)
+{
+  const __m256i pr1 = _mm256_set1_epi32((int)BXO_SHPRIME1);
+  const __m256i pr2 = _mm256_set1_epi32((int)BXO_SHPRIME2);
+  __m256i ac = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_setr_epi32(1,3,5,7,9,11,13,15), pr1), pr2);
+  for (size_t sx = 0; sx < nbstripes; sx++, p += BXO_SHSTRIPE)
     {
-      BxoJson job(Json::objectValue);
-      job["set"] = _set->sequence_to_json(bje);
-      return job;
-    };
-    case BxoVKind::TupleK:
+      __m256i w = _mm256_loadu_si256((const __m256i*)p);
+      ac = _mm256_add_epi32(ac, _mm256_mullo_epi32(w, pr2));
+      ac = _mm256_or_si256(_mm256_slli_epi32(ac, 13), _mm256_srli_epi32(ac, 19));
+      ac = _mm256_mullo_epi32(ac, pr1);
+    }
+  _mm256_storeu_si256((__m256i*)acc, ac);
+} // end bxo_strhash_stripes_avx2
+#endif /*x86*/
+
+static bxo_strhash_stripes_sig_t*
+bxo_choose_strhash_stripes(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return bxo_strhash_stripes_avx2;
+  if (__builtin_cpu_supports("sse4.1"))
+    return bxo_strhash_stripes_sse41;
+#endif /*x86*/
+  return bxo_strhash_stripes_portable;
+} // end bxo_choose_strhash_stripes
+
+BxoHash_t BxoString::hash_bytes_v2(const char*s, size_t ln)
+{
+  static bxo_strhash_stripes_sig_t*const stripesfun = bxo_choose_strhash_stripes();
+  const unsigned char*p = (const unsigned char*)s;
+  size_t rem = ln;
+  uint32_t h = 0;
+  if (ln >= BXO_SHSTRIPE)
     {
-      BxoJson job(Json::objectValue);
-      job["tup"] = _set->sequence_to_json(bje);
-      return job;
-    };
+      uint32_t acc[8];
+      size_t nbstripes = ln / BXO_SHSTRIPE;
+      (*stripesfun)(acc, p, nbstripes);
+      p += nbstripes * BXO_SHSTRIPE;
+      rem -= nbstripes * BXO_SHSTRIPE;
+      h = bxo_rotl32(acc[0], 1) + bxo_rotl32(acc[1], 5) + bxo_rotl32(acc[2], 7)
+          + bxo_rotl32(acc[3], 12) + bxo_rotl32(acc[4], 16) + bxo_rotl32(acc[5], 18)
+          + bxo_rotl32(acc[6], 23) + bxo_rotl32(acc[7], 27);
+    }
+  else
+    h = BXO_SHPRIME5;
+  h += (uint32_t) ln;
+  while (rem >= 4)
+    {
+      h += bxo_read_le32(p) * BXO_SHPRIME3;
+      h = bxo_rotl32(h, 17) * BXO_SHPRIME4;
+      p += 4;
+      rem -= 4;
     }
-  return BxoJson::nullSingleton();
+  while (rem > 0)
+    {
+      h += (*p) * BXO_SHPRIME5;
+      h = bxo_rotl32(h, 11) * BXO_SHPRIME1;
+      p++;
+      rem--;
+    }
+  h ^= h >> 15;
+  h *= BXO_SHPRIME2;
+  h ^= h >> 13;
+  h *= BXO_SHPRIME3;
+  h ^= h >> 16;
+  if (BXO_UNLIKELY(!h))
+    h = (ln & 0xffffff) + 11;
+  return h;
+} // end  BxoString::hash_bytes_v2
+
+
+/// the visitor making the JSON of a value
+class BxoJsonVisitor
+{
+  BxoDumper& _du;
+  static BxoJson boxed(const char*key, const BxoJson&jv)
+  {
+    BxoJson job(Json::objectValue);
+    job[key] = jv;
+    return job;
+  };
+public:
+  BxoJsonVisitor(BxoDumper&du) : _du(du) {};
+  BxoJson operator () (BxoVal::TagNone, std::nullptr_t) const
+  {
+    return BxoJson::nullSingleton();
+  };
+  BxoJson operator () (BxoVal::TagInt, intptr_t i) const
+  {
+    return BxoJson((Json::Int64)i);
+  };
+  BxoJson operator () (BxoVal::TagString, const BxoString&str) const
+  {
+    return BxoJson(str.string());
+  };
+  BxoJson operator () (BxoVal::TagObject,
+                       const std::shared_ptr<BxoObject>&obp) const
+  {
+    if (_du.is_dumpable(obp))
+      return boxed("oid", obp->id_to_json());
+    return BxoJson::nullSingleton();
+  };
+  BxoJson operator () (BxoVal::TagSet, const BxoSet&set) const
+  {
+    return boxed("set", set.sequence_to_json(_du));
+  };
+  BxoJson operator () (BxoVal::TagTuple, const BxoTuple&tup) const
+  {
+    return boxed("tup", tup.sequence_to_json(_du));
+  };
+  BxoJson operator () (BxoVal::TagIntVec, const BxoIntVec&ivec) const
+  {
+    return boxed(BxoIntVec::json_key(), ivec.packed_to_json());
+  };
+  BxoJson operator () (BxoVal::TagDoubleVec, const BxoDoubleVec&dvec) const
+  {
+    return boxed(BxoDoubleVec::json_key(), dvec.packed_to_json());
+  };
+  BxoJson operator () (BxoVal::TagBlob, const BxoBlob&blob) const
+  {
+    return blob.blob_to_json(_du);
+  };
+  BxoJson operator () (BxoVal::TagRope, const BxoRope&rope) const
+  {
+    return boxed("rope", rope.rope_to_json());
+  };
+  BxoJson operator () (BxoVal::TagMap, const BxoMap&map) const
+  {
+    return boxed("map", map.map_to_json(_du));
+  };
+};        // end BxoJsonVisitor
+
+BxoJson
+BxoVal::to_json(BxoDumper&du) const
+{
+  return visit(BxoJsonVisitor(du));
 } // end BxoVal::to_json
 
 
+/// the visitor streaming the JSON of a value, the one BxoJsonVisitor
+/// builds
+class BxoJsonWriteVisitor
+{
+  BxoJsonWriter& _jw;
+  void boxed_key(const char*key) const
+  {
+    _jw.begin_object();
+    _jw.key(key);
+  };
+public:
+  BxoJsonWriteVisitor(BxoJsonWriter&jw) : _jw(jw) {};
+  void operator () (BxoVal::TagNone, std::nullptr_t) const
+  {
+    _jw.put_null();
+  };
+  void operator () (BxoVal::TagInt, intptr_t i) const
+  {
+    _jw.put_int(i);
+  };
+  void operator () (BxoVal::TagString, const BxoString&str) const
+  {
+    _jw.put_string(str.string());
+  };
+  void operator () (BxoVal::TagObject,
+                    const std::shared_ptr<BxoObject>&obp) const
+  {
+    if (!_jw.is_dumpable(obp))
+      {
+        _jw.put_null();
+        return;
+      }
+    boxed_key("oid");
+    _jw.put_objid(obp.get());
+    _jw.end_object();
+  };
+  void operator () (BxoVal::TagSet, const BxoSet&set) const
+  {
+    boxed_key("set");
+    set.sequence_write_json(_jw);
+    _jw.end_object();
+  };
+  void operator () (BxoVal::TagTuple, const BxoTuple&tup) const
+  {
+    boxed_key("tup");
+    tup.sequence_write_json(_jw);
+    _jw.end_object();
+  };
+  void operator () (BxoVal::TagIntVec, const BxoIntVec&ivec) const
+  {
+    boxed_key(BxoIntVec::json_key());
+    ivec.packed_write_json(_jw);
+    _jw.end_object();
+  };
+  void operator () (BxoVal::TagDoubleVec, const BxoDoubleVec&dvec) const
+  {
+    boxed_key(BxoDoubleVec::json_key());
+    dvec.packed_write_json(_jw);
+    _jw.end_object();
+  };
+  void operator () (BxoVal::TagBlob, const BxoBlob&blob) const
+  {
+    blob.blob_write_json(_jw);
+  };
+  void operator () (BxoVal::TagRope, const BxoRope&rope) const
+  {
+    boxed_key("rope");
+    _jw.put_string(rope.to_string());
+    _jw.end_object();
+  };
+  void operator () (BxoVal::TagMap, const BxoMap&map) const
+  {
+    boxed_key("map");
+    map.map_write_json(_jw);
+    _jw.end_object();
+  };
+};        // end BxoJsonWriteVisitor
+
+void
+BxoVal::write_json(BxoJsonWriter&jw) const
+{
+  visit(BxoJsonWriteVisitor(jw));
+} // end BxoVal::write_json
+
+
 
 BxoVal
 BxoVal::from_json(BxoJsonProcessor& bxj, const BxoJson&js)
@@ -192,7 +621,17 @@ BxoVal::from_json(BxoJsonProcessor& bxj, const BxoJson&js)
     case Json::uintValue:
       return BxoVInt(js.asInt64());
     case Json::stringValue:
-      return BxoVString(js.asString());
+    {
+      const char*strbeg = nullptr;
+      const char*strend = nullptr;
+      js.getString(&strbeg, &strend);
+      if (!bxo_utf8_valid(strbeg, strend - strbeg))
+        {
+          BXO_BACKTRACELOG("from_json invalid UTF-8 string js=" << js);
+          throw std::runtime_error("BxoVal::from_json invalid UTF-8 string");
+        }
+      return BxoVString(strbeg?std::string(strbeg, strend - strbeg):std::string());
+    }
     case Json::arrayValue:
       return bxj.val_from_json(js);
     case Json::objectValue:
@@ -205,7 +644,7 @@ BxoVal::from_json(BxoJsonProcessor& bxj, const BxoJson&js)
               auto idstr = jid.asString();
               BxoObject* pob = bxj.obj_from_idstr(idstr);
               if (pob)
-                return BxoVObj(pob);
+                return BxoVObj(pob->shared_from_this());
             }
         }
       else if (js.isMember("set"))
@@ -228,6 +667,36 @@ BxoVal::from_json(BxoJsonProcessor& bxj, const BxoJson&js)
                 return BxoVTuple(*ptup);
             }
         }
+      else if (js.isMember(BxoIntVec::json_key()))
+        {
+          auto pivec = BxoIntVec::load_packed(js[BxoIntVec::json_key()]);
+          if (pivec)
+            return BxoVIntVec(*pivec);
+        }
+      else if (js.isMember(BxoDoubleVec::json_key()))
+        {
+          auto pdvec = BxoDoubleVec::load_packed(js[BxoDoubleVec::json_key()]);
+          if (pdvec)
+            return BxoVDoubleVec(*pdvec);
+        }
+      else if (js.isMember("blob") || js.isMember("blob64"))
+        {
+          auto pblob = BxoBlob::load_blob(bxj, js);
+          if (pblob)
+            return BxoVBlob(*pblob);
+        }
+      else if (js.isMember("rope"))
+        {
+          auto prope = BxoRope::load_rope(js["rope"]);
+          if (prope)
+            return BxoVRope(*prope);
+        }
+      else if (js.isMember("map"))
+        {
+          auto pmap = BxoMap::load_map(bxj, js["map"]);
+          if (pmap)
+            return BxoVMap(*pmap);
+        }
     }
     }
   BXO_BACKTRACELOG("BxoVal::from_json: bad json " << js);
@@ -235,6 +704,76 @@ BxoVal::from_json(BxoJsonProcessor& bxj, const BxoJson&js)
 } // end of BxoVal::from_json
 
 
+BxoVal
+BxoVal::read_json(BxoJsonReader&jr)
+{
+  switch (jr.peek())
+    {
+    case 'n':
+      jr.get_null();
+      return BxoVNone();
+    case '"':
+    {
+      const char*str = nullptr;
+      size_t ln = 0;
+      jr.get_string(str, ln);
+      if (!bxo_utf8_valid(str, ln))
+        jr.fail("invalid UTF-8 string");
+      return BxoVString(std::string(str, ln));
+    }
+    case '{':
+      break;
+    case '[':
+      jr.fail("unexpected array value");
+    default:
+      return BxoVInt(jr.get_int());
+    }
+  // objects, sets and tuples are read here; other kinds, and unusual
+  // shapes, are given to from_json
+  const char* mk = jr.mark();
+  jr.begin_object();
+  if (jr.next_key())
+    {
+      bool isoid = jr.key_is("oid");
+      bool isset = !isoid && jr.key_is("set");
+      bool istup = !isoid && !isset && jr.key_is("tup");
+      Bxo_hid_t hid=0;
+      Bxo_loid_t loid=0;
+      if (isoid && jr.peek() == '"')
+        {
+          BxoObject* pob = jr.get_id(hid,loid)
+                           ? jr.processor().obj_from_hid_loid(hid,loid) : nullptr;
+          if (pob && !jr.next_key())
+            return BxoVObj(pob->shared_from_this());
+        }
+      else if ((isset || istup) && jr.peek() == '[')
+        {
+          std::vector<BxoObject*> vecob;
+          bool good = true;
+          jr.begin_array();
+          while (good && jr.next_element())
+            {
+              BxoObject* pob = nullptr;
+              if (jr.peek() == '"' && jr.get_id(hid,loid))
+                pob = jr.processor().obj_from_hid_loid(hid,loid);
+              if (pob)
+                vecob.push_back(pob);
+              else
+                good = false;
+            }
+          if (good && !jr.next_key())
+            {
+              if (isset)
+                return BxoVSet(*BxoSet::make_set(vecob));
+              return BxoVTuple(*BxoTuple::make_tuple(vecob));
+            }
+        }
+    }
+  jr.reset(mk);
+  return from_json(jr.processor(), jr.get_json());
+} // end of BxoVal::read_json
+
+
 
 BxoVString::BxoVString(const std::string& s)
   : BxoVal(TagString {},s)
@@ -246,6 +785,31 @@ BxoVString::BxoVString(const BxoString&bs)
 {
 }
 
+BxoVIntVec::BxoVIntVec(const int64_t*arr, unsigned len)
+  : BxoVal(TagIntVec {}, BxoIntVec::make_packed(arr, len))
+{
+}
+
+BxoVIntVec::BxoVIntVec(const std::vector<int64_t>&vec)
+  : BxoVal(TagIntVec {}, BxoIntVec::make_packed(vec))
+{
+}
+
+BxoVDoubleVec::BxoVDoubleVec(const double*arr, unsigned len)
+  : BxoVal(TagDoubleVec {}, BxoDoubleVec::make_packed(arr, len))
+{
+}
+
+BxoVDoubleVec::BxoVDoubleVec(const std::vector<double>&vec)
+  : BxoVal(TagDoubleVec {}, BxoDoubleVec::make_packed(vec))
+{
+}
+
+BxoVBlob::BxoVBlob(const void*data, size_t size)
+  : BxoVal(TagBlob {}, BxoBlob::make_blob(data, size))
+{
+}
+
 BxoSet
 BxoSet::the_empty_set {BxoSet::init_hash,0,nullptr};
 
@@ -270,7 +834,8 @@ BxoSet::make_set(const std::set<std::shared_ptr<BxoObject>,BxoLessObjSharedPtr>&
       BXO_BACKTRACELOG("make_set: too big size " << siz);
       throw std::runtime_error("BxoSet::make_set too big size");
     }
-  std::vector<std::shared_ptr<BxoObject>> vec {siz};
+  std::vector<std::shared_ptr<BxoObject>> vec;
+  vec.reserve(siz);
   BxoHash_t h = init_hash;
   for (const auto&p : bs)
     {
@@ -329,7 +894,7 @@ BxoSet::make_set(const std::vector<std::shared_ptr<BxoObject>>&vec)
       BXO_BACKTRACELOG("make_set: too big size " << siz);
       throw std::runtime_error("BxoSet::make_set too big size");
     }
-  std::vector<std::shared_ptr<BxoObject>> copy {siz+1};
+  std::vector<std::shared_ptr<BxoObject>> copy {vec};
   for (unsigned ix=0; ix<(unsigned)siz; ix++)
     {
       if (BXO_UNLIKELY(!vec[ix]))
@@ -337,7 +902,6 @@ BxoSet::make_set(const std::vector<std::shared_ptr<BxoObject>>&vec)
           BXO_BACKTRACELOG("make_set: nil element");
           throw std::runtime_error("BxoSet::make_set nil element");
         }
-      copy[ix] = vec[ix];
     }
   std::sort(copy.begin(), copy.end(), BxoLessObjSharedPtr {});
   int nbdup = 0;
@@ -349,7 +913,8 @@ BxoSet::make_set(const std::vector<std::shared_ptr<BxoObject>>&vec)
       h = combine_hash(h, *copy[ix]);
   if (BXO_LIKELY(nbdup==0))
     return new BxoSet(h,siz,copy.data());
-  std::vector<std::shared_ptr<BxoObject>> unicopy {siz-nbdup+1};
+  std::vector<std::shared_ptr<BxoObject>> unicopy;
+  unicopy.reserve(siz-nbdup);
   unicopy.push_back(copy[0]);
   for (unsigned ix=1; ix<(unsigned)siz; ix++)
     if (copy[ix] != copy[ix-1])
@@ -357,9 +922,102 @@ BxoSet::make_set(const std::vector<std::shared_ptr<BxoObject>>&vec)
   return new BxoSet(h,siz-nbdup,unicopy.data());
 } // end BxoSet::make_set
 
+const BxoSet*
+BxoSet::make_slice(const std::shared_ptr<const BxoSet>&pset, int from, int to)
+{
+  if (!pset)
+    {
+      BXO_BACKTRACELOG("make_slice: nil set");
+      throw std::runtime_error("BxoSet::make_slice nil set");
+    }
+  pset->slice_bounds(from, to);
+  unsigned len = to - from;
+  if (len == 0) return &the_empty_set;
+  auto h = adjust_hash(fold_hash(init_hash, pset->_seq+from, len, combine_hash), len);
+  return new BxoSet(SliceTag {}, h, pset, from, len);
+} // end BxoSet::make_slice
+
+
+const BxoSet*
+BxoSet::make_union(const BxoSet&lset, const BxoSet&rset)
+{
+  unsigned llen = lset.length(), rlen = rset.length();
+  if (BXO_UNLIKELY(llen + rlen > BXO_SIZE_MAX))
+    {
+      BXO_BACKTRACELOG("make_union: too big size " << llen << "+" << rlen);
+      throw std::runtime_error("BxoSet::make_union too big size");
+    }
+  std::vector<std::shared_ptr<BxoObject>> vec;
+  vec.reserve(llen+rlen+1);
+  // both sets are sorted, so merge them
+  unsigned lix=0, rix=0;
+  while (lix<llen && rix<rlen)
+    {
+      auto& lob = lset._seq[lix];
+      auto& rob = rset._seq[rix];
+      if (lob == rob)
+        {
+          vec.push_back(lob);
+          lix++, rix++;
+        }
+      else if (lob->less(*rob))
+        vec.push_back(lset._seq[lix++]);
+      else
+        vec.push_back(rset._seq[rix++]);
+    }
+  while (lix<llen)
+    vec.push_back(lset._seq[lix++]);
+  while (rix<rlen)
+    vec.push_back(rset._seq[rix++]);
+  unsigned len = vec.size();
+  if (len == 0) return &the_empty_set;
+  auto h = adjust_hash(fold_hash(init_hash, vec.data(), len, combine_hash), len);
+  return new BxoSet(h, len, vec.data());
+} // end BxoSet::make_union
+
 BxoTuple
 BxoTuple::the_empty_tuple {BxoTuple::init_hash,0,nullptr};
 
+const BxoTuple*
+BxoTuple::make_slice(const std::shared_ptr<const BxoTuple>&ptup, int from, int to)
+{
+  if (!ptup)
+    {
+      BXO_BACKTRACELOG("make_slice: nil tuple");
+      throw std::runtime_error("BxoTuple::make_slice nil tuple");
+    }
+  ptup->slice_bounds(from, to);
+  unsigned len = to - from;
+  if (len == 0) return &the_empty_tuple;
+  auto h = adjust_hash(fold_hash(init_hash, ptup->_seq+from, len, combine_hash), len);
+  return new BxoTuple(SliceTag {}, h, ptup, from, len);
+} // end BxoTuple::make_slice
+
+
+const BxoTuple*
+BxoTuple::make_concat(const BxoTuple&ltup, const BxoTuple&rtup)
+{
+  unsigned llen = ltup.length(), rlen = rtup.length();
+  if (rlen == 0 && llen == 0) return &the_empty_tuple;
+  if (BXO_UNLIKELY(llen + rlen > BXO_SIZE_MAX))
+    {
+      BXO_BACKTRACELOG("make_concat: too big size " << llen << "+" << rlen);
+      throw std::runtime_error("BxoTuple::make_concat too big size");
+    }
+  // the tuple hash is a left fold, so we continue from the hash of
+  // the left tuple, unless it has been adjusted from 0
+  BxoHash_t h = init_hash;
+  if (llen > 0)
+    {
+      if (BXO_LIKELY(ltup._hash != adjust_hash(0, llen)))
+        h = ltup._hash;
+      else
+        h = fold_hash(init_hash, ltup._seq, llen, combine_hash);
+    }
+  h = adjust_hash(fold_hash(h, rtup._seq, rlen, combine_hash), llen+rlen);
+  return new BxoTuple(h, ltup._seq, llen, rtup._seq, rlen);
+} // end BxoTuple::make_concat
+
 const BxoTuple*
 BxoTuple::make_tuple(const std::vector<BxoObject*>&vecptr)
 {
@@ -409,93 +1067,802 @@ BxoTuple::make_tuple(const std::vector<std::shared_ptr<BxoObject>>& vec)
   return new BxoTuple(h,(unsigned)copyvec.size(), copyvec.data());
 } // end of BxoTuple::make_tuple
 
+/// the visitor scanning a value for the dumper; scalar data and
+/// vectors, blobs and ropes don't refer to any object
+class BxoScanVisitor
+{
+  BxoDumper& _du;
+public:
+  BxoScanVisitor(BxoDumper&du) : _du(du) {};
+  void operator () (BxoVal::TagObject,
+                    const std::shared_ptr<BxoObject>&obp) const
+  {
+    _du.scan_dumpable(obp.get());
+  };
+  void operator () (BxoVal::TagSet, const BxoSet&set) const
+  {
+    set.sequence_scan_dump(_du);
+  };
+  void operator () (BxoVal::TagTuple, const BxoTuple&tup) const
+  {
+    tup.sequence_scan_dump(_du);
+  };
+  void operator () (BxoVal::TagMap, const BxoMap&map) const
+  {
+    map.map_scan_dump(_du);
+  };
+  template <typename Tag, typename Data>
+  void operator () (Tag, const Data&) const
+  {
+  };
+};        // end BxoScanVisitor
+
 void
 BxoVal::scan_dump(BxoDumper&du) const
 {
-  switch (_kind)
+  visit(BxoScanVisitor(du));
+} // end BxoVal::scan_dump
+
+
+
+/// the length of the valid UTF-8 sequence starting at p, or 0
+static inline unsigned
+bxo_utf8_seqlen(const unsigned char*p, size_t avail)
+{
+  unsigned char c = p[0];
+  if (c < 0x80)
+    return 1;
+  if (c < 0xc2)
+    return 0;
+  if (c < 0xe0)
+    return (avail >= 2 && (p[1] & 0xc0) == 0x80) ? 2 : 0;
+  if (c < 0xf0)
     {
-    case BxoVKind::NoneK:
-    case BxoVKind::IntK:
-    case BxoVKind::StringK:
-      return;
-    case BxoVKind::ObjectK:
-      du.scan_dumpable(_obj.get());
-      break;
-    case BxoVKind::TupleK:
-      _tup->sequence_scan_dump(du);
-      break;
-    case BxoVKind::SetK:
-      _set->sequence_scan_dump(du);
-      break;
+      if (avail < 3 || (p[2] & 0xc0) != 0x80)
+        return 0;
+      unsigned char c1 = p[1];
+      if (c == 0xe0) // overlong
+        return (c1 >= 0xa0 && c1 <= 0xbf) ? 3 : 0;
+      if (c == 0xed) // surrogates
+        return (c1 >= 0x80 && c1 <= 0x9f) ? 3 : 0;
+      return ((c1 & 0xc0) == 0x80) ? 3 : 0;
     }
-} // end BxoVal::scan_dump
+  if (c < 0xf5)
+    {
+      if (avail < 4 || (p[2] & 0xc0) != 0x80 || (p[3] & 0xc0) != 0x80)
+        return 0;
+      unsigned char c1 = p[1];
+      if (c == 0xf0) // overlong
+        return (c1 >= 0x90 && c1 <= 0xbf) ? 4 : 0;
+      if (c == 0xf4) // above U+10FFFF
+        return (c1 >= 0x80 && c1 <= 0x8f) ? 4 : 0;
+      return ((c1 & 0xc0) == 0x80) ? 4 : 0;
+    }
+  return 0;
+} // end bxo_utf8_seqlen
 
+bool
+bxo_utf8_valid(const char*s, size_t len)
+{
+  if (!s)
+    return len == 0;
+  const unsigned char*p = (const unsigned char*)s;
+  const unsigned char*end = p + len;
+  while (p < end)
+    {
+#ifdef __SSE2__
+      while (end - p >= 16)
+        {
+          int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p));
+          if (mask)
+            {
+              p += __builtin_ctz(mask);
+              break;
+            }
+          p += 16;
+        }
+#else
+      while (end - p >= 8)
+        {
+          uint64_t w = 0;
+          memcpy(&w, p, 8);
+          if (w & UINT64_C(0x8080808080808080))
+            break;
+          p += 8;
+        }
+#endif /*__SSE2__*/
+      if (p >= end)
+        break;
+      if (*p < 0x80)
+        {
+          p++;
+          continue;
+        }
+      unsigned sl = bxo_utf8_seqlen(p, end - p);
+      if (!sl)
+        return false;
+      p += sl;
+    }
+  return true;
+} // end bxo_utf8_valid
 
+static inline void
+bxo_append_hexesc(std::string&buf, const char*prefix, uint32_t val, int nbdigits)
+{
+  static const char hexdigits[] = "0123456789abcdef";
+  buf += prefix;
+  for (int dx = nbdigits - 1; dx >= 0; dx--)
+    buf.push_back(hexdigits[(val >> (4*dx)) & 0xf]);
+} // end bxo_append_hexesc
 
 void
-BxoUtf8Out::out(std::ostream&os) const
+bxo_utf8_escape(std::string&buf, const char*s, size_t len, unsigned flags)
 {
-  uint32_t uc = 0;
-  auto it = _str.begin();
-  auto end = _str.end();
-  while ((uc=utf8::next(it, end)) != 0)
+  const bool json = (flags & BXO_UTF8ESC_JSON) != 0;
+  const unsigned char*p = (const unsigned char*)s;
+  const unsigned char*end = p + len;
+  buf.reserve(buf.size() + len + len/8 + 8);
+#ifdef __SSE2__
+  // signed comparison to space catches both controls and non-ASCII bytes
+  const __m128i spacev = _mm_set1_epi8(' ');
+  const __m128i dquotev = _mm_set1_epi8('"');
+  const __m128i bslashv = _mm_set1_epi8('\\');
+  // JSON leaves DEL as is, so then compare again with the double quote
+  const __m128i delv = _mm_set1_epi8(json ? '"' : 0x7f);
+#endif /*__SSE2__*/
+  while (p < end)
     {
-      switch (uc)
+#ifdef __SSE2__
+      while (end - p >= 16)
         {
-        case 0:
-          os << "\\0";
+          __m128i v = _mm_loadu_si128((const __m128i*)p);
+          __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(v, spacev),
+                                                _mm_cmpeq_epi8(v, dquotev)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, bslashv),
+                                                _mm_cmpeq_epi8(v, delv)));
+          int mask = _mm_movemask_epi8(m);
+          if (!mask)
+            {
+              buf.append((const char*)p, 16);
+              p += 16;
+              continue;
+            }
+          int nbplain = __builtin_ctz(mask);
+          buf.append((const char*)p, nbplain);
+          p += nbplain;
           break;
+        }
+      if (p >= end)
+        break;
+#endif /*__SSE2__*/
+      unsigned char c = *p;
+      if (c >= ' ' && c < 0x80 && c != '"' && c != '\\' && (c != 0x7f || json))
+        {
+          buf.push_back((char)c);
+          p++;
+          continue;
+        }
+      uint32_t uc = c;
+      unsigned sl = 1;
+      if (c >= 0x80)
+        {
+          sl = bxo_utf8_seqlen(p, end - p);
+          BXO_ASSERT(sl > 1, "bxo_utf8_escape invalid UTF-8 at offset " << (p - (const unsigned char*)s));
+          if (sl == 2)
+            uc = ((c & 0x1f) << 6) | (p[1] & 0x3f);
+          else if (sl == 3)
+            uc = ((c & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+          else
+            uc = ((c & 0x07) << 18) | ((p[1] & 0x3f) << 12)
+                 | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+        }
+      p += sl;
+      switch (uc)
+        {
         case '\"':
-          os << "\\\"";
-          break;
+          buf += "\\\"";
+          continue;
         case '\\':
-          os << "\\\\";
-          break;
-        case '\a':
-          os << "\\a";
-          break;
+          buf += "\\\\";
+          continue;
         case '\b':
-          os << "\\b";
-          break;
+          buf += "\\b";
+          continue;
         case '\f':
-          os << "\\f";
-          break;
+          buf += "\\f";
+          continue;
         case '\n':
-          os << "\\n";
-          break;
+          buf += "\\n";
+          continue;
         case '\r':
-          os << "\\r";
-          break;
+          buf += "\\r";
+          continue;
         case '\t':
-          os << "\\t";
+          buf += "\\t";
+          continue;
+        }
+      if (json)
+        {
+          if (uc < 0x10000)
+            bxo_append_hexesc(buf, "\\u", uc, 4);
+          else
+            {
+              uc -= 0x10000;
+              bxo_append_hexesc(buf, "\\u", 0xd800 + (uc >> 10), 4);
+              bxo_append_hexesc(buf, "\\u", 0xdc00 + (uc & 0x3ff), 4);
+            }
+          continue;
+        }
+      switch (uc)
+        {
+        case 0:
+          buf += "\\0";
+          break;
+        case '\a':
+          buf += "\\a";
           break;
         case '\v':
-          os << "\\v";
+          buf += "\\v";
           break;
         case '\033':
-          os << "\\e";
+          buf += "\\e";
           break;
         default:
-          if (uc<127 && ::isprint((char)uc))
-            os << (char)uc;
-          else if (uc<=0xffff)
-            {
-              char buf[8];
-              snprintf(buf, sizeof(buf), "\\u%04x", (int)uc);
-              os << buf;
-            }
+          if (uc <= 0xffff)
+            bxo_append_hexesc(buf, "\\u", uc, 4);
           else
-            {
-              char buf[16];
-              snprintf(buf, sizeof(buf), "\\U%08x", (int)uc);
-              os << buf;
-            }
+            bxo_append_hexesc(buf, "\\U", uc, 8);
         }
     }
+} // end bxo_utf8_escape
+
+void
+BxoUtf8Out::out(std::ostream&os) const
+{
+  std::string buf;
+  bxo_utf8_escape(buf, _str.data(), _str.size(), _flags);
+  os.write(buf.data(), buf.size());
 } // end of BxoUtf8Out::out
 
 
 
+static const char bxo_base64_digits[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::string
+bxo_base64_encode(const void*data, size_t len)
+{
+  const unsigned char*p = (const unsigned char*)data;
+  std::string res;
+  res.reserve(4*((len+2)/3));
+  size_t ix = 0;
+  for (; ix+3 <= len; ix += 3)
+    {
+      uint32_t w = (p[ix] << 16) | (p[ix+1] << 8) | p[ix+2];
+      res.push_back(bxo_base64_digits[(w >> 18) & 0x3f]);
+      res.push_back(bxo_base64_digits[(w >> 12) & 0x3f]);
+      res.push_back(bxo_base64_digits[(w >> 6) & 0x3f]);
+      res.push_back(bxo_base64_digits[w & 0x3f]);
+    }
+  if (ix < len)
+    {
+      uint32_t w = p[ix] << 16;
+      if (ix+1 < len)
+        w |= p[ix+1] << 8;
+      res.push_back(bxo_base64_digits[(w >> 18) & 0x3f]);
+      res.push_back(bxo_base64_digits[(w >> 12) & 0x3f]);
+      res.push_back((ix+1 < len) ? bxo_base64_digits[(w >> 6) & 0x3f] : '=');
+      res.push_back('=');
+    }
+  return res;
+} // end bxo_base64_encode
+
+bool
+bxo_base64_decode(const std::string&str, std::string&out)
+{
+  // built once by the first caller; several load jobs may decode at once
+  struct DigitTable
+  {
+    signed char dt_val[256];
+  };
+  static const DigitTable digtab = []()
+  {
+    DigitTable dt;
+    memset(dt.dt_val, -1, sizeof(dt.dt_val));
+    for (int dx=0; dx<64; dx++)
+      dt.dt_val[(unsigned char)bxo_base64_digits[dx]] = dx;
+    return dt;
+  }();
+  const signed char* digval = digtab.dt_val;
+  size_t len = str.size();
+  out.clear();
+  if (len % 4 != 0)
+    return false;
+  out.reserve(3*(len/4));
+  for (size_t ix=0; ix<len; ix += 4)
+    {
+      int d0 = digval[(unsigned char)str[ix]];
+      int d1 = digval[(unsigned char)str[ix+1]];
+      bool last = (ix+4 == len);
+      int nbpad = last ? ((str[ix+3]=='=') + (str[ix+2]=='=')) : 0;
+      int d2 = (nbpad>=2) ? 0 : digval[(unsigned char)str[ix+2]];
+      int d3 = (nbpad>=1) ? 0 : digval[(unsigned char)str[ix+3]];
+      if (d0<0 || d1<0 || d2<0 || d3<0)
+        return false;
+      uint32_t w = (d0 << 18) | (d1 << 12) | (d2 << 6) | d3;
+      out.push_back((char)(w >> 16));
+      if (nbpad < 2)
+        out.push_back((char)(w >> 8));
+      if (nbpad < 1)
+        out.push_back((char)w);
+    }
+  return true;
+} // end bxo_base64_decode
+
+
+
+//// reductions of packed arrays; the portable and SSE2 variants
+//// accumulate in the same four lanes, so give the same doubles
+static int64_t BXO_OPTIMIZEDFUN
+bxo_packed_sum(const int64_t*arr, unsigned len)
+{
+  uint64_t acc[4] = {0, 0, 0, 0};
+  unsigned ix = 0;
+#ifdef __SSE2__
+  __m128i a01 = _mm_setzero_si128();
+  __m128i a23 = _mm_setzero_si128();
+  for (; ix+4 <= len; ix += 4)
+    {
+      a01 = _mm_add_epi64(a01, _mm_loadu_si128((const __m128i*)(arr+ix)));
+      a23 = _mm_add_epi64(a23, _mm_loadu_si128((const __m128i*)(arr+ix+2)));
+    }
+  _mm_storeu_si128((__m128i*)acc, a01);
+  _mm_storeu_si128((__m128i*)(acc+2), a23);
+#else
+  for (; ix+4 <= len; ix += 4)
+    for (int lx=0; lx<4; lx++)
+      acc[lx] += (uint64_t)arr[ix+lx];
+#endif /*__SSE2__*/
+  for (; ix < len; ix++)
+    acc[0] += (uint64_t)arr[ix];
+  return (int64_t)((acc[0]+acc[1]) + (acc[2]+acc[3]));
+} // end bxo_packed_sum int64_t
+
+static double BXO_OPTIMIZEDFUN
+bxo_packed_sum(const double*arr, unsigned len)
+{
+  double acc[4] = {0.0, 0.0, 0.0, 0.0};
+  unsigned ix = 0;
+#ifdef __SSE2__
+  __m128d a01 = _mm_setzero_pd();
+  __m128d a23 = _mm_setzero_pd();
+  for (; ix+4 <= len; ix += 4)
+    {
+      a01 = _mm_add_pd(a01, _mm_loadu_pd(arr+ix));
+      a23 = _mm_add_pd(a23, _mm_loadu_pd(arr+ix+2));
+    }
+  _mm_storeu_pd(acc, a01);
+  _mm_storeu_pd(acc+2, a23);
+#else
+  for (; ix+4 <= len; ix += 4)
+    for (int lx=0; lx<4; lx++)
+      acc[lx] += arr[ix+lx];
+#endif /*__SSE2__*/
+  for (; ix < len; ix++)
+    acc[0] += arr[ix];
+  return (acc[0]+acc[1]) + (acc[2]+acc[3]);
+} // end bxo_packed_sum double
+
+/// SSE2 has no 64 bits integer comparison, so int64_t extrema use
+/// four independent scalar lanes
+template <bool Max> static int64_t BXO_OPTIMIZEDFUN
+bxo_packed_extremum(const int64_t*arr, unsigned len)
+{
+  if (len == 0)
+    return 0;
+  int64_t acc[4] = {arr[0], arr[0], arr[0], arr[0]};
+  unsigned ix = 0;
+  for (; ix+4 <= len; ix += 4)
+    for (int lx=0; lx<4; lx++)
+      {
+        int64_t x = arr[ix+lx];
+        acc[lx] = (Max ? (x > acc[lx]) : (x < acc[lx])) ? x : acc[lx];
+      }
+  for (; ix < len; ix++)
+    acc[0] = (Max ? (arr[ix] > acc[0]) : (arr[ix] < acc[0])) ? arr[ix] : acc[0];
+  for (int lx=1; lx<4; lx++)
+    acc[0] = (Max ? (acc[lx] > acc[0]) : (acc[lx] < acc[0])) ? acc[lx] : acc[0];
+  return acc[0];
+} // end bxo_packed_extremum int64_t
+
+template <bool Max> static double BXO_OPTIMIZEDFUN
+bxo_packed_extremum(const double*arr, unsigned len)
+{
+  if (len == 0)
+    return 0.0;
+  double acc[4] = {arr[0], arr[0], arr[0], arr[0]};
+  unsigned ix = 0;
+#ifdef __SSE2__
+  // _mm_min_pd(x,a) is x<a?x:a, like the scalar code
+  __m128d a01 = _mm_set1_pd(arr[0]);
+  __m128d a23 = a01;
+  for (; ix+4 <= len; ix += 4)
+    {
+      __m128d x01 = _mm_loadu_pd(arr+ix);
+      __m128d x23 = _mm_loadu_pd(arr+ix+2);
+      a01 = Max ? _mm_max_pd(x01, a01) : _mm_min_pd(x01, a01);
+      a23 = Max ? _mm_max_pd(x23, a23) : _mm_min_pd(x23, a23);
+    }
+  _mm_storeu_pd(acc, a01);
+  _mm_storeu_pd(acc+2, a23);
+#else
+  for (; ix+4 <= len; ix += 4)
+    for (int lx=0; lx<4; lx++)
+      {
+        double x = arr[ix+lx];
+        acc[lx] = (Max ? (x > acc[lx]) : (x < acc[lx])) ? x : acc[lx];
+      }
+#endif /*__SSE2__*/
+  for (; ix < len; ix++)
+    acc[0] = (Max ? (arr[ix] > acc[0]) : (arr[ix] < acc[0])) ? arr[ix] : acc[0];
+  for (int lx=1; lx<4; lx++)
+    acc[0] = (Max ? (acc[lx] > acc[0]) : (acc[lx] < acc[0])) ? acc[lx] : acc[0];
+  return acc[0];
+} // end bxo_packed_extremum double
+
+static inline int64_t
+bxo_packed_num_from_json(const BxoJson&jn, int64_t*)
+{
+  if (!jn.isInt64())
+    {
+      BXO_BACKTRACELOG("bad intvec element " << jn);
+      throw std::runtime_error("bad intvec element in JSON");
+    }
+  return jn.asInt64();
+} // end bxo_packed_num_from_json int64_t
+
+static inline double
+bxo_packed_num_from_json(const BxoJson&jn, double*)
+{
+  if (!jn.isNumeric())
+    {
+      BXO_BACKTRACELOG("bad dblvec element " << jn);
+      throw std::runtime_error("bad dblvec element in JSON");
+    }
+  return jn.asDouble();
+} // end bxo_packed_num_from_json double
+
+template <typename NumT> const char*
+BxoPackedArray<NumT>::json_key(void)
+{
+  return std::is_same<NumT,int64_t>::value ? "intvec" : "dblvec";
+} // end BxoPackedArray::json_key
+
+template <typename NumT> const BxoPackedArray<NumT>*
+BxoPackedArray<NumT>::make_packed(const NumT*arr, unsigned len)
+{
+  if (BXO_UNLIKELY(len > BXO_SIZE_MAX || (len > 0 && !arr)))
+    {
+      BXO_BACKTRACELOG("make_packed: bad " << json_key() << " of length " << len);
+      throw std::runtime_error("BxoPackedArray::make_packed bad array");
+    }
+  std::unique_ptr<NumT[]> copy {new NumT[len]};
+  for (unsigned ix=0; ix<len; ix++)
+    {
+      NumT x = arr[ix];
+      if (BXO_UNLIKELY(x != x))	// only a NaN differs from itself
+        {
+          BXO_BACKTRACELOG("make_packed: NaN at index " << ix);
+          throw std::runtime_error("BxoPackedArray::make_packed NaN");
+        }
+      copy[ix] = x;
+    }
+  auto h = BxoString::hash_bytes_v2((const char*)copy.get(), (size_t)len*sizeof(NumT));
+  return new BxoPackedArray(h, len, std::move(copy));
+} // end BxoPackedArray::make_packed
+
+template <typename NumT> NumT
+BxoPackedArray<NumT>::sum(void) const
+{
+  return bxo_packed_sum(_arr.get(), _len);
+} // end BxoPackedArray::sum
+
+template <typename NumT> NumT
+BxoPackedArray<NumT>::min(void) const
+{
+  return bxo_packed_extremum<false>(_arr.get(), _len);
+} // end BxoPackedArray::min
+
+template <typename NumT> NumT
+BxoPackedArray<NumT>::max(void) const
+{
+  return bxo_packed_extremum<true>(_arr.get(), _len);
+} // end BxoPackedArray::max
+
+template <typename NumT> BxoJson
+BxoPackedArray<NumT>::packed_to_json(void) const
+{
+  if (_len <= BXO_PACKED_JSON_ARRAY_MAX)
+    {
+      BxoJson jarr(Json::arrayValue);
+      jarr.resize(_len);
+      for (unsigned ix=0; ix<_len; ix++)
+        jarr[ix] = BxoJson(_arr[ix]);
+      return jarr;
+    }
+  return BxoJson(packed_base64());
+} // end BxoPackedArray::packed_to_json
+
+static inline void
+bxo_put_json_number(BxoJsonWriter&jw, int64_t i)
+{
+  jw.put_int(i);
+}
+
+static inline void
+bxo_put_json_number(BxoJsonWriter&jw, double d)
+{
+  jw.put_double(d);
+}
+
+template <typename NumT> void
+BxoPackedArray<NumT>::packed_write_json(BxoJsonWriter&jw) const
+{
+  if (_len <= BXO_PACKED_JSON_ARRAY_MAX)
+    {
+      jw.begin_array();
+      for (unsigned ix=0; ix<_len; ix++)
+        bxo_put_json_number(jw, _arr[ix]);
+      jw.end_array();
+      return;
+    }
+  jw.put_string(packed_base64());
+} // end BxoPackedArray::packed_write_json
+
+template <typename NumT> std::string
+BxoPackedArray<NumT>::packed_base64(void) const
+{
+  std::string bytes(_len*sizeof(NumT), '\0');
+  for (unsigned ix=0; ix<_len; ix++)
+    {
+      uint64_t w = 0;
+      memcpy(&w, &_arr[ix], sizeof(w));
+      for (int bx=0; bx<8; bx++)
+        bytes[8*ix+bx] = (char)(w >> (8*bx));
+    }
+  return bxo_base64_encode(bytes.data(), bytes.size());
+} // end BxoPackedArray::packed_base64
+
+template <typename NumT> const BxoPackedArray<NumT>*
+BxoPackedArray<NumT>::load_packed(const BxoJson&js)
+{
+  std::vector<NumT> vec;
+  if (js.isArray())
+    {
+      unsigned len = js.size();
+      vec.reserve(len);
+      for (unsigned ix=0; ix<len; ix++)
+        vec.push_back(bxo_packed_num_from_json(js[ix], (NumT*)nullptr));
+    }
+  else if (js.isString())
+    {
+      std::string bytes;
+      if (!bxo_base64_decode(js.asString(), bytes) || bytes.size() % 8 != 0)
+        {
+          BXO_BACKTRACELOG("load_packed: bad base64 " << json_key());
+          throw std::runtime_error("BxoPackedArray::load_packed bad base64");
+        }
+      unsigned len = bytes.size() / 8;
+      vec.resize(len);
+      for (unsigned ix=0; ix<len; ix++)
+        {
+          uint64_t w = 0;
+          for (int bx=0; bx<8; bx++)
+            w |= (uint64_t)(unsigned char)bytes[8*ix+bx] << (8*bx);
+          memcpy(&vec[ix], &w, sizeof(w));
+        }
+    }
+  else
+    return nullptr;
+  return make_packed(vec);
+} // end BxoPackedArray::load_packed
+
+template <typename NumT> void
+BxoPackedArray<NumT>::out(std::ostream&os) const
+{
+  constexpr unsigned maxshown = 16;
+  os << json_key() << "#" << _len << "(";
+  for (unsigned ix=0; ix<_len && ix<maxshown; ix++)
+    {
+      if (ix>0) os << ' ';
+      os << _arr[ix];
+    }
+  if (_len > maxshown)
+    os << " ...";
+  os << ")";
+} // end BxoPackedArray::out
+
+template class BxoPackedArray<int64_t>;
+template class BxoPackedArray<double>;
+
+
+
+const BxoBlob*
+BxoBlob::make_blob(const void*data, size_t sz)
+{
+  if (BXO_UNLIKELY(!data && sz>0))
+    {
+      BXO_BACKTRACELOG("make_blob: null data of size " << sz);
+      throw std::runtime_error("BxoBlob::make_blob null data");
+    }
+  std::unique_ptr<char[]> mem(new char[sz?sz:1]);
+  if (sz>0)
+    memcpy(mem.get(), data, sz);
+  auto h = BxoString::hash_bytes_v2(mem.get(), sz);
+  return new BxoBlob(h, sz, std::move(mem));
+} // end BxoBlob::make_blob
+
+
+const BxoBlob*
+BxoBlob::map_blob(const std::string&path, size_t sz, BxoHash_t h)
+{
+  if (BXO_UNLIKELY(path.empty() || h == 0))
+    {
+      BXO_BACKTRACELOG("map_blob: bad path '" << path << "' or hash " << h);
+      throw std::runtime_error("BxoBlob::map_blob bad path or hash");
+    }
+  return new BxoBlob(h, sz, path);
+} // end BxoBlob::map_blob
+
+
+const BxoBlob*
+BxoBlob::load_blob(BxoJsonProcessor&bxj, const BxoJson&js)
+{
+  if (js.isMember("blob64"))
+    {
+      std::string bytes;
+      if (!js["blob64"].isString() || !bxo_base64_decode(js["blob64"].asString(), bytes))
+        {
+          BXO_BACKTRACELOG("load_blob: bad blob64 " << js);
+          throw std::runtime_error("BxoBlob::load_blob bad blob64");
+        }
+      return make_blob(bytes.data(), bytes.size());
+    }
+  const auto& jnam = js["blob"];
+  const auto& jsiz = js["size"];
+  const auto& jhash = js["hash"];
+  if (!jnam.isString() || !jsiz.isUInt64() || !jhash.isUInt())
+    {
+      BXO_BACKTRACELOG("load_blob: bad blob " << js);
+      throw std::runtime_error("BxoBlob::load_blob bad blob");
+    }
+  std::string filnam = jnam.asString();
+  if (filnam.compare(0, strlen(BXO_BLOB_FILE_PREFIX), BXO_BLOB_FILE_PREFIX)
+      || filnam.find('/') != std::string::npos)
+    {
+      BXO_BACKTRACELOG("load_blob: bad blob file name " << filnam);
+      throw std::runtime_error("BxoBlob::load_blob bad blob file name");
+    }
+  // the side file is not even opened here, but at first access
+  return map_blob(bxj.side_file_path(filnam), (size_t)jsiz.asUInt64(),
+                  (BxoHash_t)jhash.asUInt());
+} // end BxoBlob::load_blob
+
+
+void
+BxoBlob::map_file(void) const
+{
+  BXO_ASSERT(!_path.empty() && _size > 0, "map_file: no side file to map");
+  int fd = open(_path.c_str(), O_RDONLY|O_CLOEXEC);
+  if (fd < 0)
+    {
+      BXO_BACKTRACELOG("map_file: failed to open " << _path << " : " << strerror(errno));
+      throw std::runtime_error("BxoBlob::map_file open failure");
+    }
+  struct stat st;
+  memset (&st, 0, sizeof(st));
+  if (fstat(fd, &st) || (size_t)st.st_size != _size)
+    {
+      BXO_BACKTRACELOG("map_file: " << _path << " has size " << (long long)st.st_size
+                       << " but blob has size " << _size);
+      close(fd);
+      throw std::runtime_error("BxoBlob::map_file bad size");
+    }
+  void*ad = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ad == MAP_FAILED)
+    {
+      BXO_BACKTRACELOG("map_file: failed to mmap " << _path << " : " << strerror(errno));
+      throw std::runtime_error("BxoBlob::map_file mmap failure");
+    }
+  _map = (const char*)ad;
+  BXO_VERBOSELOG("map_file mapped " << _path << " of " << _size << " bytes at " << ad);
+} // end BxoBlob::map_file
+
+
+BxoBlob::~BxoBlob()
+{
+  if (_map)
+    munmap((void*)_map, _size);
+  _map = nullptr;
+} // end BxoBlob::~BxoBlob
+
+
+std::string
+BxoBlob::file_name(unsigned variant) const
+{
+  char nambuf[80];
+  memset (nambuf, 0, sizeof(nambuf));
+  if (variant == 0)
+    snprintf(nambuf, sizeof(nambuf), BXO_BLOB_FILE_PREFIX "%zx_%08x" BXO_BLOB_FILE_SUFFIX,
+             _size, (unsigned)_hash);
+  else
+    snprintf(nambuf, sizeof(nambuf), BXO_BLOB_FILE_PREFIX "%zx_%08x_v%u" BXO_BLOB_FILE_SUFFIX,
+             _size, (unsigned)_hash, variant);
+  return std::string {nambuf};
+} // end BxoBlob::file_name
+
+
+/// blobs are ordered by size, then hash, and only then by their bytes,
+/// so comparing usually does not map them
+bool
+BxoBlob::less_than_blob(const BxoBlob&r) const
+{
+  if (_size != r._size) return _size < r._size;
+  if (_hash != r._hash) return _hash < r._hash;
+  if (this == &r || (!_path.empty() && _path == r._path)) return false;
+  return memcmp(data(), r.data(), _size) < 0;
+} // end BxoBlob::less_than_blob
+
+
+BxoJson
+BxoBlob::blob_to_json(BxoDumper&du) const
+{
+  BxoJson job(Json::objectValue);
+  if (_size <= BXO_BLOB_INLINE_MAX)
+    {
+      job["blob64"] = bxo_base64_encode(data(), _size);
+      return job;
+    }
+  job["blob"] = du.emit_blob(*this);
+  job["size"] = (Json::UInt64)_size;
+  job["hash"] = (Json::UInt)_hash;
+  return job;
+} // end BxoBlob::blob_to_json
+
+void
+BxoBlob::blob_write_json(BxoJsonWriter&jw) const
+{
+  jw.begin_object();
+  if (_size <= BXO_BLOB_INLINE_MAX)
+    {
+      jw.key("blob64");
+      jw.put_string(bxo_base64_encode(data(), _size));
+      jw.end_object();
+      return;
+    }
+  BXO_ASSERT(jw.dumper() != nullptr, "blob_write_json without dumper");
+  jw.key("blob");
+  jw.put_string(jw.dumper()->emit_blob(*this));
+  jw.key("hash");
+  jw.put_uint(_hash);
+  jw.key("size");
+  jw.put_uint(_size);
+  jw.end_object();
+} // end BxoBlob::blob_write_json
+
+
+void
+BxoBlob::out(std::ostream&os) const
+{
+  os << "<blob " << _size << " bytes #" << _hash;
+  if (!_path.empty())
+    os << " in " << _path;
+  os << ">";
+} // end BxoBlob::out
+
+
+
 /// only for debugging
 void
 BxoVal::out(std::ostream&os) const
@@ -509,8 +1876,21 @@ BxoVal::out(std::ostream&os) const
       os << _int;
       break;
     case BxoVKind::StringK:
-      os << '"'<< BxoUtf8Out(_str->string()) << '"';
-      break;
+    {
+      const std::string&str = _str->string();
+      if (!bxo_utf8_valid(str.data(), str.size()))
+        {
+          BXO_BACKTRACELOG("BxoVal::out invalid str=" << str);
+          throw std::runtime_error("BxoVal::out invalid string");
+        }
+      std::string buf;
+      buf.reserve(str.size()+2);
+      buf.push_back('"');
+      bxo_utf8_escape(buf, str.data(), str.size());
+      buf.push_back('"');
+      os.write(buf.data(), buf.size());
+    }
+    break;
     case BxoVKind::ObjectK:
       os << _obj->pname();
       break;
@@ -528,5 +1908,20 @@ BxoVal::out(std::ostream&os) const
       os << "}";
     }
     break;
+    case BxoVKind::IntVecK:
+      _ivec->out(os);
+      break;
+    case BxoVKind::DoubleVecK:
+      _dvec->out(os);
+      break;
+    case BxoVKind::BlobK:
+      _blob->out(os);
+      break;
+    case BxoVKind::RopeK:
+      _rope->out(os);
+      break;
+    case BxoVKind::MapK:
+      _omap->out(os);
+      break;
     }
 } // end of BxoVal::out